@@ -0,0 +1,110 @@
+#include "caster_grid.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Slot of grid coordinates x, z, wrapped into the grid
+static inline caster_cell_t *get_slot(const caster_grid_t *grid, int x, int z) {
+  int sx = ((x % grid->dim) + grid->dim) % grid->dim;
+  int sz = ((z % grid->dim) + grid->dim) % grid->dim;
+  return &grid->cells[sz * grid->dim + sx];
+}
+
+int init_caster_grid(caster_grid_t *grid, float cell_size, int dim) {
+  assert(grid != NULL);
+  assert(cell_size > 0.0f && dim > 0);
+
+  grid->cells = calloc((usize)(dim * dim), sizeof(caster_cell_t));
+  grid->dim = grid->cells ? dim : 0;
+  grid->cell_size = cell_size;
+  grid->inv_cell_size = 1.0f / cell_size;
+
+  return grid->cells ? 0 : -1;
+}
+
+void free_caster_grid(caster_grid_t *grid) {
+  if (!grid) return;
+
+  for (int i = 0; i < grid->dim * grid->dim; ++i) free(grid->cells[i].casters);
+
+  free(grid->cells);
+  grid->cells = NULL;
+  grid->dim = 0;
+}
+
+bool add_shadow_caster(caster_grid_t *grid, int owner_x, int owner_z, float x, float z, float radius) {
+  assert(grid != NULL && grid->cells != NULL);
+  assert(radius < grid->cell_size);
+  assert((int)floorf(x * grid->inv_cell_size) == owner_x && (int)floorf(z * grid->inv_cell_size) == owner_z);
+
+  shadow_caster_t caster = { .x = x, .z = z, .radius_sq = radius * radius, .owner_x = owner_x, .owner_z = owner_z };
+
+  // Every cell the disc's bounding square touches, at most four
+  int min_x = (int)floorf((x - radius) * grid->inv_cell_size), max_x = (int)floorf((x + radius) * grid->inv_cell_size);
+  int min_z = (int)floorf((z - radius) * grid->inv_cell_size), max_z = (int)floorf((z + radius) * grid->inv_cell_size);
+
+  for (int cz = min_z; cz <= max_z; ++cz) {
+    for (int cx = min_x; cx <= max_x; ++cx) {
+      caster_cell_t *cell = get_slot(grid, cx, cz);
+
+      if (!cell->used || cell->x != cx || cell->z != cz) {
+        cell->x = cx;
+        cell->z = cz;
+        cell->used = true;
+        cell->count = 0;
+      }
+
+      if (cell->count == cell->capacity) {
+        usize capacity = cell->capacity ? cell->capacity * 2 : 8;
+        shadow_caster_t *casters = realloc(cell->casters, capacity * sizeof(shadow_caster_t));
+        if (!casters) return false;
+
+        cell->casters = casters;
+        cell->capacity = capacity;
+      }
+
+      cell->casters[cell->count++] = caster;
+    }
+  }
+
+  return true;
+}
+
+void remove_shadow_casters(caster_grid_t *grid, int owner_x, int owner_z) {
+  assert(grid != NULL);
+  if (!grid->cells) return;
+
+  // Casters lie in their owner's cell and reach at most one cell past it
+  for (int cz = owner_z - 1; cz <= owner_z + 1; ++cz) {
+    for (int cx = owner_x - 1; cx <= owner_x + 1; ++cx) {
+      caster_cell_t *cell = get_slot(grid, cx, cz);
+      if (!cell->used || cell->x != cx || cell->z != cz) continue;
+
+      usize kept = 0;
+      for (usize i = 0; i < cell->count; ++i) {
+        const shadow_caster_t *caster = &cell->casters[i];
+        if (caster->owner_x != owner_x || caster->owner_z != owner_z) cell->casters[kept++] = *caster;
+      }
+      cell->count = kept;
+    }
+  }
+}
+
+bool point_in_caster_shadow(const caster_grid_t *grid, float x, float z) {
+  if (!grid->cells) return false;
+
+  int cx = (int)floorf(x * grid->inv_cell_size);
+  int cz = (int)floorf(z * grid->inv_cell_size);
+
+  const caster_cell_t *cell = get_slot(grid, cx, cz);
+  if (!cell->used || cell->x != cx || cell->z != cz) return false;
+
+  for (usize i = 0; i < cell->count; ++i) {
+    float dx = x - cell->casters[i].x;
+    float dz = z - cell->casters[i].z;
+    if (dx * dx + dz * dz < cell->casters[i].radius_sq) return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,49 @@
+#ifndef __CASTER_GRID_H__
+#define __CASTER_GRID_H__
+
+#include <stdbool.h>
+
+#include <shader-works/maths.h>
+
+// Disc shadow cast straight down onto the ground, registered by the chunk that owns it
+typedef struct {
+  float x, z;
+  float radius_sq;
+  int owner_x, owner_z;
+} shadow_caster_t;
+
+typedef struct {
+  int x, z;                   // grid coordinates this cell currently holds
+  bool used;
+  shadow_caster_t *casters;   // every caster whose disc overlaps the cell
+  usize count, capacity;
+} caster_cell_t;
+
+// Uniform grid of shadow casters over the ground around the viewer, one cell per chunk
+// Cells wrap around, so the grid only needs to span the loaded chunks and a border of one cell; a cell reused for
+// new coordinates drops the casters of the ones it held before
+// A caster is stored in every cell its disc touches, so a point query reads a single cell
+typedef struct {
+  caster_cell_t *cells;
+  int dim;                    // cells along each side
+  float cell_size, inv_cell_size;
+} caster_grid_t;
+
+// cell_size: world units along each cell's side, cells line up with the chunk grid when this is the chunk size
+// dim: cells along each side, at least the number of loaded chunks across plus 2
+// Returns 0 on success, -1 on allocation failure
+int init_caster_grid(caster_grid_t *grid, float cell_size, int dim);
+void free_caster_grid(caster_grid_t *grid);
+
+// Register a disc of radius at x, z owned by chunk owner_x, owner_z
+// The centre must lie in cell owner_x, owner_z and radius must be below cell_size
+// Returns false if a cell could not grow to hold it
+bool add_shadow_caster(caster_grid_t *grid, int owner_x, int owner_z, float x, float z, float radius);
+
+// Drop every caster owned by chunk owner_x, owner_z
+void remove_shadow_casters(caster_grid_t *grid, int owner_x, int owner_z);
+
+// Whether x, z lies under any registered caster
+bool point_in_caster_shadow(const caster_grid_t *grid, float x, float z);
+
+#endif // __CASTER_GRID_H__
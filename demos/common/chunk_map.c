@@ -2,139 +2,196 @@
 
 #include <stdlib.h>
 
-static inline usize get_chunk_hash(int x, int z, usize table_size) {
-  return ((x * 73856093) ^ (z * 19349663)) % table_size;
-}
+// smallest table, keeps the probe loops from ever seeing a full table
+#define CHUNK_MAP_MIN_CAPACITY 8
 
-void free_chunk_node(chunk_map_node_t *node) {
-  if (!node) return;
+static inline usize get_chunk_hash(int x, int z) {
+  // neighbouring coordinates must land far apart, the table is indexed by the low bits
+  u32 h = ((u32)x * 0x9E3779B1u) ^ ((u32)z * 0x85EBCA77u);
+  return h ^ (h >> 16);
+}
 
-  delete_model(&node->chunk.ground_plane);
+// slot holding x, z, or the empty slot where it would be inserted
+static usize find_slot(const chunk_map_t *map, int x, int z) {
+  usize mask = map->capacity - 1;
+  usize i = get_chunk_hash(x, z) & mask;
 
-  for (usize i = 0; i < node->chunk.num_trees; ++i) {
-    delete_model(&node->chunk.trees[i]);
+  while (map->keys[i].used && (map->keys[i].x != x || map->keys[i].z != z)) {
+    i = (i + 1) & mask;
   }
 
-  // Free the trees array itself
-  if (node->chunk.trees) {
-    free(node->chunk.trees);
+  return i;
+}
+
+static int alloc_slots(chunk_map_t *map, usize capacity) {
+  map->keys = calloc(capacity, sizeof(chunk_map_key_t));
+  map->nodes = malloc(capacity * sizeof(chunk_map_node_t));
+  if (!map->keys || !map->nodes) {
+    free(map->keys);
+    free(map->nodes);
+    map->keys = NULL;
+    map->nodes = NULL;
+    map->capacity = 0;
+    return -1;
   }
 
-  free(node);
+  map->capacity = capacity;
+  return 0;
 }
 
-void init_chunk_map(chunk_map_t *map, usize num_buckets) {
-  if (!map) return;
+// rehash into a table twice the size, the old table is kept if allocation fails
+static int grow_chunk_map(chunk_map_t *map) {
+  chunk_map_t old = *map;
+  if (alloc_slots(map, old.capacity * 2) != 0) {
+    *map = old;
+    return -1;
+  }
 
-  map->num_buckets = num_buckets;
-  map->buckets = calloc(num_buckets, sizeof(chunk_map_node_t *));
+  for (usize i = 0; i < old.capacity; ++i) {
+    if (!old.keys[i].used) continue;
 
-  map->num_loaded_chunks = 0;
-}
+    usize slot = find_slot(map, old.keys[i].x, old.keys[i].z);
+    map->keys[slot] = old.keys[i];
+    map->nodes[slot] = old.nodes[i];
+  }
 
-void free_chunk_map(chunk_map_t *map) {
-  if (!map) return;
+  free(old.keys);
+  free(old.nodes);
+  return 0;
+}
 
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *head = map->buckets[i];
+// frees the chunk in slot hole and shifts later entries of its probe run back over it,
+// so lookups never need tombstones to step over removed entries
+static void remove_slot(chunk_map_t *map, usize hole) {
+  free_chunk(&map->nodes[hole].chunk);
 
-    while (head) {
-      chunk_map_node_t *next = head->next;
-      free_chunk_node(head);
+  usize mask = map->capacity - 1;
+  for (usize i = (hole + 1) & mask; map->keys[i].used; i = (i + 1) & mask) {
+    usize home = get_chunk_hash(map->keys[i].x, map->keys[i].z) & mask;
 
-      head = next;
+    // an entry may only move back if the hole is not before its home slot
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      map->keys[hole] = map->keys[i];
+      map->nodes[hole] = map->nodes[i];
+      hole = i;
     }
   }
 
-  free(map->buckets);
-  map->buckets = NULL;
-  map->num_loaded_chunks = 0;
+  map->keys[hole].used = false;
+  --map->num_loaded_chunks;
 }
 
-void insert_chunk(chunk_map_t *map, chunk_t *chunk) {
-  if (!map || !chunk) return;
+// frees the models a chunk owns and hands its memory block back, the chunk itself is left empty
+void free_chunk(chunk_t *chunk) {
+  if (!chunk) return;
 
-  usize index = get_chunk_hash(chunk->x, chunk->z, map->num_buckets);
+  delete_model(&chunk->ground_plane);
+  free_heightfield(&chunk->heightfield);
 
-  chunk_map_node_t *old_head = map->buckets[index];
+  for (usize i = 0; i < chunk->num_trees; ++i) {
+    delete_model(&chunk->trees[i]);
+  }
 
-  // emplace new chunk at start of list, no reason to iterate to the end to add
-  chunk_map_node_t *head = malloc(sizeof(chunk_map_node_t));
-  head->chunk = *chunk;
-  head->loaded = true;
-  head->next = old_head;
+  for (usize i = 0; i < chunk->num_static_objs; ++i) {
+    delete_model(&chunk->static_objs[i]);
+  }
 
-  map->buckets[index] = head;
-  ++map->num_loaded_chunks;
-}
+  // Free the arrays themselves
+  if (!arena_contains(chunk->arena, chunk->trees)) free(chunk->trees);
+  if (!arena_contains(chunk->arena, chunk->static_objs)) free(chunk->static_objs);
 
-void remove_chunk(chunk_map_t *map, int x, int z) {
-  if (!map) return;
+  chunk->trees = chunk->static_objs = NULL;
+  chunk->num_trees = chunk->num_static_objs = 0;
 
-  usize index = get_chunk_hash(x, z, map->num_buckets);
-  chunk_map_node_t *head = map->buckets[index], *prev = NULL;
+  // Everything carved from the arena goes back in one piece
+  if (chunk->memory_pool) pool_free(chunk->memory_pool, chunk->arena);
+  chunk->arena = NULL;
+  chunk->memory_pool = NULL;
+}
 
-  while (head) {
-    if (head->chunk.x == x && head->chunk.z == z) {
-      if (prev == NULL) {
-        map->buckets[index] = head->next;
-      } else {
-        prev->next = head->next;
-      }
+int init_chunk_map(chunk_map_t *map, usize initial_capacity) {
+  if (!map) return -1;
 
-      free_chunk_node(head);
-      --map->num_loaded_chunks;
-      return;
-    }
+  usize capacity = CHUNK_MAP_MIN_CAPACITY;
+  while (capacity < initial_capacity) capacity *= 2;
 
-    prev = head;
-    head = head->next;
-  }
+  map->num_loaded_chunks = 0;
+  return alloc_slots(map, capacity);
 }
 
-void remove_chunk_if(chunk_map_t *map, query_func func, void *param, usize num_params) {
+void free_chunk_map(chunk_map_t *map) {
   if (!map) return;
 
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *head = map->buckets[i], *prev = NULL;
+  for (usize i = 0; i < map->capacity; ++i) {
+    if (map->keys[i].used) free_chunk(&map->nodes[i].chunk);
+  }
 
-    while (head) {
-      chunk_map_node_t *next = head->next; // Store next before potential free
+  free(map->keys);
+  free(map->nodes);
+  map->keys = NULL;
+  map->nodes = NULL;
+  map->capacity = 0;
+  map->num_loaded_chunks = 0;
+}
 
-      if (func(&head->chunk, param, num_params)) {
-        if (prev == NULL) {
-          map->buckets[i] = next;
-        } else {
-          prev->next = next;
-        }
+chunk_map_node_t *insert_chunk(chunk_map_t *map, chunk_t *chunk) {
+  if (!map || !chunk || !map->keys) return NULL;
 
-        free_chunk_node(head);
-        --map->num_loaded_chunks;
+  // stay at most half full so probe runs, and misses in particular, stay short
+  if ((map->num_loaded_chunks + 1) * 2 > map->capacity && grow_chunk_map(map) != 0) return NULL;
 
-        // Continue with next node instead of returning
-        head = next;
-      } else {
-        prev = head;
-        head = next;
-      }
-    }
+  usize slot = find_slot(map, chunk->x, chunk->z);
+  if (map->keys[slot].used) {
+    free_chunk(&map->nodes[slot].chunk);
+  } else {
+    map->keys[slot] = (chunk_map_key_t){ .x = chunk->x, .z = chunk->z, .used = true };
+    ++map->num_loaded_chunks;
   }
+
+  map->nodes[slot] = (chunk_map_node_t){ .chunk = *chunk, .loaded = true };
+  return &map->nodes[slot];
 }
 
-chunk_map_node_t *chunk_lookup(chunk_map_t *map, int x, int z) {
-  if (!map) return NULL;
+chunk_map_node_t *reserve_chunk(chunk_map_t *map, int x, int z) {
+  chunk_t empty = { .x = x, .z = z, .bvh_proxy = -1 };
 
-  usize index = get_chunk_hash(x, z, map->num_buckets);
-  chunk_map_node_t *head = map->buckets[index];
+  chunk_map_node_t *node = insert_chunk(map, &empty);
+  if (node) node->loaded = false;
+  return node;
+}
 
-  while (head) {
-    if (head->chunk.x == x && head->chunk.z == z)
-      return head;
+void remove_chunk(chunk_map_t *map, int x, int z) {
+  if (!map || !map->keys) return;
 
-    head = head->next;
+  usize slot = find_slot(map, x, z);
+  if (map->keys[slot].used) remove_slot(map, slot);
+}
+
+void remove_chunk_if(chunk_map_t *map, query_func func, void *param, usize num_params) {
+  if (!map || !map->keys) return;
+
+  // Walk from an empty slot so no probe run wraps past the start, then entries shifted back by a
+  // removal always land in the slot being visited and each chunk is tested exactly once
+  usize mask = map->capacity - 1;
+  usize start = 0;
+  while (map->keys[start].used) ++start;
+
+  for (usize step = 0; step < map->capacity;) {
+    usize i = (start + step) & mask;
+
+    if (map->keys[i].used && func(&map->nodes[i].chunk, param, num_params)) {
+      remove_slot(map, i); // visit i again, it may hold a shifted entry now
+    } else {
+      ++step;
+    }
   }
+}
+
+chunk_map_node_t *chunk_lookup(chunk_map_t *map, int x, int z) {
+  if (!map || !map->keys) return NULL;
 
-  return NULL;
+  usize slot = find_slot(map, x, z);
+  return map->keys[slot].used ? &map->nodes[slot] : NULL;
 }
 
 bool is_chunk_loaded(chunk_map_t *map, int x, int z) {
@@ -156,14 +213,11 @@ void query_chunk_map(chunk_map_t *map, chunk_t **chunk_buf, usize *count, query_
   if (!map || !chunk_buf || !count) return;
 
   *count = 0;
-  for (usize i = 0; i < map->num_buckets; ++i) {
-    chunk_map_node_t *node = map->buckets[i];
-    while (node != NULL) {
-      if (node->loaded && func(&node->chunk, NULL, 0)) {
-        chunk_buf[*count] = &node->chunk;
-        (*count)++;
-      }
-      node = node->next;
+  for (usize i = 0; i < map->capacity; ++i) {
+    chunk_map_node_t *node = &map->nodes[i];
+    if (map->keys[i].used && node->loaded && func(&node->chunk, NULL, 0)) {
+      chunk_buf[*count] = &node->chunk;
+      (*count)++;
     }
   }
 }
@@ -2,36 +2,63 @@
 #define __CHUNK_MAP_H__
 
 #include <shader-works/primitives.h>
+#include <shader-works/memory.h>
 
-#define CHUNK_MAP_NUM_BUCKETS 9
+#include "heightfield.h"
+
+#define CHUNK_MAP_INITIAL_CAPACITY 64
 
 typedef struct {
   int x, z;
   model_t ground_plane;
+  usize ground_capacity;     // vertices ground_plane's buffers hold, kept across LOD changes
+  heightfield_t heightfield; // terrain under ground_plane, sampled once and shared by every LOD of it
   model_t *trees, *static_objs;
   usize num_trees, num_static_objs;
   int lod;
+  int pending_lod; // LOD a worker is generating to replace this chunk, 0 when none
+  int bvh_proxy;  // id in the owner's culling hierarchy, -1 when not registered
+
+  // Per chunk memory freed in one piece with the chunk, the arena sits at the front of a block from memory_pool
+  // Models and the heightfield point at it through their own arena fields, NULL when the chunk lives on the heap
+  arena_t *arena;
+  pool_t *memory_pool;
 } chunk_t;
 
-typedef struct chunk_map_node_t {
+typedef struct {
   chunk_t chunk;
-  struct chunk_map_node_t *next;
   bool loaded;
 } chunk_map_node_t;
 
+// slot key, probed on lookup and kept apart from the chunks so a probe stays within a few cache lines
+typedef struct {
+  int x, z;
+  bool used;
+} chunk_map_key_t;
+
+// open addressing table of chunks keyed by coordinate, linear probing with backward shift deletion
+// chunks are stored inline and move when the table grows or closes the gap left by a removal,
+// so node and chunk pointers are only valid until the next insert or remove
 typedef struct {
-  chunk_map_node_t **buckets;
-  usize num_buckets, num_loaded_chunks;
+  chunk_map_key_t *keys;
+  chunk_map_node_t *nodes;  // nodes[i] belongs to keys[i]
+  usize capacity;           // power of two, grown to keep at most half the slots used
+  usize num_loaded_chunks;
 } chunk_map_t;
 
 // return true to include chunk in final chunk buffer
 typedef bool (*query_func)(chunk_t *chunk, void *param, usize num_params);
 
-void init_chunk_map(chunk_map_t *map, usize num_buckets);
-void free_chunk_node(chunk_map_node_t *node);
+// returns 0 on success, -1 on allocation failure
+int init_chunk_map(chunk_map_t *map, usize initial_capacity);
+void free_chunk(chunk_t *chunk);
 void free_chunk_map(chunk_map_t *map);
 
-void insert_chunk(chunk_map_t *map, chunk_t *chunk);
+// stores a copy of chunk, replacing any chunk already at its coordinates
+// returns the stored node, or NULL if the table could not grow
+chunk_map_node_t *insert_chunk(chunk_map_t *map, chunk_t *chunk);
+// adds an empty, not yet loaded node for a chunk that is still being generated
+chunk_map_node_t *reserve_chunk(chunk_map_t *map, int x, int z);
 void remove_chunk(chunk_map_t *map, int x, int z);
 void remove_chunk_if(chunk_map_t *map, query_func, void *param, usize num_params);
 
@@ -0,0 +1,98 @@
+// Benchmark of chunk_map_t under the load tundra puts on it
+// A radius 4 square of chunks stays loaded around a player walking in a straight line, every tick
+// unloads the trailing row and reserves the leading one, and every frame each shaded ground pixel
+// looks up its own chunk and the 8 around it, as tundra's tree shadow test did before the caster grid
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "chunk_map.h"
+
+#define LOAD_RADIUS 4
+#define CHUNK_SIZE 10.0f
+#define NUM_TICKS 2000
+#define PIXELS_PER_FRAME (400 * 300)
+
+static int player_chunk_x, player_chunk_z;
+
+// Get current time in seconds
+static double get_time_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool outside_radius(chunk_t *chunk, void *param, usize num_params) {
+  (void)param; (void)num_params;
+  return abs(chunk->x - player_chunk_x) > LOAD_RADIUS || abs(chunk->z - player_chunk_z) > LOAD_RADIUS;
+}
+
+// Unload chunks behind the player and add the ones that came into range
+static void update_chunks(chunk_map_t *map) {
+  remove_chunk_if(map, outside_radius, NULL, 0);
+
+  for (int dx = -LOAD_RADIUS; dx <= LOAD_RADIUS; ++dx) {
+    for (int dz = -LOAD_RADIUS; dz <= LOAD_RADIUS; ++dz) {
+      int x = player_chunk_x + dx, z = player_chunk_z + dz;
+      if (chunk_lookup(map, x, z)) continue;
+
+      chunk_t chunk = { .x = x, .z = z, .lod = 1, .bvh_proxy = -1 };
+      insert_chunk(map, &chunk);
+    }
+  }
+}
+
+int main(void) {
+  chunk_map_t map;
+  init_chunk_map(&map, CHUNK_MAP_INITIAL_CAPACITY);
+
+  // Ground pixels fall anywhere in the loaded square, the neighbours of edge chunks miss
+  srand(1);
+  float *sample_x = malloc(PIXELS_PER_FRAME * sizeof(float));
+  float *sample_z = malloc(PIXELS_PER_FRAME * sizeof(float));
+  if (!sample_x || !sample_z) return 1;
+
+  for (int i = 0; i < PIXELS_PER_FRAME; ++i) {
+    sample_x[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * (LOAD_RADIUS + 0.5f) * CHUNK_SIZE;
+    sample_z[i] = ((float)rand() / RAND_MAX * 2.0f - 1.0f) * (LOAD_RADIUS + 0.5f) * CHUNK_SIZE;
+  }
+
+  // Streaming: one chunk row in and one out per tick
+  double start_time = get_time_seconds();
+  for (int tick = 0; tick < NUM_TICKS; ++tick) {
+    ++player_chunk_x;
+    update_chunks(&map);
+  }
+  double stream_time = get_time_seconds() - start_time;
+
+  // Shadow lookups: 9 per pixel, around a player standing still
+  usize hits = 0, lookups = 0;
+  start_time = get_time_seconds();
+  for (int frame = 0; frame < 10; ++frame) {
+    for (int i = 0; i < PIXELS_PER_FRAME; ++i) {
+      int cx = player_chunk_x + (int)floorf(sample_x[i] / CHUNK_SIZE);
+      int cz = player_chunk_z + (int)floorf(sample_z[i] / CHUNK_SIZE);
+
+      for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+          chunk_map_node_t *node = chunk_lookup(&map, cx + dx, cz + dz);
+          hits += node && node->loaded;
+          ++lookups;
+        }
+      }
+    }
+  }
+  double lookup_time = get_time_seconds() - start_time;
+
+  printf("Loaded chunks: %zu\n", (size_t)map.num_loaded_chunks);
+  printf("Streaming: %d ticks in %.2f ms (%.2f us/tick)\n", NUM_TICKS, stream_time * 1e3, stream_time * 1e6 / NUM_TICKS);
+  printf("Lookups: %zu (%.1f%% hit) in %.2f ms (%.2f ns/lookup)\n", (size_t)lookups, 100.0 * hits / lookups, lookup_time * 1e3, lookup_time * 1e9 / lookups);
+
+  free(sample_x);
+  free(sample_z);
+  free_chunk_map(&map);
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include "heightfield.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// A buffer of the field, from its arena while it has room and from the heap otherwise
+static void *alloc_field_buffer(heightfield_t *field, usize size) {
+  void *buffer = arena_alloc(field->arena, size);
+  return buffer ? buffer : malloc(size);
+}
+
+static void free_field_buffer(heightfield_t *field, void *buffer) {
+  if (!arena_contains(field->arena, buffer)) free(buffer);
+}
+
+int init_heightfield(heightfield_t *field, arena_t *arena, float origin_x, float origin_z, float size, int cells, height_func func, void *user) {
+  assert(field != NULL);
+  assert(func != NULL);
+  assert(cells > 0 && size > 0.0f);
+
+  int n = cells + 1;
+  int padded = cells + 3; // one extra sample all around, so edge normals match the neighbouring field's
+
+  *field = (heightfield_t){
+    .cells = cells,
+    .origin_x = origin_x,
+    .origin_z = origin_z,
+    .cell_size = size / (float)cells,
+    .inv_cell_size = (float)cells / size,
+    .arena = arena
+  };
+
+  usize start = arena_mark(arena);
+  field->heights = alloc_field_buffer(field, (usize)(n * n) * sizeof(float));
+  field->normals = alloc_field_buffer(field, (usize)(n * n) * sizeof(float3));
+
+  // The padded samples are only needed while building, released from the arena once done
+  usize mark = arena_mark(arena);
+  float *samples = alloc_field_buffer(field, (usize)(padded * padded + 2 * padded) * sizeof(float));
+  if (!field->heights || !field->normals || !samples) {
+    free_field_buffer(field, samples);
+    free_heightfield(field);
+    arena_release(arena, start);
+    return -1;
+  }
+
+  // Sample positions of one row, after the samples themselves
+  float *row_x = samples + padded * padded, *row_z = row_x + padded;
+  for (int x = 0; x < padded; ++x) row_x[x] = origin_x + (x - 1) * field->cell_size;
+
+  for (int z = 0; z < padded; ++z) {
+    for (int x = 0; x < padded; ++x) row_z[x] = origin_z + (z - 1) * field->cell_size;
+    func(row_x, row_z, &samples[z * padded], (usize)padded, user);
+  }
+
+  // Central differences over the padded grid
+  float inv_span = 0.5f * field->inv_cell_size;
+  for (int z = 0; z < n; ++z) {
+    const float *row = &samples[(z + 1) * padded + 1];
+
+    for (int x = 0; x < n; ++x) {
+      float dh_dx = (row[x + 1] - row[x - 1]) * inv_span;
+      float dh_dz = (row[x + padded] - row[x - padded]) * inv_span;
+
+      field->heights[z * n + x] = row[x];
+      field->normals[z * n + x] = float3_normalize(make_float3(-dh_dx, 1.0f, -dh_dz));
+    }
+  }
+
+  free_field_buffer(field, samples);
+  arena_release(arena, mark);
+  return 0;
+}
+
+void free_heightfield(heightfield_t *field) {
+  if (!field) return;
+
+  free_field_buffer(field, field->heights);
+  free_field_buffer(field, field->normals);
+  field->heights = NULL;
+  field->normals = NULL;
+  field->cells = 0;
+}
+
+bool heightfield_contains(const heightfield_t *field, float x, float z) {
+  float extent = field->cells * field->cell_size;
+  return field->heights != NULL &&
+         x >= field->origin_x && x <= field->origin_x + extent &&
+         z >= field->origin_z && z <= field->origin_z + extent;
+}
+
+// Cell holding x, z and the position inside it, clamped to the grid
+static inline int get_cell(const heightfield_t *field, float x, float z, float *fx, float *fz) {
+  float gx = fminf(fmaxf((x - field->origin_x) * field->inv_cell_size, 0.0f), (float)field->cells);
+  float gz = fminf(fmaxf((z - field->origin_z) * field->inv_cell_size, 0.0f), (float)field->cells);
+
+  // The far edge belongs to the last cell
+  int cx = (int)gx, cz = (int)gz;
+  if (cx == field->cells) --cx;
+  if (cz == field->cells) --cz;
+
+  *fx = gx - (float)cx;
+  *fz = gz - (float)cz;
+  return cz * (field->cells + 1) + cx;
+}
+
+float heightfield_height(const heightfield_t *field, float x, float z) {
+  float fx, fz;
+  int i = get_cell(field, x, z, &fx, &fz);
+  int n = field->cells + 1;
+
+  const float *h = field->heights;
+  float h0 = lerp(h[i], h[i + 1], fx);
+  float h1 = lerp(h[i + n], h[i + n + 1], fx);
+  return lerp(h0, h1, fz);
+}
+
+float3 heightfield_normal(const heightfield_t *field, float x, float z) {
+  float fx, fz;
+  int i = get_cell(field, x, z, &fx, &fz);
+  int n = field->cells + 1;
+
+  const float3 *nrm = field->normals;
+  float3 n0 = float3_lerp(nrm[i], nrm[i + 1], fx);
+  float3 n1 = float3_lerp(nrm[i + n], nrm[i + n + 1], fx);
+  return float3_normalize(float3_lerp(n0, n1, fz));
+}
@@ -0,0 +1,40 @@
+#ifndef __HEIGHTFIELD_H__
+#define __HEIGHTFIELD_H__
+
+#include <stdbool.h>
+
+#include <shader-works/maths.h>
+#include <shader-works/memory.h>
+
+// Heights of the terrain at count world positions, called a grid row at a time so it can use batch noise
+// user is passed through from init_heightfield
+typedef void (*height_func)(const float *x, const float *z, float *heights, usize count, void *user);
+
+// Square grid of terrain heights and normals sampled once, so height queries become memory reads
+typedef struct {
+  float *heights;       // (cells + 1)^2 samples, row major with z as the row
+  float3 *normals;      // surface normal at each sample
+  int cells;            // cells along each side
+  float origin_x, origin_z;
+  float cell_size, inv_cell_size;
+  arena_t *arena;       // where heights and normals were carved from, NULL when they are heap allocated
+} heightfield_t;
+
+// Sample func over the square starting at origin_x, origin_z
+// size: world units covered along each side
+// arena: memory for the samples, may be NULL, anything that does not fit comes from the heap
+// cells: grid cells along each side, sample spacing is size / cells
+// Returns 0 on success, -1 on allocation failure
+int init_heightfield(heightfield_t *field, arena_t *arena, float origin_x, float origin_z, float size, int cells, height_func func, void *user);
+void free_heightfield(heightfield_t *field);
+
+// Whether x, z lies over the grid
+bool heightfield_contains(const heightfield_t *field, float x, float z);
+
+// Bilinear height at x, z, positions off the grid are clamped to its edge
+float heightfield_height(const heightfield_t *field, float x, float z);
+
+// Bilinear surface normal at x, z, positions off the grid are clamped to its edge
+float3 heightfield_normal(const heightfield_t *field, float x, float z);
+
+#endif // __HEIGHTFIELD_H__
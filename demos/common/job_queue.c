@@ -0,0 +1,165 @@
+#include "job_queue.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+// Appends a completed job's arg, callers hold the lock when workers are running
+static void push_finished(job_queue_t *queue, void *arg) {
+  queue->finished[(queue->finished_head + queue->finished_count) % queue->capacity] = arg;
+  queue->finished_count++;
+}
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+static void *job_worker(void *arg) {
+  job_queue_t *queue = (job_queue_t *)arg;
+
+  pthread_mutex_lock(&queue->lock);
+  for (;;) {
+    while (!queue->stopping && queue->pending_count == 0) {
+      pthread_cond_wait(&queue->has_work, &queue->lock);
+    }
+    if (queue->stopping) break;
+
+    job_t job = queue->pending[queue->pending_head];
+    queue->pending_head = (queue->pending_head + 1) % queue->capacity;
+    queue->pending_count--;
+
+    // Run without the lock so the owner can keep pushing and collecting
+    pthread_mutex_unlock(&queue->lock);
+    job.run(job.arg);
+    pthread_mutex_lock(&queue->lock);
+
+    push_finished(queue, job.arg);
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return NULL;
+}
+#endif
+
+int init_job_queue(job_queue_t *queue, int num_workers, usize capacity) {
+  assert(queue != NULL);
+  assert(num_workers >= 0);
+  assert(capacity > 0);
+
+  *queue = (job_queue_t){0};
+  queue->capacity = capacity;
+  queue->pending = malloc(capacity * sizeof(job_t));
+  queue->finished = malloc(capacity * sizeof(void *));
+  if (!queue->pending || !queue->finished) {
+    free(queue->pending);
+    free(queue->finished);
+    *queue = (job_queue_t){0};
+    return -1;
+  }
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->has_work, NULL);
+
+  if (num_workers > 0) {
+    queue->workers = malloc((usize)num_workers * sizeof(pthread_t));
+    if (!queue->workers) {
+      free_job_queue(queue, NULL);
+      return -1;
+    }
+
+    for (int i = 0; i < num_workers; ++i) {
+      if (pthread_create(&queue->workers[i], NULL, job_worker, queue) != 0) {
+        free_job_queue(queue, NULL); // joins the workers started so far
+        return -1;
+      }
+      queue->num_workers++;
+    }
+  }
+#else
+  (void)num_workers; // no threads, every job runs in job_queue_push
+#endif
+
+  return 0;
+}
+
+void free_job_queue(job_queue_t *queue, job_func discard) {
+  if (!queue || !queue->pending) return;
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  pthread_mutex_lock(&queue->lock);
+  queue->stopping = true;
+  pthread_cond_broadcast(&queue->has_work);
+  pthread_mutex_unlock(&queue->lock);
+
+  for (int i = 0; i < queue->num_workers; ++i) {
+    pthread_join(queue->workers[i], NULL);
+  }
+  free(queue->workers);
+
+  pthread_cond_destroy(&queue->has_work);
+  pthread_mutex_destroy(&queue->lock);
+#endif
+
+  if (discard) {
+    for (usize i = 0; i < queue->pending_count; ++i) {
+      discard(queue->pending[(queue->pending_head + i) % queue->capacity].arg);
+    }
+    for (usize i = 0; i < queue->finished_count; ++i) {
+      discard(queue->finished[(queue->finished_head + i) % queue->capacity]);
+    }
+  }
+
+  free(queue->pending);
+  free(queue->finished);
+  *queue = (job_queue_t){0};
+}
+
+bool job_queue_push(job_queue_t *queue, job_func run, void *arg) {
+  assert(queue != NULL);
+  assert(run != NULL);
+
+  if (queue->num_workers == 0) {
+    if (queue->in_flight == queue->capacity) return false;
+    queue->in_flight++;
+
+    run(arg);
+    push_finished(queue, arg);
+    return true;
+  }
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  pthread_mutex_lock(&queue->lock);
+  bool accepted = queue->in_flight < queue->capacity;
+  if (accepted) {
+    queue->pending[(queue->pending_head + queue->pending_count) % queue->capacity] = (job_t){ run, arg };
+    queue->pending_count++;
+    queue->in_flight++;
+    pthread_cond_signal(&queue->has_work);
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return accepted;
+#else
+  return false; // unreachable, num_workers is always 0
+#endif
+}
+
+usize job_queue_collect(job_queue_t *queue, void **args, usize max_args) {
+  assert(queue != NULL);
+  assert(args != NULL || max_args == 0);
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  if (queue->num_workers > 0) pthread_mutex_lock(&queue->lock);
+#endif
+
+  usize count = 0;
+  while (count < max_args && queue->finished_count > 0) {
+    args[count++] = queue->finished[queue->finished_head];
+    queue->finished_head = (queue->finished_head + 1) % queue->capacity;
+    queue->finished_count--;
+  }
+  queue->in_flight -= count;
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  if (queue->num_workers > 0) pthread_mutex_unlock(&queue->lock);
+#endif
+
+  return count;
+}
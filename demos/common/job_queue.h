@@ -0,0 +1,56 @@
+#ifndef __JOB_QUEUE_H__
+#define __JOB_QUEUE_H__
+
+#include <stdbool.h>
+
+#include <shader-works/maths.h>
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+#include <pthread.h>
+#endif
+
+// Work run on a worker thread, arg belongs to the job until job_queue_collect hands it back
+typedef void (*job_func)(void *arg);
+
+typedef struct {
+  job_func run;
+  void *arg;
+} job_t;
+
+// Fixed capacity queue of jobs run by a pool of worker threads
+// Finished jobs wait until the owning thread collects them, so results are always published from one thread
+// With no workers (or without SHADER_WORKS_USE_PTHREADS) jobs run inside job_queue_push and are collected the same way
+typedef struct {
+  job_t *pending;       // ring of jobs waiting for a worker
+  void **finished;      // ring of args of completed jobs waiting to be collected
+  usize capacity;
+  usize pending_head, pending_count;
+  usize finished_head, finished_count;
+  usize in_flight;      // pushed but not yet collected, at most capacity
+  int num_workers;
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  pthread_t *workers;
+  pthread_mutex_t lock;
+  pthread_cond_t has_work;
+  bool stopping;
+#endif
+} job_queue_t;
+
+// Start num_workers threads serving a queue of at most capacity jobs, 0 workers runs every job synchronously
+// Returns 0 on success, -1 if allocation or thread creation failed
+int init_job_queue(job_queue_t *queue, int num_workers, usize capacity);
+
+// Stop the workers once their current job is done and release the queue
+// discard: called with the arg of every job that was never run or never collected, may be NULL
+void free_job_queue(job_queue_t *queue, job_func discard);
+
+// Queue a job for the next idle worker
+// Returns false if capacity jobs are already in flight, try again after collecting
+bool job_queue_push(job_queue_t *queue, job_func run, void *arg);
+
+// Take back the args of finished jobs, in completion order
+// Returns the number of args written, at most max_args
+usize job_queue_collect(job_queue_t *queue, void **args, usize max_args);
+
+#endif // __JOB_QUEUE_H__
@@ -1,5 +1,6 @@
 #include "noise.h"
 #include <math.h>
+#include <stdbool.h>
 #include <shader-works/maths.h>
 
 // Smooth step function for better interpolation
@@ -60,3 +61,174 @@ float ridgeNoise(float x, float y, int seed) {
   float n = fbm(x, y, 4, seed);
   return 1.0f - fabsf(n);  // Creates ridges by inverting absolute value
 }
+
+// Batch evaluation
+// Each kernel runs fbm over whole vectors of samples: one octave with no ridge is noise2D, four with ridge is ridgeNoise.
+// The arithmetic follows the scalar functions operation for operation, only FMA contraction in either can tell them apart.
+
+// hash2's seed term, the scalar code wraps it to 32 bits the same way
+static inline int hash2_seed_term(int seed) {
+  return (int)((unsigned)seed * 2654435761u);
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define NOISE_X86_SIMD 1
+
+__attribute__((target("avx2")))
+static inline __m256 hash2_avx2(__m256i x, __m256i y, __m256i seed_term) {
+  __m256i n = _mm256_add_epi32(_mm256_add_epi32(x, _mm256_mullo_epi32(y, _mm256_set1_epi32(57))), seed_term);
+  n = _mm256_xor_si256(_mm256_slli_epi32(n, 13), n);
+
+  __m256i t = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_mullo_epi32(n, n), _mm256_set1_epi32(15731)), _mm256_set1_epi32(789221));
+  t = _mm256_add_epi32(_mm256_mullo_epi32(n, t), _mm256_set1_epi32(1376312589));
+  t = _mm256_and_si256(t, _mm256_set1_epi32(0x7fffffff));
+
+  // Dividing by a power of two is exact, so multiplying by its inverse matches
+  return _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_cvtepi32_ps(t), _mm256_set1_ps(1.0f / 1073741824.0f)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 lerp_avx2(__m256 a, __m256 b, __m256 t) {
+  return _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), t), a), _mm256_mul_ps(t, b));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 noise2D_avx2(__m256 x, __m256 y, __m256i seed_term) {
+  __m256 x0 = _mm256_floor_ps(x), y0 = _mm256_floor_ps(y);
+  __m256i xi = _mm256_cvttps_epi32(x0), yi = _mm256_cvttps_epi32(y0);
+  __m256i one = _mm256_set1_epi32(1);
+
+  __m256 xf = _mm256_sub_ps(x, x0), yf = _mm256_sub_ps(y, y0);
+  __m256 three = _mm256_set1_ps(3.0f), two = _mm256_set1_ps(2.0f);
+  __m256 sx = _mm256_mul_ps(_mm256_mul_ps(xf, xf), _mm256_sub_ps(three, _mm256_mul_ps(two, xf)));
+  __m256 sy = _mm256_mul_ps(_mm256_mul_ps(yf, yf), _mm256_sub_ps(three, _mm256_mul_ps(two, yf)));
+
+  __m256 a = hash2_avx2(xi, yi, seed_term);
+  __m256 b = hash2_avx2(_mm256_add_epi32(xi, one), yi, seed_term);
+  __m256 c = hash2_avx2(xi, _mm256_add_epi32(yi, one), seed_term);
+  __m256 d = hash2_avx2(_mm256_add_epi32(xi, one), _mm256_add_epi32(yi, one), seed_term);
+
+  return lerp_avx2(lerp_avx2(a, b, sx), lerp_avx2(c, d, sx), sy);
+}
+
+// Returns the number of samples written, a multiple of 8
+__attribute__((target("avx2")))
+static size_t fbm_avx2(const float *x, const float *y, float *out, size_t count, int octaves, int seed, bool ridge) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+    __m256 value = _mm256_setzero_ps();
+    float amplitude = 1.0f, frequency = 1.0f, max_value = 0.0f;
+
+    for (int o = 0; o < octaves; o++) {
+      __m256 freq = _mm256_set1_ps(frequency);
+      __m256 n = noise2D_avx2(_mm256_mul_ps(px, freq), _mm256_mul_ps(py, freq), _mm256_set1_epi32(hash2_seed_term(seed + o)));
+      value = _mm256_add_ps(value, _mm256_mul_ps(n, _mm256_set1_ps(amplitude)));
+      max_value += amplitude;
+
+      amplitude *= 0.5f;
+      frequency *= 2.0f;
+    }
+
+    value = _mm256_div_ps(value, _mm256_set1_ps(max_value));
+    if (ridge) value = _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_andnot_ps(_mm256_set1_ps(-0.0f), value));
+
+    _mm256_storeu_ps(out + i, value);
+  }
+
+  return i;
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 hash2_sse41(__m128i x, __m128i y, __m128i seed_term) {
+  __m128i n = _mm_add_epi32(_mm_add_epi32(x, _mm_mullo_epi32(y, _mm_set1_epi32(57))), seed_term);
+  n = _mm_xor_si128(_mm_slli_epi32(n, 13), n);
+
+  __m128i t = _mm_add_epi32(_mm_mullo_epi32(_mm_mullo_epi32(n, n), _mm_set1_epi32(15731)), _mm_set1_epi32(789221));
+  t = _mm_add_epi32(_mm_mullo_epi32(n, t), _mm_set1_epi32(1376312589));
+  t = _mm_and_si128(t, _mm_set1_epi32(0x7fffffff));
+
+  return _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_cvtepi32_ps(t), _mm_set1_ps(1.0f / 1073741824.0f)));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 lerp_sse41(__m128 a, __m128 b, __m128 t) {
+  return _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), t), a), _mm_mul_ps(t, b));
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128 noise2D_sse41(__m128 x, __m128 y, __m128i seed_term) {
+  __m128 x0 = _mm_floor_ps(x), y0 = _mm_floor_ps(y);
+  __m128i xi = _mm_cvttps_epi32(x0), yi = _mm_cvttps_epi32(y0);
+  __m128i one = _mm_set1_epi32(1);
+
+  __m128 xf = _mm_sub_ps(x, x0), yf = _mm_sub_ps(y, y0);
+  __m128 three = _mm_set1_ps(3.0f), two = _mm_set1_ps(2.0f);
+  __m128 sx = _mm_mul_ps(_mm_mul_ps(xf, xf), _mm_sub_ps(three, _mm_mul_ps(two, xf)));
+  __m128 sy = _mm_mul_ps(_mm_mul_ps(yf, yf), _mm_sub_ps(three, _mm_mul_ps(two, yf)));
+
+  __m128 a = hash2_sse41(xi, yi, seed_term);
+  __m128 b = hash2_sse41(_mm_add_epi32(xi, one), yi, seed_term);
+  __m128 c = hash2_sse41(xi, _mm_add_epi32(yi, one), seed_term);
+  __m128 d = hash2_sse41(_mm_add_epi32(xi, one), _mm_add_epi32(yi, one), seed_term);
+
+  return lerp_sse41(lerp_sse41(a, b, sx), lerp_sse41(c, d, sx), sy);
+}
+
+// Returns the number of samples written, a multiple of 4
+__attribute__((target("sse4.1")))
+static size_t fbm_sse41(const float *x, const float *y, float *out, size_t count, int octaves, int seed, bool ridge) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i);
+    __m128 value = _mm_setzero_ps();
+    float amplitude = 1.0f, frequency = 1.0f, max_value = 0.0f;
+
+    for (int o = 0; o < octaves; o++) {
+      __m128 freq = _mm_set1_ps(frequency);
+      __m128 n = noise2D_sse41(_mm_mul_ps(px, freq), _mm_mul_ps(py, freq), _mm_set1_epi32(hash2_seed_term(seed + o)));
+      value = _mm_add_ps(value, _mm_mul_ps(n, _mm_set1_ps(amplitude)));
+      max_value += amplitude;
+
+      amplitude *= 0.5f;
+      frequency *= 2.0f;
+    }
+
+    value = _mm_div_ps(value, _mm_set1_ps(max_value));
+    if (ridge) value = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_andnot_ps(_mm_set1_ps(-0.0f), value));
+
+    _mm_storeu_ps(out + i, value);
+  }
+
+  return i;
+}
+#endif
+
+// Runs the widest kernel the CPU supports, the scalar functions finish the remainder
+static void fbm_batch_impl(const float *x, const float *y, float *out, size_t count, int octaves, int seed, bool ridge) {
+  size_t i = 0;
+
+#ifdef NOISE_X86_SIMD
+  if (__builtin_cpu_supports("avx2"))        i = fbm_avx2(x, y, out, count, octaves, seed, ridge);
+  else if (__builtin_cpu_supports("sse4.1")) i = fbm_sse41(x, y, out, count, octaves, seed, ridge);
+#endif
+
+  for (; i < count; i++) {
+    float n = fbm(x[i], y[i], octaves, seed);
+    out[i] = ridge ? 1.0f - fabsf(n) : n;
+  }
+}
+
+void noise2D_batch(const float *x, const float *y, float *out, size_t count, int seed) {
+  fbm_batch_impl(x, y, out, count, 1, seed, false); // a single octave of fbm is exactly noise2D
+}
+
+void fbm_batch(const float *x, const float *y, float *out, size_t count, int octaves, int seed) {
+  fbm_batch_impl(x, y, out, count, octaves, seed, false);
+}
+
+void ridge_batch(const float *x, const float *y, float *out, size_t count, int seed) {
+  fbm_batch_impl(x, y, out, count, 4, seed, true);
+}
@@ -1,6 +1,8 @@
 #ifndef NOISE_H
 #define NOISE_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -12,6 +14,12 @@ float noise2D(float x, float y, int seed);
 float fbm(float x, float y, int octaves, int seed);
 float ridgeNoise(float x, float y, int seed);
 
+// Array versions of the functions above, out[i] matches the scalar call on x[i], y[i] to within float rounding
+// Vectorized with AVX2 or SSE4.1 when the CPU has them, checked at run time
+void noise2D_batch(const float *x, const float *y, float *out, size_t count, int seed);
+void fbm_batch(const float *x, const float *y, float *out, size_t count, int octaves, int seed);
+void ridge_batch(const float *x, const float *y, float *out, size_t count, int seed);
+
 #ifdef __cplusplus
 }
 #endif
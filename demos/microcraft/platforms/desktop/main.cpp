@@ -1,6 +1,7 @@
 #include <float.h>
 #include <math.h>
 #include <stdbool.h>
+#include <string.h>
 
 extern "C" {
 #include <shader-works/renderer.h>
@@ -87,7 +88,16 @@ int main(int argc, char *argv[]) {
   // Atlas dimensions: 10 tiles x 3 rows, each tile is 8x8 pixels
   init_renderer(&renderer_state, WIN_WIDTH, WIN_HEIGHT, 80, 24, framebuffer, depthbuffer, NULL, MAX_DEPTH);
 
-  renderer_state.texture_atlas = files[1].data;
+  // tools/bake emits palettized textures unless run with --format rgba
+  for (int i = 0; i < num_files; ++i) {
+    if (strcmp(files[i].name, "atlas.bmp") != 0) continue;
+
+    if (files[i].palette) {
+      set_texture_atlas_indexed(&renderer_state, files[i].indices, files[i].palette, (texture_format_t)files[i].format);
+    } else {
+      renderer_state.texture_atlas = files[i].data;
+    }
+  }
 
   Scene scene;
 
@@ -2,6 +2,8 @@
 
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <shader-works/maths.h>
 #include <shader-works/renderer.h>
 #include <shader-works/primitives.h>
@@ -14,13 +16,16 @@ block_type_t Scene::map[Scene::MAP_WIDTH][Scene::MAP_DEPTH][Scene::MAP_HEIGHT];
 
 // Destructor - clean up dynamically allocated resources
 Scene::~Scene() {
+#if MICROCRAFT_CHUNK_MESHES
+  for (size_t cx = 0; cx < CHUNKS_X; ++cx)
+    for (size_t cz = 0; cz < CHUNKS_Z; ++cz)
+      delete_model(&chunks[cx][cz].model);
+#else
   delete_model(&cube);
+  delete_model(&grass_cube);
+#endif
 }
 
-// Pre-computed UV coordinates for different block types
-// Each cube has 6 faces * 2 triangles * 3 vertices = 36 UV coordinates
-// Face order: bottom, top, front, back, right, left (matching cube_vertices order)
-
 // Precomputed UV coordinates for each tile corner (static constant)
 // Atlas is 80x24 pixels = 10 tiles x 3 rows, each tile is 8x8
 // UV mapping: corner order is [bottom-left(0,0), bottom-right(1,0), top-right(1,1), top-left(0,1)]
@@ -47,15 +52,6 @@ static const float2 TILE_UVS[10][4] = {
   {{0.9f, 0.333333f}, {1.0f, 0.333333f}, {1.0f, 0.0f}, {0.9f, 0.0f}}
 };
 
-// Static UV coordinate arrays for different block types
-float2 Scene::cube_uvs_grass[36];
-float2 Scene::cube_uvs_stone[36];
-float2 Scene::cube_uvs_dirt[36];
-float2 Scene::cube_uvs_sand[36];
-float2 Scene::cube_uvs_wood[36];
-float2 Scene::cube_uvs_leaf[36];
-float2 Scene::cube_uvs_water[36];
-
 // Static helper functions
 
 // Fast lookup function (no divisions, just array access)
@@ -63,6 +59,167 @@ static inline float2 get_tile_uv(int tile_id, int corner) {
   return TILE_UVS[tile_id][corner];
 }
 
+#if MICROCRAFT_CHUNK_MESHES
+// Size of one tile in UV units, merged quads repeat their tile this often
+static const float2 TILE_DIM = {0.1f, 0.333333f};
+
+// Axis of each face direction (0 = x, 1 = y, 2 = z) and which side of the block it is on
+enum face_dir_t { FACE_NEG_X, FACE_POS_X, FACE_NEG_Y, FACE_POS_Y, FACE_NEG_Z, FACE_POS_Z, FACE_COUNT };
+static const int FACE_AXIS[FACE_COUNT] = { 0, 0, 1, 1, 2, 2 };
+static const int FACE_SIGN[FACE_COUNT] = { -1, 1, -1, 1, -1, 1 };
+
+// Texture orientation per face, matching generate_cube so merged faces look like the single blocks they replace
+static const bool FACE_FLIP_U[FACE_COUNT] = { true, false, false, false, false, true };
+static const bool FACE_FLIP_V[FACE_COUNT] = { true, true, false, true, true, true };
+
+// Atlas tile drawn on one face of a block
+static int block_face_tile(block_type_t block, int face) {
+  switch (block) {
+  case block_type_t::GRASS:
+    if (face == FACE_POS_Y) return 2;  // grass top
+    if (face == FACE_NEG_Y) return 0;  // dirt bottom
+    return 1;                          // grass side
+  case block_type_t::DIRT:   return 0;
+  case block_type_t::SAND:   return 4;
+  case block_type_t::WOOD:   return 5; // TODO: add bottom and top texture
+  case block_type_t::LEAVES: return 6;
+  case block_type_t::WATER:  return 7; // NOTE: Maybe just render the top face?
+  case block_type_t::STONE:
+  default:                   return 3;
+  }
+}
+
+// Block at a map position, the player never leaves the map so anything outside it is solid and the outward
+// faces of the map's edges, which could only be seen from outside, are never meshed. Above the map is open sky
+static block_type_t block_at(int x, int y, int z) {
+  if (y >= (int)Scene::MAP_HEIGHT) return block_type_t::AIR;
+  if (x < 0 || y < 0 || z < 0 || x >= (int)Scene::MAP_WIDTH || z >= (int)Scene::MAP_DEPTH) return block_type_t::STONE;
+
+  return Scene::map[x][z][y];
+}
+
+// Vector along one map axis (0 = x, 1 = y, 2 = z)
+static float3 axis_vector(int axis, float length) {
+  return make_float3(axis == 0 ? length : 0.f, axis == 1 ? length : 0.f, axis == 2 ? length : 0.f);
+}
+
+// Writes one quad as two triangles, or only counts it when verts is null
+// corner: world position of the quad's (u, v) = (0, 0) corner, du and dv span the quad along its two axes
+// size: quad extent in blocks, used to repeat the tile across it
+// flip_u, flip_v: run the texture against du or dv
+static void emit_quad(vertex_data_t *verts, float3 *normals, size_t &quads, float3 corner, float3 du, float3 dv,
+                      float2 size, int tile, bool flip_u, bool flip_v, float3 normal) {
+  if (verts) {
+    float2 origin = get_tile_uv(tile, 3);
+    float3 p[4] = { corner, float3_add(corner, du), float3_add(float3_add(corner, du), dv), float3_add(corner, dv) };
+    float2 st[4] = { {0.f, 0.f}, {size.x, 0.f}, {size.x, size.y}, {0.f, size.y} };
+
+    vertex_data_t v[4];
+    for (int c = 0; c < 4; ++c) {
+      float s = flip_u ? size.x - st[c].x : st[c].x;
+      float t = flip_v ? size.y - st[c].y : st[c].y;
+      v[c] = { p[c], { origin.x + s * TILE_DIM.x, origin.y + t * TILE_DIM.y }, normal };
+    }
+
+    vertex_data_t *out = verts + quads * 6;
+    out[0] = v[0]; out[1] = v[1]; out[2] = v[2];
+    out[3] = v[0]; out[4] = v[2]; out[5] = v[3];
+    normals[quads * 2 + 0] = normal;
+    normals[quads * 2 + 1] = normal;
+  }
+
+  ++quads;
+}
+
+// Greedy meshes one chunk of the map: for every slice of every face direction, faces exposed to air are
+// marked with their tile and grown into the largest rectangles of equal tiles
+// Returns the number of quads, only counting them when verts is null
+static size_t mesh_chunk(size_t cx, size_t cz, size_t chunk_size, vertex_data_t *verts, float3 *normals) {
+  int lo[3] = { (int)(cx * chunk_size), 0, (int)(cz * chunk_size) };
+  int hi[3] = { lo[0] + (int)chunk_size, (int)Scene::MAP_HEIGHT, lo[2] + (int)chunk_size };
+  if (hi[0] > (int)Scene::MAP_WIDTH) hi[0] = (int)Scene::MAP_WIDTH;
+  if (hi[2] > (int)Scene::MAP_DEPTH) hi[2] = (int)Scene::MAP_DEPTH;
+
+  // Tile + 1 of each exposed face in the current slice, 0 where there is none
+  static uint8_t mask[Scene::MAP_WIDTH * Scene::MAP_HEIGHT];
+  size_t quads = 0;
+
+  for (int face = 0; face < FACE_COUNT; ++face) {
+    int d = FACE_AXIS[face], sign = FACE_SIGN[face];
+
+    // Side faces keep y as their v axis so textures stay upright
+    int u = d == 0 ? 2 : 0;
+    int v = d == 1 ? 2 : 1;
+    int width = hi[u] - lo[u], height = hi[v] - lo[v];
+
+    // Renderer convention: face normals point into the block, see generate_cube
+    float3 normal = axis_vector(d, (float)-sign);
+
+    for (int slice = lo[d]; slice < hi[d]; ++slice) {
+      for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+          int p[3];
+          p[d] = slice; p[u] = lo[u] + i; p[v] = lo[v] + j;
+          block_type_t block = block_at(p[0], p[1], p[2]);
+
+          p[d] += sign;
+          bool exposed = block != block_type_t::AIR && block_at(p[0], p[1], p[2]) == block_type_t::AIR;
+          mask[j * width + i] = exposed ? (uint8_t)(block_face_tile(block, face) + 1) : 0;
+        }
+      }
+
+      for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width;) {
+          uint8_t tile = mask[j * width + i];
+          if (!tile) { ++i; continue; }
+
+          // Grow along u, then along v while the whole row matches
+          int w = 1;
+          while (i + w < width && mask[j * width + i + w] == tile) ++w;
+
+          int h = 1;
+          for (; j + h < height; ++h) {
+            int k = 0;
+            while (k < w && mask[(j + h) * width + i + k] == tile) ++k;
+            if (k < w) break;
+          }
+
+          for (int y = 0; y < h; ++y)
+            memset(&mask[(j + y) * width + i], 0, (size_t)w);
+
+          // Blocks are unit cubes centered on their map position
+          float3 corner = float3_add(axis_vector(d, (float)slice + 0.5f * (float)sign),
+                                     float3_add(axis_vector(u, (float)(lo[u] + i) - 0.5f), axis_vector(v, (float)(lo[v] + j) - 0.5f)));
+
+          emit_quad(verts, normals, quads, corner, axis_vector(u, (float)w), axis_vector(v, (float)h), {(float)w, (float)h}, tile - 1,
+                    FACE_FLIP_U[face], FACE_FLIP_V[face], normal);
+          i += w;
+        }
+      }
+    }
+  }
+
+  return quads;
+}
+
+#else
+// Static UV coordinate arrays for the two cube meshes
+float2 Scene::cube_uvs_grass[36];
+float2 Scene::cube_uvs_uniform[36];
+
+// Atlas tile drawn on every face of a single-tile block, grass is handled by its own mesh
+static int block_tile(block_type_t block) {
+  switch (block) {
+  case block_type_t::DIRT:   return 0;
+  case block_type_t::SAND:   return 4;
+  case block_type_t::WOOD:   return 5; // TODO: add bottom and top texture
+  case block_type_t::LEAVES: return 6;
+  case block_type_t::WATER:  return 7; // NOTE: Maybe just render the top face?
+  case block_type_t::STONE:
+  default:                   return 3;
+  }
+}
+
 // Checks if block needs rendering (occlusion culling + view frustum culling)
 static bool is_block_visible(size_t x, size_t z, size_t y, transform_t& camera) {
   // First check if any face is exposed (basic occlusion)
@@ -115,56 +272,14 @@ static bool is_block_visible(size_t x, size_t z, size_t y, transform_t& camera)
 // Generate UV coordinates for a full cube (6 faces, each with 2 triangles)
 // Actual face order from primitives.c: Front(-Z), Back(+Z), Left(+X), Right(-X), Top(+Y), Bottom(-Y)
 static void generate_cube_uvs(float2* uvs, int top_tile, int bottom_tile, int side_tile) {
-  int uv_idx = 0;
-
-  // Face 0: Front -Z (vertices 0-5)
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 3);
-
-  // Face 1: Back +Z (vertices 6-11)
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 3);
-
-  // Face 2: Left +X (vertices 12-17)
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 3);
-
-  // Face 3: Right -X (vertices 18-23)
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(side_tile, 3);
-
-  // Face 4: Top +Y (vertices 24-29)
-  uvs[uv_idx++] = get_tile_uv(top_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(top_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(top_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(top_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(top_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(top_tile, 3);
-
-  // Face 5: Bottom -Y (vertices 30-35)
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 1);
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 0);
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 2);
-  uvs[uv_idx++] = get_tile_uv(bottom_tile, 3);
+  int tiles[6] = { side_tile, side_tile, side_tile, side_tile, top_tile, bottom_tile };
+  static const int corners[6] = { 0, 1, 2, 0, 2, 3 };
+
+  for (int face = 0; face < 6; ++face)
+    for (int i = 0; i < 6; ++i)
+      uvs[face * 6 + i] = get_tile_uv(tiles[face], corners[i]);
 }
+#endif
 
 static size_t terrain_height(size_t x, size_t z, size_t max_height) {
   // fbm returns [-1, 1], shift to [0, 1], then scale to terrain height range
@@ -180,15 +295,6 @@ static size_t terrain_height(size_t x, size_t z, size_t max_height) {
 
 // Initialize the scene, load resources, etc.
 void Scene::init() {
-  // Initialize UV coordinates for different block types
-  generate_cube_uvs(cube_uvs_grass, 2, 0, 1);  // grass: top=grass(2), bottom=dirt(0), sides=dirt(1)
-  generate_cube_uvs(cube_uvs_stone, 3, 3, 3);  // stone: all faces stone(3)
-  generate_cube_uvs(cube_uvs_dirt, 0, 0, 0);   // dirt: all faces dirt(0)
-  generate_cube_uvs(cube_uvs_sand, 4, 4, 4);   // sand: all faces sand(4)
-  generate_cube_uvs(cube_uvs_wood, 5, 5, 5);   // Wood: all faces bark(5) TODO: add bottom and top texture
-  generate_cube_uvs(cube_uvs_leaf, 6, 6, 6);   // Leaf: all faces Leaves(6)
-  generate_cube_uvs(cube_uvs_water, 7, 7, 7);  // Water: all faces Water(6) NOTE: Maybe just render the top face?
-
   for (size_t x = 0; x < MAP_WIDTH; ++x) {
     for (size_t z = 0; z < MAP_DEPTH; ++z) {
       float height = terrain_height(x, z, MAP_HEIGHT);
@@ -210,16 +316,93 @@ void Scene::init() {
   player_cam.position.y = (float)terrain_height(0, 0, MAP_HEIGHT) + 2.0f;  // Spawn 2 blocks above terrain
   fps_controller.ground_height = player_cam.position.y;
 
-  // Initialize the cube mesh
-  generate_cube(&cube, {0.f, 0.f, 0.f}, {1.f, 1.f, 1.f});
-  cube.vertex_shader = nullptr;
-  cube.frag_shader = &default_lighting_frag_shader;
-  cube.use_textures = true;
+#if MICROCRAFT_CHUNK_MESHES
+  // Build every chunk mesh up front rather than on the first frame
+  size_t quads = 0;
+  for (size_t cx = 0; cx < CHUNKS_X; ++cx) {
+    for (size_t cz = 0; cz < CHUNKS_Z; ++cz) {
+      rebuild_chunk(cx, cz);
+      quads += chunks[cx][cz].model.num_faces / 2;
+    }
+  }
 
-  fprintf(stderr, "Cube initialized: vertices=%zu, vertex_data=%p\n", cube.num_vertices, cube.vertex_data);
+  // Each quad is two unindexed triangles: 6 vertices and 2 face normals
+  size_t mesh_bytes = quads * (6 * sizeof(vertex_data_t) + 2 * sizeof(float3));
+  fprintf(stderr, "Map meshed: chunks=%zu, quads=%zu, mesh memory=%zu KiB\n", CHUNKS_X * CHUNKS_Z, quads, mesh_bytes / 1024);
+#else
+  // Initialize UV coordinates for the two cube meshes
+  generate_cube_uvs(cube_uvs_grass, 2, 0, 1);    // grass: top=grass(2), bottom=dirt(0), sides=dirt(1)
+  generate_cube_uvs(cube_uvs_uniform, 0, 0, 0);  // everything else: one tile on all faces, see block_tile
+
+  // Initialize the cube meshes, placed per block by instance transforms
+  model_t *meshes[2] = { &cube, &grass_cube };
+  float2 *mesh_uvs[2] = { cube_uvs_uniform, cube_uvs_grass };
+  for (size_t m = 0; m < 2; ++m) {
+    generate_cube(meshes[m], {0.f, 0.f, 0.f}, {1.f, 1.f, 1.f});
+    meshes[m]->vertex_shader = nullptr;
+    meshes[m]->frag_shader = &default_lighting_frag_shader;
+    meshes[m]->use_textures = true;
+
+    for (size_t i = 0; i < meshes[m]->num_vertices; ++i) {
+      meshes[m]->vertex_data[i].uv = mesh_uvs[m][i];
+    }
+  }
+
+  fprintf(stderr, "Cube initialized: vertices=%zu, vertex_data=%p\n", cube.num_vertices, (void *)cube.vertex_data);
+#endif
   fflush(stderr);
 }
 
+#if MICROCRAFT_CHUNK_MESHES
+// Rebuild one chunk's mesh from the map, an empty chunk is left without geometry
+void Scene::rebuild_chunk(size_t cx, size_t cz) {
+  chunk_mesh_t &chunk = chunks[cx][cz];
+  delete_model(&chunk.model);
+  chunk.dirty = false;
+
+  size_t quads = mesh_chunk(cx, cz, CHUNK_SIZE, nullptr, nullptr);
+  if (quads == 0) return;
+
+  model_t &model = chunk.model;
+  // delete_model hands these back to the library's allocator, so they must come from it
+  model.vertex_data = (vertex_data_t *)sw_alloc(quads * 6 * sizeof(vertex_data_t), SW_MEMORY_GEOMETRY);
+  model.face_normals = (float3 *)sw_alloc(quads * 2 * sizeof(float3), SW_MEMORY_GEOMETRY);
+  if (!model.vertex_data || !model.face_normals) {
+    fprintf(stderr, "Failed to allocate mesh for chunk (%zu, %zu)\n", cx, cz);
+    delete_model(&model);
+    return;
+  }
+
+  mesh_chunk(cx, cz, CHUNK_SIZE, model.vertex_data, model.face_normals);
+
+  // Vertices are in map coordinates, so the model sits at the origin
+  model.num_vertices = quads * 6;
+  model.num_faces = quads * 2;
+  model.scale = {1.f, 1.f, 1.f};
+  model.transform = {0};
+  model.vertex_shader = nullptr;
+  model.frag_shader = &default_lighting_frag_shader;
+  model.use_textures = true;
+  model.atlas_tile_dim = TILE_DIM;
+  compute_model_bounds(&model);
+}
+#endif
+
+// Change a block and mark its chunk, plus any neighbour sharing the changed faces, for a rebuild
+void Scene::set_block(size_t x, size_t z, size_t y, block_type_t block) {
+  if (x >= MAP_WIDTH || z >= MAP_DEPTH || y >= MAP_HEIGHT || map[x][z][y] == block) return;
+  map[x][z][y] = block;
+
+#if MICROCRAFT_CHUNK_MESHES
+  size_t cx = x / CHUNK_SIZE, cz = z / CHUNK_SIZE;
+  chunks[cx][cz].dirty = true;
+  if (x % CHUNK_SIZE == 0 && cx > 0) chunks[cx - 1][cz].dirty = true;
+  if (x % CHUNK_SIZE == CHUNK_SIZE - 1 && cx + 1 < CHUNKS_X) chunks[cx + 1][cz].dirty = true;
+  if (z % CHUNK_SIZE == 0 && cz > 0) chunks[cx][cz - 1].dirty = true;
+  if (z % CHUNK_SIZE == CHUNK_SIZE - 1 && cz + 1 < CHUNKS_Z) chunks[cx][cz + 1].dirty = true;
+#endif
+}
+
 // Update the scene (e.g., animations, physics)
 void Scene::update(float delta_time) {
   update_timing(fps_controller);
@@ -246,10 +429,45 @@ void Scene::update(float delta_time) {
   player_cam.position.y = fps_controller.ground_height + 2.0f;
 }
 
+#if !MICROCRAFT_CHUNK_MESHES
+// Submit a batch of gathered blocks in one render call and empty it
+size_t Scene::flush_instances(renderer_t &state, model_t &model, model_instance_t *instances, size_t &count) {
+  size_t tris = count ? render_model_instanced(&state, &player_cam, &model, instances, count, &sun, 1) : 0;
+  count = 0;
+  return tris;
+}
+#endif
+
 // Render the scene to the display buffer
 void Scene::render(renderer_t &state, uint32_t *buffer, float *depth_buffer) {
   static unsigned frames = 0; // for debug
 
+#if MICROCRAFT_CHUNK_MESHES
+  // Skip chunks that lie entirely beyond the fog
+  const float render_distance = 16.0f;
+
+  size_t chunks_rendered = 0, tris_rendered = 0, tris_total = 0;
+  for (size_t cx = 0; cx < CHUNKS_X; ++cx) {
+    for (size_t cz = 0; cz < CHUNKS_Z; ++cz) {
+      chunk_mesh_t &chunk = chunks[cx][cz];
+      if (chunk.dirty) rebuild_chunk(cx, cz);
+      if (chunk.model.num_vertices == 0) continue;
+
+      // Horizontal distance from the camera to the chunk's box
+      float dx = fmaxf(0.f, fmaxf(chunk.model.bounds_min.x - player_cam.position.x, player_cam.position.x - chunk.model.bounds_max.x));
+      float dz = fmaxf(0.f, fmaxf(chunk.model.bounds_min.z - player_cam.position.z, player_cam.position.z - chunk.model.bounds_max.z));
+      if (dx * dx + dz * dz > render_distance * render_distance) continue;
+
+      tris_rendered += render_model(&state, &player_cam, &chunk.model, &sun, 1);
+      tris_total += chunk.model.num_faces;
+      ++chunks_rendered;
+    }
+  }
+
+  if (++frames % 60) {
+    printf("%zu chunks sent to renderer, %zu triangles actually rendered of %zu total\n", chunks_rendered, tris_rendered, tris_total);
+  }
+#else
   // Simple frustum culling: only render blocks near the player
   const float render_distance = 16.0f;
   int min_x = (int)(player_cam.position.x - render_distance);
@@ -262,68 +480,44 @@ void Scene::render(renderer_t &state, uint32_t *buffer, float *depth_buffer) {
   if (min_z < 0) min_z = 0;
   if (max_z >= MAP_DEPTH) max_z = MAP_DEPTH - 1;
 
-  // Copy UVs into the vertex data (for now just use grass)
-  for (size_t i = 0; i < cube.num_vertices; ++i) {
-    cube.vertex_data[i].uv = cube_uvs_grass[i];
-  }
-
   size_t blocks_rendered = 0, tris_rendered = 0, blocks_attempted = 0;
   for (int x = min_x; x <= max_x; ++x) {
     for (int z = min_z; z <= max_z; ++z) {
-      float height = terrain_height(x, z, MAP_HEIGHT);
-
-      for (size_t y = 0; y <= height; ++y) {
+      // Every height, set_block can raise a column past its generated terrain
+      for (size_t y = 0; y < MAP_HEIGHT; ++y) {
+        block_type_t block = Scene::map[x][z][y];
+        if (block == block_type_t::AIR) continue;
         blocks_attempted++;
 
         if (is_block_visible(x, z, y, player_cam)) {
-          block_type_t block = Scene::map[x][z][y];
-
-          cube.transform.position = { (float)x, (float)y, (float)z };
-
-          // Select the appropriate UV coordinates based on block type
-          float2 *uvs = cube_uvs_stone; // Default
-          switch (block) {
-          case block_type_t::GRASS:
-            uvs = cube_uvs_grass;
-            break;
-          case block_type_t::STONE:
-            uvs = cube_uvs_stone;
-            break;
-          case block_type_t::DIRT:
-            uvs = cube_uvs_dirt;
-            break;
-          case block_type_t::SAND:
-            uvs = cube_uvs_sand;
-            break;
-          case block_type_t::WOOD:
-            uvs = cube_uvs_wood;
-            break;
-          case block_type_t::LEAVES:
-            uvs = cube_uvs_leaf;
-            break;
-          case block_type_t::WATER:
-            uvs = cube_uvs_water;
-            break;
-          default:
-            uvs = cube_uvs_stone;
-            break;
-          }
-
-          // Copy UVs to all vertices
-          for (size_t i = 0; i < cube.num_vertices; ++i) {
-            cube.vertex_data[i].uv = uvs[i];
+          model_instance_t instance = {};
+          instance.transform.position = { (float)x, (float)y, (float)z };
+
+          if (block == block_type_t::GRASS) {
+            grass_instances[num_grass_instances++] = instance;
+            if (num_grass_instances == INSTANCE_BATCH)
+              tris_rendered += flush_instances(state, grass_cube, grass_instances, num_grass_instances);
+          } else {
+            // Shift the tile 0 UVs onto this block's tile
+            instance.data.uv_offset = get_tile_uv(block_tile(block), 3);
+            cube_instances[num_cube_instances++] = instance;
+            if (num_cube_instances == INSTANCE_BATCH)
+              tris_rendered += flush_instances(state, cube, cube_instances, num_cube_instances);
           }
 
-          tris_rendered += render_model(&state, &player_cam, &cube, &sun, 1) % 36;
           ++blocks_rendered;
         }
       }
     }
   }
 
+  tris_rendered += flush_instances(state, grass_cube, grass_instances, num_grass_instances);
+  tris_rendered += flush_instances(state, cube, cube_instances, num_cube_instances);
+
   if (++frames % 60) {
-    printf("%u blocks sent to renderer, %u triangles actually rendered of %u total\n", blocks_rendered, tris_rendered, blocks_attempted);
+    printf("%zu blocks sent to renderer, %zu triangles actually rendered of %zu total\n", blocks_rendered, tris_rendered, blocks_attempted);
   }
+#endif
 
   apply_fog_to_screen(&state, 5, 15, 50, 50, 175);
 }
@@ -15,6 +15,17 @@ extern "C" {
 }
 #endif
 
+// Draw the map as greedy-meshed chunks rather than one shared cube per visible block
+// The chunk meshes take ~184 KiB on the default map, more than the SAMD51 has left beside its frame and depth
+// buffers, so board builds keep the per-block path
+#ifndef MICROCRAFT_CHUNK_MESHES
+#ifdef __SAMD51__
+#define MICROCRAFT_CHUNK_MESHES 0
+#else
+#define MICROCRAFT_CHUNK_MESHES 1
+#endif
+#endif
+
 enum class block_type_t : uint8_t {
   AIR = 0,
   STONE = 1,
@@ -40,7 +51,7 @@ struct fps_controller_t {
 class Scene {
 public:
   Scene() = default;
-  ~Scene();  // Need to clean up cube model
+  ~Scene();  // Need to clean up chunk meshes or cube models
 
   // Initialize the scene, load resources, etc.
   void init();
@@ -51,6 +62,9 @@ public:
   // Render the scene to the display buffer
   void render(renderer_t &state, uint32_t *buffer, float *depth_buffer);
 
+  // Change a block, marking the meshes that show it for a rebuild before the next render
+  void set_block(size_t x, size_t z, size_t y, block_type_t block);
+
   static constexpr size_t MAP_WIDTH = 32;
   static constexpr size_t MAP_DEPTH = 32;
   static constexpr size_t MAP_HEIGHT = 16;
@@ -67,25 +81,43 @@ private:
   };
 
   transform_t player_cam;
-  model_t cube = {};  // Zero-initialize
+
+#if MICROCRAFT_CHUNK_MESHES
+  // The map is drawn as one greedy-meshed model per CHUNK_SIZE x CHUNK_SIZE column of blocks
+  // Only faces touching air are kept and neighbouring faces with the same tile merge into one quad
+  static constexpr size_t CHUNK_SIZE = 16;
+  static constexpr size_t CHUNKS_X = (MAP_WIDTH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  static constexpr size_t CHUNKS_Z = (MAP_DEPTH + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+  struct chunk_mesh_t {
+    model_t model = {};   // Zero-initialize, built by rebuild_chunk
+    bool dirty = true;    // Blocks changed since the mesh was built
+  };
+  chunk_mesh_t chunks[CHUNKS_X][CHUNKS_Z];
+
+  void rebuild_chunk(size_t cx, size_t cz);
+#else
+  model_t cube = {};        // Zero-initialize, every face mapped to tile 0 and shifted per instance
+  model_t grass_cube = {};  // Grass needs distinct top, side and bottom tiles
+
+  // Visible blocks are gathered here and submitted with render_model_instanced whenever a batch fills
+  static constexpr size_t INSTANCE_BATCH = 128;
+  model_instance_t cube_instances[INSTANCE_BATCH];
+  model_instance_t grass_instances[INSTANCE_BATCH];
+  size_t num_cube_instances = 0, num_grass_instances = 0;
+
+  size_t flush_instances(renderer_t &state, model_t &model, model_instance_t *instances, size_t &count);
+
+  // Pre-computed UV coordinates for the two cube meshes
+  static float2 cube_uvs_grass[36];   // grass top, grass side and dirt bottom tiles
+  static float2 cube_uvs_uniform[36]; // tile 0 on every face, instances offset it to their block's tile
+#endif
 
   light_t sun = {
     .direction = {1, -1, -1},
     .color = 0xFFFFFFFF,  // White color (RGBA)
     .is_directional = true
   };
-
-  // Definition of cube vertices array
-  static float3 cube_vertices[36];
-
-  // Pre-computed UV coordinates for different tile types
-  static float2 cube_uvs_grass[36];   // tile_id = 3 (grass)
-  static float2 cube_uvs_stone[36];   // tile_id = 1 (stone)
-  static float2 cube_uvs_dirt[36];    // tile_id = 2 (dirt)
-  static float2 cube_uvs_sand[36];    // tile_id = 4 (sand)
-  static float2 cube_uvs_wood[36];    // tile_id = 5 (wood)
-  static float2 cube_uvs_leaf[36];    // tile_id = 6 (leaf)
-  static float2 cube_uvs_water[36];   // tile_id = 7 (water)
 };
 
 // Forward declarations for platform-specific functions
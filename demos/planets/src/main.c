@@ -100,10 +100,19 @@ void generate_background_texture(planet_t *p, int seed) {
   // Create new texture and fill with Perlin noise
   p->background_texture = (u32 *)malloc(WIN_WIDTH * WIN_HEIGHT * sizeof(u32));
 
+  // Star mask and nebula noise are evaluated a row at a time with the batch functions
+  float row_x[WIN_WIDTH], row_y[WIN_WIDTH], star_masks[WIN_WIDTH], nebula[WIN_WIDTH];
+
   for (int y = 0; y < WIN_HEIGHT; y++) {
+    for (int x = 0; x < WIN_WIDTH; x++) { row_x[x] = (float)x / WIN_WIDTH * 10.0f; row_y[x] = (float)y / WIN_HEIGHT * 10.0f; }
+    ridge_batch(row_x, row_y, star_masks, WIN_WIDTH, seed);
+
+    for (int x = 0; x < WIN_WIDTH; x++) { row_x[x] = (float)x / WIN_WIDTH * 4.0f; row_y[x] = (float)y / WIN_HEIGHT * 4.0f; }
+    fbm_batch(row_x, row_y, nebula, WIN_WIDTH, 5, seed);
+
     for (int x = 0; x < WIN_WIDTH; x++) {
       u8 brightness;
-      float star_mask = ridgeNoise((float)x / WIN_WIDTH * 10.0f, (float)y / WIN_HEIGHT * 10.0f, seed);
+      float star_mask = star_masks[x];
 
       if (star_mask > 0.995f) {
         float distance = rand_float_range(0.0f, 1.0f);
@@ -125,8 +134,7 @@ void generate_background_texture(planet_t *p, int seed) {
         continue;
       }
 
-      float noise_val = fbm((float)x / WIN_WIDTH * 4.0f, (float)y / WIN_HEIGHT * 4.0f, 5, seed);
-      noise_val = fmaxf(0.0f, fminf(1.0f, noise_val));
+      float noise_val = fmaxf(0.0f, fminf(1.0f, nebula[x]));
 
       brightness = (u8)(noise_val * 50); // Dark purple background
 
@@ -149,31 +157,40 @@ void generate_surface_texture(planet_t *p, int seed) {
   // Create new texture and fill with Perlin noise
   p->surface_texture = (u32 *)malloc(TEXTURE_SIZE * TEXTURE_SIZE * sizeof(u32));
 
+  // One row of noise is evaluated at a time with the batch functions, one array per layer
+  float x_coord[TEXTURE_SIZE], y_coord[TEXTURE_SIZE], scaled_x[TEXTURE_SIZE], scaled_y[TEXTURE_SIZE];
+  float base_terrain[TEXTURE_SIZE], detail_noise[TEXTURE_SIZE], ridge_peaks[TEXTURE_SIZE], fine_ridges[TEXTURE_SIZE];
+
   for (int y = 0; y < TEXTURE_SIZE; y++) {
     for (int x = 0; x < TEXTURE_SIZE; x++) {
       // Use polar coordinates for horizontal wrapping
       float angle = (float)x / TEXTURE_SIZE * 2.0f * M_PI;
-      float x_coord = cosf(angle) * 1.5f;
-      float y_coord = sinf(angle) * 1.5f + (float)y / TEXTURE_SIZE * 4.0f;
+      x_coord[x] = cosf(angle) * 1.5f;
+      y_coord[x] = sinf(angle) * 1.5f + (float)y / TEXTURE_SIZE * 4.0f;
+    }
 
-      // Layer 1: Large-scale landforms using FBM (soft rolling hills)
-      float base_terrain = fbm(x_coord * 0.4f, y_coord * 0.4f, 5, seed);
+    // Layer 1: Large-scale landforms using FBM (soft rolling hills)
+    for (int x = 0; x < TEXTURE_SIZE; x++) { scaled_x[x] = x_coord[x] * 0.4f; scaled_y[x] = y_coord[x] * 0.4f; }
+    fbm_batch(scaled_x, scaled_y, base_terrain, TEXTURE_SIZE, 5, seed);
 
-      // Layer 2: Mid-scale detail using Perlin noise (adds variation)
-      float detail_noise = noise2D(x_coord * 1.5f, y_coord * 1.5f, seed + 100);
+    // Layer 2: Mid-scale detail using Perlin noise (adds variation)
+    for (int x = 0; x < TEXTURE_SIZE; x++) { scaled_x[x] = x_coord[x] * 1.5f; scaled_y[x] = y_coord[x] * 1.5f; }
+    noise2D_batch(scaled_x, scaled_y, detail_noise, TEXTURE_SIZE, seed + 100);
 
-      // Layer 3: Sharp peaks using ridge noise (creates dramatic mountains)
-      float ridge_peaks = ridgeNoise(x_coord * 1.0f, y_coord * 1.0f, seed + 200);
+    // Layer 3: Sharp peaks using ridge noise (creates dramatic mountains)
+    ridge_batch(x_coord, y_coord, ridge_peaks, TEXTURE_SIZE, seed + 200);
 
-      // Layer 4: Fine-scale ridge detail
-      float fine_ridges = ridgeNoise(x_coord * 2.0f, y_coord * 2.0f, seed + 300);
+    // Layer 4: Fine-scale ridge detail
+    for (int x = 0; x < TEXTURE_SIZE; x++) { scaled_x[x] = x_coord[x] * 2.0f; scaled_y[x] = y_coord[x] * 2.0f; }
+    ridge_batch(scaled_x, scaled_y, fine_ridges, TEXTURE_SIZE, seed + 300);
 
+    for (int x = 0; x < TEXTURE_SIZE; x++) {
       // Composite the noise layers with strategic mixing - emphasize peaks and troughs
       // Base terrain with ocean bias (negative offset for more water)
-      float composite = base_terrain * 0.25f;           // 25% large-scale variation
-      composite += detail_noise * 0.15f;                // 15% mid-scale detail
-      composite += ridge_peaks * 0.35f;                 // 35% sharp peaks (increased)
-      composite += fine_ridges * 0.25f;                 // 25% fine detail (increased)
+      float composite = base_terrain[x] * 0.25f;        // 25% large-scale variation
+      composite += detail_noise[x] * 0.15f;             // 15% mid-scale detail
+      composite += ridge_peaks[x] * 0.35f;              // 35% sharp peaks (increased)
+      composite += fine_ridges[x] * 0.25f;              // 25% fine detail (increased)
 
       // Apply a slight compression to emphasize oceans and mountains
       composite -= 0.5f;  // Ocean bias - pushes baseline lower
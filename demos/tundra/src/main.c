@@ -16,6 +16,7 @@
 
 // Default values
 #define MAX_DEPTH (g_world_config.chunk_size * g_world_config.chunk_load_radius) - 1
+#define FRAME_ARENA_SIZE (256 * 1024) // per frame scratch, the skybox rows and visible chunk lists fit many times over
 
 typedef enum {
   GENERATE,
@@ -40,7 +41,6 @@ struct context_t {
   scene_t scene;
   const bool *keys;
 
-  model_t skybox_sphere;
   skybox_shader_args_t skybox_shader_args;
 
   float total_time;
@@ -92,7 +92,7 @@ static void apply_fps_movement(struct context_t *ctx, float dt) {
   // apply movement
   ctx->scene.camera_pos.position = float3_add(ctx->scene.camera_pos.position, movement);
   ctx->scene.controller.distance_walked = sqrtf((movement.x * movement.x) + (movement.z * movement.z));
-  float new_ground_height = get_interpolated_terrain_height(ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
+  float new_ground_height = get_terrain_height(&ctx->scene, ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
 
   // mouse input
   float mx, my;
@@ -108,22 +108,8 @@ static void apply_fps_movement(struct context_t *ctx, float dt) {
   update_camera(&ctx->renderer, &ctx->scene.camera_pos);
 }
 
-static float3 get_slope_normal(float x, float z, int seed) {
-  float hL = terrainHeight(x - EPSILON, z, seed);
-  float hR = terrainHeight(x + EPSILON, z, seed);
-  float hD = terrainHeight(x, z - EPSILON, seed);
-  float hU = terrainHeight(x, z + EPSILON, seed);
-
-  float dz_dx = (hR - hL) / (2.0f * EPSILON);
-  float dz_dz = (hU - hD) / (2.0f * EPSILON);
-
-  float3 normal = {-dz_dx, 1.0f, -dz_dz};
-
-  return float3_normalize(normal);
-}
-
 static void apply_ski_movement(struct context_t *ctx, float dt) {
-  float3 normal = get_slope_normal(ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z, g_world_config.seed);
+  float3 normal = get_terrain_normal(&ctx->scene, ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
   float3 gravity = { 0.0f, -24.f, 0.0f };
   float slope_dot = float3_dot(gravity, normal);
 
@@ -148,7 +134,7 @@ static void apply_ski_movement(struct context_t *ctx, float dt) {
   if (ctx->scene.camera_pos.pitch < ctx->scene.controller.min_pitch) ctx->scene.camera_pos.pitch = ctx->scene.controller.min_pitch;
   if (ctx->scene.camera_pos.pitch > ctx->scene.controller.max_pitch) ctx->scene.camera_pos.pitch = ctx->scene.controller.max_pitch;
 
-  float ground = get_interpolated_terrain_height(ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
+  float ground = get_terrain_height(&ctx->scene, ctx->scene.camera_pos.position.x, ctx->scene.camera_pos.position.z);
   ctx->scene.camera_pos.position.y = ground + ctx->scene.controller.camera_height_offset;
   ctx->scene.controller.ground_height = ground;
   update_camera(&ctx->renderer, &ctx->scene.camera_pos);
@@ -222,26 +208,6 @@ static void apply_ski_movement(struct context_t *ctx, float dt) {
   update_camera(&ctx->renderer, &ctx->scene.camera_pos);
 }
 
-static void regenerate_skybox_sphere(struct context_t *ctx) {
-  if (ctx->skybox_sphere.vertex_data) free(ctx->skybox_sphere.vertex_data);
-  if (ctx->skybox_sphere.face_normals) free(ctx->skybox_sphere.face_normals);
-  if (ctx->skybox_sphere.frag_shader) free(ctx->skybox_sphere.frag_shader);
-  ctx->skybox_sphere = (model_t){0};
-
-  f32 skybox_radius = ctx->renderer.max_depth * 0.95f;
-  generate_sphere(&ctx->skybox_sphere, skybox_radius, 32, 16, make_float3(0, 0, 0));
-
-  ctx->skybox_sphere.use_textures = true;  // CRITICAL: Enable UV interpolation
-  ctx->skybox_sphere.disable_behind_camera_culling = true; // Always render skybox triangles, even if "facing away" from camera
-  ctx->skybox_sphere.transform.pitch = M_PI / 2; // Rotate so that texture aligns correctly with world axes
-
-  // Setup skybox shader
-  ctx->skybox_sphere.frag_shader = malloc(sizeof(fragment_shader_t));
-  if (ctx->skybox_sphere.frag_shader) {
-    *ctx->skybox_sphere.frag_shader = make_fragment_shader(skybox_frag_shader_func, &ctx->skybox_shader_args, sizeof(skybox_shader_args_t));
-  }
-}
-
 static void on_generate(void *args, size_t size) {
   (void)size; // unused
   struct context_t *ctx = (struct context_t *)args;
@@ -284,9 +250,6 @@ static void on_normal_enter(void *args, size_t size) {
     .color = rgb_to_u32(200, 160, 160)
   };
 
-  // Regenerate skybox with new max_depth
-  regenerate_skybox_sphere(ctx);
-
   // Update camera with current position
   update_camera(&ctx->renderer, &ctx->scene.camera_pos);
 }
@@ -313,7 +276,6 @@ static void on_normal_tick(void *args, size_t size, float dt) {
   update_loaded_chunks(&ctx->scene);
 
   ctx->scene.sun.color = get_sun_color(ctx->total_time);
-  ctx->skybox_sphere.transform.position = ctx->scene.camera_pos.position; // Keep skybox centered on camera
 }
 
 static int on_normal_render(void *args, size_t size) {
@@ -322,12 +284,10 @@ static int on_normal_render(void *args, size_t size) {
 
   struct context_t *ctx = (struct context_t*)args;
 
-  // Render skybox sphere first (centered at camera)
-  transform_t skybox_transform = ctx->scene.camera_pos;
-  usize triangles_rendered = render_model(&ctx->renderer, &skybox_transform, &ctx->skybox_sphere, &ctx->scene.sun, 1);
+  usize triangles_rendered = render_loaded_chunks(&ctx->renderer, &ctx->scene, &ctx->scene.sun, 1);
 
-  // Render scene geometry (will overdraw skybox via depth test)
-  triangles_rendered += render_loaded_chunks(&ctx->renderer, &ctx->scene, &ctx->scene.sun, 1);
+  // Fill the pixels the terrain left uncovered, pushed out near max_depth so the fog below tints it
+  render_skybox(&ctx->renderer, &ctx->skybox_shader_args, ctx->renderer.max_depth * 0.95f);
 
   u8 fog_r, fog_g, fog_b;
   get_fog_color(ctx->total_time, &fog_r, &fog_g, &fog_b);
@@ -347,9 +307,6 @@ static void on_overhead_enter(void *args, size_t size) {
   ctx->scene.camera_pos.yaw = 0;
 
   ctx->renderer.max_depth = 500;
-
-  // Regenerate skybox with new max_depth
-  regenerate_skybox_sphere(ctx);
 }
 
 static void on_overhead_tick(void *args, size_t size, float dt) {
@@ -398,24 +355,46 @@ static state_interface_t overhead = {
 };
 
 // Regenerate skybox texture with time-based noise evolution
-void regenerate_skybox_texture(u32 *skybox_buffer, u32 width, u32 height, int base_seed, float time_offset) {
+void regenerate_skybox_texture(renderer_t *renderer, u32 *skybox_buffer, u32 width, u32 height, int base_seed, float time_offset) {
+  // One row of each noise layer at a time, evaluated with the batch functions
+  float *row = frame_alloc(renderer, 5 * width * sizeof(float));
+  bool scratch = row != NULL;
+  if (!row) row = malloc(5 * width * sizeof(float));
+  if (!row) return;
+
+  float *sample_x = row, *sample_y = row + width;
+  float *layer0 = row + 2 * width, *layer1 = row + 3 * width, *layer2 = row + 4 * width;
+
   for (unsigned int y = 0; y < height; y++) {
+    float v = (float)y / height;
+
+    // Sample Perlin noise with time-based offset for animation
+    // Layer multiple octaves at different scales for sharp cloud definition
+    for (unsigned int x = 0; x < width; x++) {
+      float u = (float)x / width;
+      sample_x[x] = u * 24.0f + time_offset * 0.3f;
+      sample_y[x] = v * 24.0f + time_offset * 0.2f;
+    }
+    noise2D_batch(sample_x, sample_y, layer0, width, base_seed);
+
+    for (unsigned int x = 0; x < width; x++) {
+      float u = (float)x / width;
+      sample_x[x] = u * 33.0f - time_offset * 0.15f;
+      sample_y[x] = v * 33.0f - time_offset * 0.1f;
+    }
+    noise2D_batch(sample_x, sample_y, layer1, width, base_seed + 100);
+
     for (unsigned int x = 0; x < width; x++) {
-      // Normalize coordinates to 0-1 range for noise sampling
       float u = (float)x / width;
-      float v = (float)y / height;
-
-      // Sample Perlin noise with time-based offset for animation
-      // Layer multiple octaves at different scales for sharp cloud definition
-      float noise_val = noise2D(u * 24.0f + time_offset * 0.3f,
-                                v * 24.0f + time_offset * 0.2f,
-                                base_seed);
-      noise_val += noise2D(u * 33.0f - time_offset * 0.15f,
-                          v * 33.0f - time_offset * 0.1f,
-                          base_seed + 100) * 0.4f;
-      noise_val += noise2D(u * 5.0f + time_offset * 0.1f,
-                          v * 5.0f + time_offset * 0.15f,
-                          base_seed + 200) * 0.3f;
+      sample_x[x] = u * 5.0f + time_offset * 0.1f;
+      sample_y[x] = v * 5.0f + time_offset * 0.15f;
+    }
+    noise2D_batch(sample_x, sample_y, layer2, width, base_seed + 200);
+
+    for (unsigned int x = 0; x < width; x++) {
+      float noise_val = layer0[x];
+      noise_val += layer1[x] * 0.4f;
+      noise_val += layer2[x] * 0.3f;
 
       // Map noise from [-1, 1] to [0, 1]
       float cloud_density = fminf(fmaxf((noise_val + 1.0f) * 0.5f, 0.0f), 1.0f);
@@ -436,6 +415,8 @@ void regenerate_skybox_texture(u32 *skybox_buffer, u32 width, u32 height, int ba
       skybox_buffer[y * width + x] = color;
     }
   }
+
+  if (!scratch) free(row);
 }
 
 int main(int argc, char const *argv[]) {
@@ -455,6 +436,7 @@ int main(int argc, char const *argv[]) {
   u32 *framebuffer = (u32 *)malloc(config_width * config_height * sizeof(u32));
   f32 *depth_buffer = (f32 *)malloc(config_width * config_height * sizeof(f32));
   u32 *skybox_buffer = (u32 *)malloc((config_width / 0.5) * (config_height / 0.5) * sizeof(u32));
+  void *frame_memory = malloc(FRAME_ARENA_SIZE);
 
   // Initialize state and window
   SDL_library_init(&sdl_window, &sdl_renderer, &sdl_framebuff, config_title, config_width, config_height, config_scale);
@@ -462,9 +444,10 @@ int main(int argc, char const *argv[]) {
 
   renderer_t renderer = {0};
   init_renderer(&renderer, config_width, config_height, 0, 0, framebuffer, depth_buffer, skybox_buffer, MAX_DEPTH);
+  set_frame_arena(&renderer, frame_memory, FRAME_ARENA_SIZE);
 
   // Initialize skybox texture with current time
-  regenerate_skybox_texture(skybox_buffer, config_width, config_height, g_world_config.seed, 0.0f);
+  regenerate_skybox_texture(&renderer, skybox_buffer, config_width, config_height, g_world_config.seed, 0.0f);
 
   performance_counter stats;
   init_performance_counter(&stats);
@@ -475,7 +458,7 @@ int main(int argc, char const *argv[]) {
   state_machine_t sm = {0};
   fsm_init(&sm, GENERATE, NUM_STATES);
 
-  // Create skybox shader args (will be used by regenerate_skybox_sphere)
+  // Panorama sampled by render_skybox each frame
   skybox_shader_args_t skybox_args = {
     .skybox_buffer = skybox_buffer,
     .width = config_width,
@@ -487,7 +470,6 @@ int main(int argc, char const *argv[]) {
     .depth_buffer = depth_buffer,
     .skybox_buffer = skybox_buffer,
     .renderer = renderer,
-    .skybox_sphere = {0},
     .skybox_shader_args = skybox_args,
 
     .keys = SDL_GetKeyboardState(NULL),
@@ -495,9 +477,6 @@ int main(int argc, char const *argv[]) {
     .total_time = 0.0f,
   };
 
-  // Generate initial skybox sphere
-  regenerate_skybox_sphere(&state_context);
-
   fsm_set_state_interface(&sm, GENERATE, &generate);
   fsm_set_state_interface(&sm, NORMAL, &normal);
   fsm_set_state_interface(&sm, OVERHEAD, &overhead);
@@ -536,7 +515,8 @@ int main(int argc, char const *argv[]) {
         }
 
         if (event.key.key == SDLK_1) {
-          renderer.wireframe_mode = !renderer.wireframe_mode;
+          // Cycle shaded -> edges -> hidden-line
+          renderer.wireframe_mode = (renderer.wireframe_mode + 1) % (WIREFRAME_HIDDEN_LINE + 1);
         }
       }
     }
@@ -549,6 +529,9 @@ int main(int argc, char const *argv[]) {
       stats.tps_counter++;
     }
 
+    // Per frame temporaries from here on come from the frame arena
+    begin_frame(&state_context.renderer);
+
     u32 background_color = rgb_to_u32(0, 0, 0);
 
     for(size_t i = 0; i < config_width * config_height; ++i) {
@@ -559,7 +542,7 @@ int main(int argc, char const *argv[]) {
     int triangles_rendered = fsm_render_state(&sm);
 
     // Regenerate skybox texture every frame for animation
-    regenerate_skybox_texture(skybox_buffer, config_width, config_height, g_world_config.seed, state_context.total_time);
+    regenerate_skybox_texture(&state_context.renderer, skybox_buffer, config_width, config_height, g_world_config.seed, state_context.total_time);
 
     SDL_UpdateTexture(sdl_framebuff, NULL, framebuffer, config_width * sizeof(u32));
     SDL_RenderTexture(sdl_renderer, sdl_framebuff, NULL, NULL);
@@ -573,6 +556,9 @@ int main(int argc, char const *argv[]) {
       printf("TPS: %lu, FPS: %lu, Triangles/frame: %lu, Player: (%.1f, %.1f, %.1f)\n",
               stats.tps_counter, stats.fps_counter, avg_triangles_per_frame,
               state_context.scene.camera_pos.position.x, state_context.scene.camera_pos.position.y, state_context.scene.camera_pos.position.z);
+      printf("Library memory: geometry %zu KiB, textures %zu KiB, scratch %zu KiB\n",
+              sw_memory_in_use(SW_MEMORY_GEOMETRY) / 1024, sw_memory_in_use(SW_MEMORY_TEXTURES) / 1024,
+              sw_memory_in_use(SW_MEMORY_SCRATCH) / 1024);
       stats.tps_counter = 0;
       stats.fps_counter = 0;
       stats.triangle_counter = 0;
@@ -580,17 +566,13 @@ int main(int argc, char const *argv[]) {
     }
   }
 
-  free_chunk_map(&state_context.scene.chunk_map);
+  free_scene(&state_context.scene);
   fsm_free(&sm);
 
-  // Cleanup skybox
-  if (state_context.skybox_sphere.vertex_data) free(state_context.skybox_sphere.vertex_data);
-  if (state_context.skybox_sphere.face_normals) free(state_context.skybox_sphere.face_normals);
-  if (state_context.skybox_sphere.frag_shader) free(state_context.skybox_sphere.frag_shader);
-
   free(framebuffer);
   free(depth_buffer);
   free(skybox_buffer);
+  free(frame_memory);
 
   SDL_DestroyTexture(sdl_framebuff);
   SDL_DestroyRenderer(sdl_renderer);
@@ -3,6 +3,7 @@
 
 #include <shader-works/maths.h>
 #include <shader-works/primitives.h>
+#include <shader-works/memory.h>
 
 #include "scene.h"
 
@@ -63,30 +64,95 @@ float get_interpolated_terrain_height(float x, float z) {
   return lerp(h0, h1, fz);
 }
 
-void generate_ground_plane(model_t *model, float2 size, float2 segment_size, float3 position) {
-  generate_plane(model, size, segment_size, position);
-  model->transform = (transform_t){0};
+// terrainHeight over arrays of positions, matching it sample for sample
+void sample_terrain_heights(const float *x, const float *z, float *heights, usize count, void *user) {
+  (void)user;
+
+  enum { BATCH = 64 };
+  float sx[BATCH], sz[BATCH], mountain_mask[BATCH], base[BATCH], ridge[BATCH];
+  int seed = g_world_config.seed;
+
+  for (usize start = 0; start < count; start += BATCH) {
+    usize n = count - start < BATCH ? count - start : BATCH;
+    const float *px = x + start, *pz = z + start;
+
+    // Scales are doubles in terrainHeight, keep them so the rounding matches
+    for (usize i = 0; i < n; ++i) { sx[i] = px[i] * 0.00525; sz[i] = pz[i] * 0.00525; }
+    ridge_batch(sx, sz, mountain_mask, n, seed);
 
-  for (usize i = 0; i < model->num_vertices; ++i) {
-    float3 *v = &model->vertex_data[i].position;
-    v->y = terrainHeight(v->x, v->z, g_world_config.seed);
+    for (usize i = 0; i < n; ++i) { sx[i] = px[i] * 0.000001; sz[i] = pz[i] * 0.000001; }
+    noise2D_batch(sx, sz, base, n, seed);
+
+    for (usize i = 0; i < n; ++i) { sx[i] = px[i] * 0.01; sz[i] = pz[i] * 0.01; }
+    ridge_batch(sx, sz, ridge, n, seed);
+
+    for (usize i = 0; i < n; ++i) {
+      float r = powf(ridge[i], 2.5f) * 55.f;
+      float height = (base[i] * 0.015f) + (r * mountain_mask[i]) - 3.f;
+      heights[start + i] = fmaxf(height, 0.0f);
+    }
   }
+}
 
-  // Recalculate face normals after terrain height modification
-  for (usize i = 0; i < model->num_faces; ++i) {
-    usize base_idx = i * 3;
-    float3 v0 = model->vertex_data[base_idx].position;
-    float3 v1 = model->vertex_data[base_idx + 1].position;
-    float3 v2 = model->vertex_data[base_idx + 2].position;
+// Lays a chunk's ground plane over its heightfield, square segments segment_size units wide centred on position
+// The model's buffers are reused while *capacity vertices are enough, so a chunk only reallocates the first time it
+// gets finer than it has been, and heights come from the field rather than the noise functions
+// Returns 0 on success, -1 on allocation failure with the model left as it was
+int build_ground_plane(model_t *model, usize *capacity, const heightfield_t *field, float size, float segment_size, float3 position) {
+  usize segs = (usize)(size / segment_size);
+  if (segs == 0) segs = 1;
+
+  usize num_vertices = segs * segs * 6;
+  if (num_vertices > *capacity) {
+    vertex_data_t *vertices = sw_realloc(model->vertex_data, num_vertices * sizeof(vertex_data_t), SW_MEMORY_GEOMETRY);
+    if (!vertices) return -1;
+    model->vertex_data = vertices;
+
+    float3 *normals = sw_realloc(model->face_normals, (num_vertices / 3) * sizeof(float3), SW_MEMORY_GEOMETRY);
+    if (!normals) return -1;
+    model->face_normals = normals;
+
+    *capacity = num_vertices;
+  }
+
+  // Same layout as generate_plane, two triangles per quad: TL -> BL -> TR and TR -> BL -> BR
+  static const int corner_x[6] = {0, 0, 1, 1, 0, 1};
+  static const int corner_z[6] = {0, 1, 0, 0, 1, 1};
+
+  float step = size / segs;
+  float sx = position.x - size * 0.5f, sz = position.z - size * 0.5f;
+  bool use_field = field && field->heights;
+
+  usize v = 0;
+  for (usize z = 0; z < segs; ++z) {
+    for (usize x = 0; x < segs; ++x) {
+      for (int c = 0; c < 6; ++c, ++v) {
+        usize gx = x + corner_x[c], gz = z + corner_z[c];
+        float px = sx + gx * step, pz = sz + gz * step;
+        float py = use_field ? heightfield_height(field, px, pz) : terrainHeight(px, pz, g_world_config.seed);
+
+        model->vertex_data[v].position = make_float3(px, py, pz);
+        model->vertex_data[v].uv = make_float2((float)gx / segs, (float)gz / segs);
+      }
+    }
+  }
 
-    float3 edge1 = float3_sub(v1, v0);
-    float3 edge2 = float3_sub(v2, v0);
+  model->num_vertices = num_vertices;
+  model->num_faces = num_vertices / 3;
+  model->scale = make_float3(1.0f, 1.0f, 1.0f);
+  model->transform = (transform_t){0};
+
+  // Flat shaded, every corner takes its face's normal
+  for (usize i = 0; i < model->num_faces; ++i) {
+    vertex_data_t *tri = &model->vertex_data[i * 3];
+    float3 edge1 = float3_sub(tri[1].position, tri[0].position);
+    float3 edge2 = float3_sub(tri[2].position, tri[0].position);
 
     model->face_normals[i] = float3_normalize(float3_cross(edge2, edge1));
+    tri[0].normal = tri[1].normal = tri[2].normal = model->face_normals[i];
   }
 
-  // Recalculate vertex normals after terrain height modification
-  for (usize i = 0; i < model->num_vertices; ++i) {
-    model->vertex_data[i].normal = model->face_normals[i / 3];
-  }
+  // Heights moved every vertex, refit the bounds used for whole-chunk culling
+  compute_model_bounds(model);
+  return 0;
 }
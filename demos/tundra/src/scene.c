@@ -8,15 +8,20 @@
 #include <SDL3/SDL.h>
 #include <shader-works/renderer.h>
 #include <shader-works/maths.h>
+#include <shader-works/shading_cache.h>
 
 #include "common/noise.h"
+#include "common/job_queue.h"
 
 extern fragment_shader_t ground_shadow_frag;
+extern fragment_shader_t ground_cached_frag;
+extern u32 ground_albedo_func(u32 input, fragment_context_t *ctx, void *args, usize argc);
 
 // Function to set scene data for shadow calculations (defined in shaders.c)
 extern void set_shadow_scene(scene_t *scene);
 
-extern void generate_ground_plane(model_t *, float2, float2, float3);  // in proc_gen.c
+extern int build_ground_plane(model_t *, usize *, const heightfield_t *, float, float, float3);  // in proc_gen.c
+extern void sample_terrain_heights(const float *x, const float *z, float *heights, usize count, void *user);  // in proc_gen.c
 
 /**
  * returns Level of detail based off the passed distance
@@ -55,31 +60,75 @@ static int get_lod_from_dist(int dist_sq) {
   return 20;
 }
 
-static void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z, float player_x, float player_z) {
-  if (chunk == NULL) return;
-
-  chunk->x = chunk_x;
-  chunk->z = chunk_z;
-  chunk->ground_plane = (model_t){0};
+// Baked ground texels per world unit, the gravel pattern is 0.25 units wide
+// The cache is mapped over the plane's UVs, which no LOD changes, so it is baked once at the density near chunks need
+#define GROUND_TEXEL_DENSITY 4
 
+// LOD a chunk should be generated at for the given viewer position
+static int get_chunk_lod(int chunk_x, int chunk_z, float player_x, float player_z) {
   float world_x = chunk_x * g_world_config.chunk_size + g_world_config.half_chunk_size;
   float world_z = chunk_z * g_world_config.chunk_size + g_world_config.half_chunk_size;
-  float corner_x = world_x;
-  float corner_z = world_z;
 
   int dx = player_x - world_x;
   int dz = player_z - world_z;
 
-  int dist_sq = (dx * dx) + (dz * dz);
+  return get_lod_from_dist((dx * dx) + (dz * dz));
+}
+
+// World position at the middle of a chunk's ground plane, which sits half a chunk off the chunk grid
+static float3 get_ground_plane_center(const chunk_t *chunk) {
+  float offset = g_world_config.half_chunk_size + g_world_config.half_chunk_size;
+  return make_float3(chunk->x * g_world_config.chunk_size + offset, 0, chunk->z * g_world_config.chunk_size + offset);
+}
+
+// Bytes of a chunk's memory block, everything generate_chunk carves from the arena with room for alignment
+static usize get_chunk_memory_size(void) {
+  usize samples = (usize)(g_world_config.chunk_size + 1) * (g_world_config.chunk_size + 1);
+  usize padded = (usize)(g_world_config.chunk_size + 3) * (g_world_config.chunk_size + 5);
+  usize texels = (usize)(g_world_config.chunk_size * GROUND_TEXEL_DENSITY) * (g_world_config.chunk_size * GROUND_TEXEL_DENSITY);
+
+  usize size = sizeof(arena_t);
+  size += samples * (sizeof(float) + sizeof(float3));         // heightfield
+  size += padded * sizeof(float);                             // heightfield build temporaries
+  size += texels * (sizeof(u32) + 1);                         // shading cache and its coverage mask
+  size += sizeof(model_t) + 36 * sizeof(vertex_data_t) + 12 * sizeof(float3); // point of interest cube
+
+  return size + 16 * SW_MEMORY_ALIGNMENT;
+}
+
+// Builds the models of chunk->x, chunk->z at chunk->lod, only reads the world config so it is safe on a worker thread
+static void generate_chunk(chunk_t *chunk) {
+  if (chunk == NULL) return;
+
+  // The plane's vertex buffers come from the heap so LOD changes can grow them, its shading cache from the arena
+  chunk->ground_plane = (model_t){ .arena = chunk->arena };
+  chunk->ground_capacity = 0;
+
+  float corner_x = chunk->x * g_world_config.chunk_size + g_world_config.half_chunk_size;
+  float corner_z = chunk->z * g_world_config.chunk_size + g_world_config.half_chunk_size;
 
-  chunk->lod = get_lod_from_dist(dist_sq);
+  // One sample per world unit under the ground plane, a failed allocation leaves the field empty and queries fall back to noise
+  init_heightfield(&chunk->heightfield, chunk->arena, corner_x, corner_z, g_world_config.chunk_size, g_world_config.chunk_size, sample_terrain_heights, NULL);
 
-  generate_ground_plane(&chunk->ground_plane, make_float2(g_world_config.chunk_size, g_world_config.chunk_size), make_float2(chunk->lod, chunk->lod), make_float3(corner_x + g_world_config.half_chunk_size, 0, corner_z + g_world_config.half_chunk_size));
+  if (build_ground_plane(&chunk->ground_plane, &chunk->ground_capacity, &chunk->heightfield, g_world_config.chunk_size, chunk->lod, get_ground_plane_center(chunk)) != 0) {
+    chunk->ground_plane.num_vertices = 0;
+  }
   chunk->ground_plane.frag_shader = &ground_shadow_frag;
 
+  // Bake the ground's noise once here rather than per pixel every frame, lighting and tree shadows stay per pixel
+  fragment_shader_t albedo = { .func = ground_albedo_func, .argv = &chunk->heightfield, .argc = sizeof(heightfield_t), .valid = true };
+  u32 texels = (u32)(g_world_config.chunk_size * GROUND_TEXEL_DENSITY);
+  if (chunk->ground_plane.num_vertices > 0 && bake_shading_cache(&chunk->ground_plane, &albedo, texels, texels) == 0) {
+    chunk->ground_plane.frag_shader = &ground_cached_frag;
+  }
+
   // generate points of interest
-  if (ridgeNoise(chunk_x, chunk_z, g_world_config.seed) > 0.95f) {
-    chunk->static_objs = calloc(1, sizeof(model_t));
+  if (ridgeNoise(chunk->x, chunk->z, g_world_config.seed) > 0.95f) {
+    chunk->static_objs = arena_alloc(chunk->arena, sizeof(model_t));
+    if (!chunk->static_objs) chunk->static_objs = malloc(sizeof(model_t));
+    if (!chunk->static_objs) return;
+
+    *chunk->static_objs = (model_t){ .arena = chunk->arena };
     chunk->num_static_objs = 1;
 
     float obj_x = (chunk->x * g_world_config.chunk_size) + ((hash2(chunk->x, chunk->z, g_world_config.seed) + 1) * g_world_config.chunk_size);
@@ -93,22 +142,139 @@ static void generate_chunk(chunk_t *chunk, int chunk_x, int chunk_z, float playe
   }
 }
 
-static void validate_lod_level(scene_t *scene, chunk_map_node_t *node) {
-  chunk_t chunk = node->chunk;
-  float chunk_world_x = (float)(chunk.x * g_world_config.chunk_size) + g_world_config.half_chunk_size;
-  float chunk_world_z = (float)(chunk.z * g_world_config.chunk_size) + g_world_config.half_chunk_size;
-  float dx = scene->camera_pos.position.x - chunk_world_x;
-  float dz = scene->camera_pos.position.z - chunk_world_z;
+// job_func for the chunk queue, arg is a malloc'd chunk_t with its coordinates and lod filled in
+static void generate_chunk_job(void *arg) {
+  generate_chunk((chunk_t *)arg);
+}
+
+// job_func for results nobody will collect
+static void discard_chunk_job(void *arg) {
+  free_chunk((chunk_t *)arg);
+  free(arg);
+}
+
+// World bounds of everything a chunk renders
+static void get_chunk_bounds(const chunk_t *chunk, float3 *min, float3 *max) {
+  get_model_world_bounds(&chunk->ground_plane, min, max);
+
+  for (usize i = 0; i < chunk->num_static_objs; ++i) {
+    float3 obj_min, obj_max;
+    get_model_world_bounds(&chunk->static_objs[i], &obj_min, &obj_max);
+    *min = make_float3(fminf(min->x, obj_min.x), fminf(min->y, obj_min.y), fminf(min->z, obj_min.z));
+    *max = make_float3(fmaxf(max->x, obj_max.x), fmaxf(max->y, obj_max.y), fmaxf(max->z, obj_max.z));
+  }
+}
+
+// Where tree i of chunk_x, chunk_z stands
+static float2 get_tree_position(int chunk_x, int chunk_z, usize i) {
+  float world_x = chunk_x * g_world_config.chunk_size;
+  float world_z = chunk_z * g_world_config.chunk_size;
+
+  return make_float2(
+    map_range(hash2(chunk_x * 100 + i, chunk_z * 100 + i * 3, g_world_config.seed), -1.0f, 1.0f, world_x + 2, world_x + g_world_config.chunk_size - 2),
+    map_range(hash2(chunk_z * 100 + i * 7, chunk_x * 100 + i * 5, g_world_config.seed), -1.0f, 1.0f, world_z + 2, world_z + g_world_config.chunk_size - 2)
+  );
+}
+
+// Replaces the shadow casters of a chunk with its current trees
+static void register_tree_shadows(scene_t *scene, const chunk_t *chunk) {
+  if (!scene->tree_shadows.cells) return;
+
+  remove_shadow_casters(&scene->tree_shadows, chunk->x, chunk->z);
+
+  for (usize i = 0; i < chunk->num_trees; ++i) {
+    if (chunk->trees[i].num_vertices == 0) continue;
+
+    float2 pos = get_tree_position(chunk->x, chunk->z, i);
+    add_shadow_caster(&scene->tree_shadows, chunk->x, chunk->z, pos.x, pos.y, TREE_SHADOW_RADIUS);
+  }
+}
+
+// Unregisters a chunk from the culling hierarchy, call before the map frees it
+static void drop_chunk_bounds(scene_t *scene, chunk_t *chunk) {
+  if (chunk->bvh_proxy >= 0) bvh_remove(&scene->chunk_bvh, chunk->bvh_proxy);
+  chunk->bvh_proxy = -1;
+}
+
+// Queues generation of a node's chunk at lod, the node stays unloaded until the result is published
+static void request_chunk(scene_t *scene, chunk_map_node_t *node, int lod) {
+  chunk_t *job = malloc(sizeof(chunk_t));
+  if (!job) return;
+
+  *job = (chunk_t){ .x = node->chunk.x, .z = node->chunk.z, .lod = lod, .bvh_proxy = -1 };
+
+  // The worker owns the block's arena until the chunk is published, a chunk without one falls back to the heap
+  void *block = scene->chunk_memory.block_size ? pool_alloc(&scene->chunk_memory) : NULL;
+  if (block) {
+    job->arena = block;
+    job->memory_pool = &scene->chunk_memory;
+    init_arena_from(job->arena, (u8 *)block + sizeof(arena_t), scene->chunk_memory.block_size - sizeof(arena_t));
+  }
+
+  // Queue full, the chunk is requested again next tick
+  if (!job_queue_push(&scene->chunk_jobs, generate_chunk_job, job)) {
+    free_chunk(job);
+    free(job);
+    return;
+  }
+
+  node->chunk.pending_lod = lod;
+}
+
+// Swaps finished chunks into the map and registers them with the culling hierarchy
+static void publish_finished_chunks(scene_t *scene) {
+  void *finished[CHUNK_JOB_CAPACITY];
+  usize count = job_queue_collect(&scene->chunk_jobs, finished, CHUNK_JOB_CAPACITY);
+
+  for (usize i = 0; i < count; ++i) {
+    chunk_t *generated = (chunk_t *)finished[i];
+    chunk_map_node_t *node = chunk_lookup(&scene->chunk_map, generated->x, generated->z);
+
+    // Unloaded while in flight, or superseded by a newer request
+    if (!node || node->chunk.pending_lod != generated->lod) {
+      discard_chunk_job(generated);
+      continue;
+    }
+
+    drop_chunk_bounds(scene, &node->chunk);
+    free_chunk(&node->chunk);
+
+    node->chunk = *generated;
+    node->loaded = true;
+    free(generated);
+
+    float3 min, max;
+    get_chunk_bounds(&node->chunk, &min, &max);
+    node->chunk.bvh_proxy = bvh_insert(&scene->chunk_bvh, min, max, &node->chunk);
+
+    register_tree_shadows(scene, &node->chunk);
+  }
+}
+
+// Rebuilds a loaded chunk's ground plane at lod in place, from the heightfield it was generated with
+// The buffers, shading cache and trees stay, so a LOD change neither touches the noise functions nor, past the first
+// time a chunk reaches a level, the allocator
+static void set_chunk_lod(scene_t *scene, chunk_t *chunk, int lod) {
+  if (build_ground_plane(&chunk->ground_plane, &chunk->ground_capacity, &chunk->heightfield, g_world_config.chunk_size, lod, get_ground_plane_center(chunk)) != 0) {
+    return; // Could not grow, keep the current level and retry next tick
+  }
 
-  float dist_sq = (dx * dx) + (dz * dz);
-  if (get_lod_from_dist(dist_sq) != chunk.lod) {
-    int chunk_x = chunk.x, chunk_z = chunk.z;
-    remove_chunk(&scene->chunk_map, chunk_x, chunk_z);
+  chunk->lod = lod;
+
+  if (chunk->bvh_proxy >= 0) {
+    float3 min, max;
+    get_chunk_bounds(chunk, &min, &max);
+    bvh_refit(&scene->chunk_bvh, chunk->bvh_proxy, min, max);
+  }
+}
 
-    chunk = (chunk_t){0};
+// The map moves chunks when it grows or fills the gap of a removed one, point every leaf back at its chunk
+static void relink_chunk_bounds(scene_t *scene) {
+  chunk_map_t *map = &scene->chunk_map;
 
-    generate_chunk(&chunk, chunk_x, chunk_z, scene->camera_pos.position.x, scene->camera_pos.position.z);
-    insert_chunk(&scene->chunk_map, &chunk);
+  for (usize i = 0; i < map->capacity; ++i) {
+    chunk_t *chunk = &map->nodes[i].chunk;
+    if (map->keys[i].used && chunk->bvh_proxy >= 0) scene->chunk_bvh.nodes[chunk->bvh_proxy].user = chunk;
   }
 }
 
@@ -148,130 +314,171 @@ void init_scene(scene_t *scene, usize max_loaded_chunks) {
   scene->camera_pos = (transform_t){ 0 };
   scene->fog_start = 0.85;
 
-  init_chunk_map(&scene->chunk_map, CHUNK_MAP_NUM_BUCKETS);
+  init_chunk_map(&scene->chunk_map, CHUNK_MAP_INITIAL_CAPACITY);
+  init_bvh(&scene->chunk_bvh, 2 * g_world_config.max_chunks);
+
+  // Loaded chunks plus slack for the ones waiting to unload and the border cells shadows reach into
+  if (init_caster_grid(&scene->tree_shadows, g_world_config.chunk_size, 2 * g_world_config.chunk_load_radius + 5) != 0) {
+    fprintf(stderr, "Failed to allocate the tree shadow grid, trees will cast no shadows\n");
+  }
+
+  // Texels about half a world unit wide over the loaded area
+  if (init_shadow_map(&scene->sun_shadows, SUN_SHADOW_MAP_SIZE, 0.5f) != 0) {
+    fprintf(stderr, "Failed to allocate the sun shadow map, objects will cast no shadows\n");
+  }
+
+  // Chunk memory comes back whole when a chunk unloads, so streaming reuses the same blocks instead of the heap
+  if (init_pool(&scene->chunk_memory, get_chunk_memory_size(), 16) != 0) {
+    fprintf(stderr, "Failed to set up the chunk memory pool, chunks will allocate from the heap\n");
+  }
+
+  if (init_job_queue(&scene->chunk_jobs, CHUNK_WORKER_COUNT, CHUNK_JOB_CAPACITY) != 0) {
+    fprintf(stderr, "Failed to start chunk workers, generating chunks on the main thread\n");
+    init_job_queue(&scene->chunk_jobs, 0, CHUNK_JOB_CAPACITY);
+  }
+}
+
+void free_scene(scene_t *scene) {
+  if (!scene) return;
+
+  // Workers go first, they may still be writing chunks the map no longer knows about
+  free_job_queue(&scene->chunk_jobs, discard_chunk_job);
+  free_chunk_map(&scene->chunk_map);
+  free_bvh(&scene->chunk_bvh);
+  free_caster_grid(&scene->tree_shadows);
+  free_shadow_map(&scene->sun_shadows);
+  free_pool(&scene->chunk_memory); // last, the chunks freed above hand their blocks back to it
+}
+
+// Heightfield of the loaded chunk whose ground plane covers x, z
+static const heightfield_t *find_heightfield(const scene_t *scene, float x, float z) {
+  if (!scene) return NULL;
+
+  // Ground planes are offset half a chunk from the chunk grid, see generate_chunk
+  int chunk_x = (int)floorf((x - g_world_config.half_chunk_size) / g_world_config.chunk_size);
+  int chunk_z = (int)floorf((z - g_world_config.half_chunk_size) / g_world_config.chunk_size);
+
+  chunk_map_node_t *node = chunk_lookup((chunk_map_t *)&scene->chunk_map, chunk_x, chunk_z);
+  if (!node || !node->loaded || !node->chunk.heightfield.heights) return NULL;
+
+  return &node->chunk.heightfield;
+}
+
+float get_terrain_height(const scene_t *scene, float x, float z) {
+  const heightfield_t *field = find_heightfield(scene, x, z);
+  return field ? heightfield_height(field, x, z) : terrainHeight(x, z, g_world_config.seed);
+}
+
+float3 get_terrain_normal(const scene_t *scene, float x, float z) {
+  const heightfield_t *field = find_heightfield(scene, x, z);
+  if (field) return heightfield_normal(field, x, z);
+
+  int seed = g_world_config.seed;
+  float dh_dx = (terrainHeight(x + EPSILON, z, seed) - terrainHeight(x - EPSILON, z, seed)) / (2.0f * EPSILON);
+  float dh_dz = (terrainHeight(x, z + EPSILON, seed) - terrainHeight(x, z - EPSILON, seed)) / (2.0f * EPSILON);
+
+  return float3_normalize(make_float3(-dh_dx, 1.0f, -dh_dz));
+}
+
+// Whether a chunk dx, dz chunks from the player's is kept loaded, a circle so cull_chunk and the request loop agree
+static bool chunk_in_load_radius(int dx, int dz) {
+  int radius = g_world_config.chunk_load_radius;
+  return dx * dx + dz * dz <= radius * radius;
 }
 
 bool cull_chunk(chunk_t *chunk, void *param, usize num_params) {
   (void)num_params;
   if (!chunk || !param) return true;
 
-  transform_t *player = (transform_t*)param;
+  scene_t *scene = (scene_t*)param;
+  transform_t *player = &scene->camera_pos;
 
   // Calculate player's chunk coordinates (handle negative coordinates properly)
   int player_chunk_x = (int)floorf(player->position.x / g_world_config.chunk_size);
   int player_chunk_z = (int)floorf(player->position.z / g_world_config.chunk_size);
 
-  int dx = chunk->x - player_chunk_x;
-  int dz = chunk->z - player_chunk_z;
-
-  float dist = sqrtf((dx * dx) + (dz * dz));
-
-  if (dist <= g_world_config.chunk_load_radius)
+  if (chunk_in_load_radius(chunk->x - player_chunk_x, chunk->z - player_chunk_z))
     return false;
 
+  drop_chunk_bounds(scene, chunk); // about to be freed by remove_chunk_if
+  remove_shadow_casters(&scene->tree_shadows, chunk->x, chunk->z);
   return true;
 }
 
 void update_loaded_chunks(scene_t *scene) {
-  remove_chunk_if(&scene->chunk_map, cull_chunk, &scene->camera_pos, 1);
+  remove_chunk_if(&scene->chunk_map, cull_chunk, scene, 1);
 
-  int player_chunk_x = (int)floorf(scene->camera_pos.position.x / g_world_config.chunk_size);
-  int player_chunk_z = (int)floorf(scene->camera_pos.position.z / g_world_config.chunk_size);
+  float player_x = scene->camera_pos.position.x;
+  float player_z = scene->camera_pos.position.z;
+  int player_chunk_x = (int)floorf(player_x / g_world_config.chunk_size);
+  int player_chunk_z = (int)floorf(player_z / g_world_config.chunk_size);
 
   for (int dx = -g_world_config.chunk_load_radius; dx <= g_world_config.chunk_load_radius; dx++) {
     for (int dz = -g_world_config.chunk_load_radius; dz <= g_world_config.chunk_load_radius; dz++) {
+      // Corners of the square would be culled again next frame, leaving workers generating throwaway chunks
+      if (!chunk_in_load_radius(dx, dz)) continue;
+
       int chunk_x = player_chunk_x + dx;
       int chunk_z = player_chunk_z + dz;
 
-      if (!is_chunk_loaded(&scene->chunk_map, chunk_x, chunk_z)) {
-        chunk_t new_chunk = {0};
-        generate_chunk(&new_chunk, chunk_x, chunk_z, scene->camera_pos.position.x, scene->camera_pos.position.z);
-        insert_chunk(&scene->chunk_map, &new_chunk);
-      } else {
-        validate_lod_level(scene, chunk_lookup(&scene->chunk_map, chunk_x, chunk_z));
-      }
-    }
-  }
-}
+      chunk_map_node_t *node = chunk_lookup(&scene->chunk_map, chunk_x, chunk_z);
+      if (!node) node = reserve_chunk(&scene->chunk_map, chunk_x, chunk_z);
+      if (!node) continue;
 
-typedef struct {
-  chunk_t *chunk;
-  float distance;
-} chunk_distance_t;
+      // One request in flight per chunk
+      if (node->chunk.pending_lod != 0) continue;
 
-static int compare_chunks_by_distance(const void *a, const void *b) {
-  const chunk_distance_t *chunk_a = (const chunk_distance_t*)a;
-  const chunk_distance_t *chunk_b = (const chunk_distance_t*)b;
+      // New chunks are generated on the workers, loaded ones change level in place
+      int lod = get_chunk_lod(chunk_x, chunk_z, player_x, player_z);
+      if (!node->loaded) request_chunk(scene, node, lod);
+      else if (node->chunk.lod != lod) set_chunk_lod(scene, &node->chunk, lod);
+    }
+  }
 
-  if (chunk_a->distance < chunk_b->distance) return -1;
-  if (chunk_a->distance > chunk_b->distance) return 1;
-  return 0;
+  publish_finished_chunks(scene);
+  relink_chunk_bounds(scene);
 }
 
-usize render_loaded_chunks(renderer_t *restrict state, scene_t *restrict scene, light_t *restrict lights, const usize num_lights) {
-  set_shadow_scene(scene);
+// Draws every loaded point of interest into the sun's shadow map around the camera and hands it to the shaders
+static void render_sun_shadows(renderer_t *state, scene_t *scene) {
+  if (!scene->sun_shadows.depth) return;
 
-  chunk_t **chunks = calloc(g_world_config.max_chunks, sizeof(chunk_t*));
-  usize chunk_count = 0;
-  usize total_triangles_rendered = 0;
+  begin_shadow_map(&scene->sun_shadows, &scene->sun, scene->camera_pos.position, g_world_config.chunk_size * g_world_config.chunk_load_radius);
 
-  get_all_chunks(&scene->chunk_map, chunks, &chunk_count);
+  chunk_map_t *map = &scene->chunk_map;
+  for (usize i = 0; i < map->capacity; ++i) {
+    if (!map->keys[i].used || !map->nodes[i].loaded) continue;
 
-  if (chunk_count == 0) {
-    free(chunks);
-    return 0;
+    chunk_t *chunk = &map->nodes[i].chunk;
+    for (usize j = 0; j < chunk->num_static_objs; ++j) {
+      if (chunk->static_objs[j].vertex_data != NULL) render_model_shadow(state, &scene->sun_shadows, &chunk->static_objs[j]);
+    }
   }
 
-  chunk_distance_t *sorted_chunks = calloc(chunk_count, sizeof(chunk_distance_t));
+  set_shadow_map(state, &scene->sun_shadows);
+}
 
-  float2 camera_pos = make_float2(scene->camera_pos.position.x, scene->camera_pos.position.z);
-  for (usize i = 0; i < chunk_count; i++) {
-    if (chunks[i]) {
-      float2 chunk_center = make_float2(
-        chunks[i]->x * g_world_config.chunk_size + g_world_config.half_chunk_size,
-        chunks[i]->z * g_world_config.chunk_size + g_world_config.half_chunk_size
-      );
+usize render_loaded_chunks(renderer_t *restrict state, scene_t *restrict scene, light_t *restrict lights, const usize num_lights) {
+  set_shadow_scene(scene);
+  render_sun_shadows(state, scene);
 
-      float distance = float2_magnitude(float2_sub(camera_pos, chunk_center));
+  if (scene->chunk_bvh.leaf_count == 0) return 0;
 
-      sorted_chunks[i].chunk = chunks[i];
-      sorted_chunks[i].distance = distance;
-    }
-  }
+  // Only chunks inside the view frustum come back, nearest first so closer terrain fills the depth buffer early
+  usize visible_size = scene->chunk_bvh.leaf_count * sizeof(bvh_draw_item_t);
+  bvh_draw_item_t *visible = frame_alloc(state, visible_size);
+  bool scratch = visible != NULL;
+  if (!visible) visible = malloc(visible_size);
+  if (!visible) return 0;
 
-  // Get camera forward vector (player looks in -Z direction)
-  float3 right, up, forward;
-  transform_get_basis_vectors(&scene->camera_pos, &right, &up, &forward);
-
-  qsort(sorted_chunks, chunk_count, sizeof(chunk_distance_t), compare_chunks_by_distance);
-  for (usize i = 0; i < chunk_count; i++) {
-    if (sorted_chunks[i].chunk) {
-      // Calculate vector from camera to chunk center
-      float3 chunk_center = make_float3(
-        sorted_chunks[i].chunk->x * g_world_config.chunk_size + g_world_config.half_chunk_size,
-        0,
-        sorted_chunks[i].chunk->z * g_world_config.chunk_size + g_world_config.half_chunk_size
-      );
-      float3 to_chunk = float3_sub(chunk_center, scene->camera_pos.position);
-
-      // Check if we're in overhead mode (pitch near -PI/2)
-      bool is_overhead = fabsf(scene->camera_pos.pitch + PI / 2) < 0.1f;
-
-      // Dot product with forward vector (negative because forward is -Z)
-      // If dot < 0, chunk is behind the camera (except in overhead mode)
-      // Add chunk_size buffer to account for chunk size and avoid culling visible chunks
-      float dot = is_overhead ? 1.0f : float3_dot(to_chunk, forward);
-      if (dot > g_world_config.chunk_size * 1.1) {
-        // Chunk is fully behind the player, skip rendering
-        continue;
-      }
-
-      total_triangles_rendered += render_chunk(state, sorted_chunks[i].chunk, &scene->camera_pos, lights, num_lights, scene);
-    }
+  usize visible_count = bvh_cull(&scene->chunk_bvh, state, &scene->camera_pos, visible, scene->chunk_bvh.leaf_count);
+
+  usize total_triangles_rendered = 0;
+  for (usize i = 0; i < visible_count; i++) {
+    total_triangles_rendered += render_chunk(state, (chunk_t *)visible[i].user, &scene->camera_pos, lights, num_lights, scene);
   }
 
-  free(chunks);
-  free(sorted_chunks);
+  if (!scratch) free(visible);
 
   return total_triangles_rendered;
 }
@@ -4,9 +4,19 @@
 #include <shader-works/renderer.h>
 #include <shader-works/primitives.h>
 #include <shader-works/maths.h>
+#include <shader-works/bvh.h>
+#include <shader-works/shadow_map.h>
+#include <shader-works/memory.h>
 
+#include "common/caster_grid.h"
 #include "common/chunk_map.h"
 #include "common/config.h"
+#include "common/job_queue.h"
+
+#define CHUNK_WORKER_COUNT 2   // threads generating chunk meshes off the main thread
+#define CHUNK_JOB_CAPACITY 64  // chunk requests in flight at once, the rest wait for a later tick
+#define TREE_SHADOW_RADIUS 1.8f // radius of the disc of ground each tree darkens
+#define SUN_SHADOW_MAP_SIZE 512 // texels along each side of the sun's shadow map
 
 typedef struct {
   float move_speed;
@@ -30,6 +40,11 @@ typedef struct scene_t {
   fps_controller_t controller;
 
   chunk_map_t chunk_map;
+  bvh_t chunk_bvh;      // bounds of every loaded chunk, queried for the visible ones each frame
+  job_queue_t chunk_jobs; // chunks being generated on worker threads, published by update_loaded_chunks
+  caster_grid_t tree_shadows; // tree shadow discs of the loaded chunks, read by the ground shaders
+  shadow_map_t sun_shadows;   // depth of the points of interest seen from the sun, redrawn every frame
+  pool_t chunk_memory;        // one block per chunk holding its arena, only touched on the main thread
   light_t sun;
   float fog_start;
 } scene_t;
@@ -41,7 +56,13 @@ extern float get_interpolated_terrain_height(float x, float z);
 
 // Implementation found in scene.c
 void init_scene(scene_t *scene, usize max_loaded_chunks);
+void free_scene(scene_t *scene);
 void update_loaded_chunks(scene_t *scene);
+
+// Terrain height and surface normal at a world position, read from the loaded chunk's heightfield
+// and evaluated from the noise functions where no chunk is loaded yet
+float get_terrain_height(const scene_t *scene, float x, float z);
+float3 get_terrain_normal(const scene_t *scene, float x, float z);
 usize render_loaded_chunks(renderer_t *restrict state, scene_t *restrict scene, light_t *restrict lights, const usize num_lights);
 
 // Implementation found in shaders.c
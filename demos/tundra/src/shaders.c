@@ -7,7 +7,7 @@
 #include <stdio.h>
 #include "scene.h"
 
-#include "common/chunk_map.h"
+#include "common/heightfield.h"
 #include "common/noise.h"
 
 u32 rgb_to_u32(u8 r, u8 g, u8 b) {
@@ -40,49 +40,11 @@ u32 tree_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
 static bool point_in_tree_shadow(float3 world_pos, scene_t *scene) {
   if (!scene) return false;
 
-  // Check current and neighboring chunks for tree shadows
-  for (int dx = -1; dx <= 1; dx++) {
-    for (int dz = -1; dz <= 1; dz++) {
-      int chunk_x = (int)floorf(world_pos.x / g_world_config.chunk_size) + dx;
-      int chunk_z = (int)floorf(world_pos.z / g_world_config.chunk_size) + dz;
-
-      chunk_map_node_t *node = chunk_lookup((chunk_map_t*)&scene->chunk_map, chunk_x, chunk_z);
-      if (!node || !node->loaded) continue;
-
-      chunk_t *chunk = &node->chunk;
-
-      // Check all trees in this chunk
-      for (usize i = 0; i < chunk->num_trees; i++) {
-        if (chunk->trees[i].num_vertices == 0) continue;
-
-        // Recalculate tree position using same method as generation
-        float world_x = chunk_x * g_world_config.chunk_size;
-        float world_z = chunk_z * g_world_config.chunk_size;
-        float tree_x = map_range(hash2(chunk_x * 100 + i, chunk_z * 100 + i * 3, g_world_config.seed), -1.0f, 1.0f, world_x + 2, world_x + g_world_config.chunk_size - 2);
-        float tree_z = map_range(hash2(chunk_z * 100 + i * 7, chunk_x * 100 + i * 5, g_world_config.seed), -1.0f, 1.0f, world_z + 2, world_z + g_world_config.chunk_size - 2);
-
-        // Simple circular shadow check
-        float tree_dx = world_pos.x - tree_x;
-        float tree_dz = world_pos.z - tree_z;
-        float dist_sq = tree_dx * tree_dx + tree_dz * tree_dz;
-
-        if (dist_sq < 3.24f) { // 1.8 * 1.8 = 3.24
-          return true;
-        }
-      }
-    }
-  }
-
-  return false;
+  return point_in_caster_shadow(&scene->tree_shadows, world_pos.x, world_pos.z);
 }
 
-// Shadow-enabled ground shader
-u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
-  (void)input;
-
-  // Get the actual terrain height at this world position
-  float terrain_height = get_interpolated_terrain_height(ctx->world_pos.x, ctx->world_pos.z);
-
+// Unlit ground color: lake ice, shore gravel or snow by terrain height, rock where the surface normal is steep
+static u32 ground_albedo(const fragment_context_t *ctx, float terrain_height, float3 normal) {
   u32 base_color;
 
   // Frozen lake ice texture
@@ -164,17 +126,39 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
     base_color = rgb_to_u32(r, g, b);
   }
 
-  if (fabsf(ctx->normal.y) < 0.7f ) {
+  if (fabsf(normal.y) < 0.7f ) {
     base_color = rgb_to_u32(100, 100, 100);
   }
 
+  return base_color;
+}
+
+// Ground albedo over one chunk, baked into the chunk's shading cache on the worker that generates it
+// args: the chunk's heightfield_t, read instead of the chunk map since the chunk is not published yet
+u32 ground_albedo_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input; (void)argc;
+
+  const heightfield_t *field = (const heightfield_t *)args;
+  float terrain_height = field && heightfield_contains(field, ctx->world_pos.x, ctx->world_pos.z)
+                       ? heightfield_height(field, ctx->world_pos.x, ctx->world_pos.z)
+                       : terrainHeight(ctx->world_pos.x, ctx->world_pos.z, g_world_config.seed);
+
+  // The cache outlives LOD changes (see set_chunk_lod), so classify rock by the heightfield rather than the
+  // normals of whichever mesh the chunk was baked at
+  float3 normal = field ? heightfield_normal(field, ctx->world_pos.x, ctx->world_pos.z) : ctx->normal;
+
+  return ground_albedo(ctx, terrain_height, normal);
+}
+
+// Light a ground color and darken it under trees
+static u32 shade_ground(u32 base_color, fragment_context_t *ctx, void *args, usize argc) {
   u32 lit_color = default_lighting_frag_shader.func(base_color, ctx, NULL, 0);
 
-  // Apply tree shadows if scene data is available
+  // Apply tree and sun shadows if scene data is available
   if (args && argc > 0) {
     scene_t *scene = (scene_t*)args;
 
-    if (point_in_tree_shadow(ctx->world_pos, scene)) {
+    if (point_in_tree_shadow(ctx->world_pos, scene) || shadow_map_occluded(ctx->shadow_map, ctx->world_pos)) {
       // Darken the pixel by 50%
       u8 shadow_r, shadow_g, shadow_b;
       u32_to_rgb(lit_color, &shadow_r, &shadow_g, &shadow_b);
@@ -188,6 +172,21 @@ u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize arg
   return lit_color;
 }
 
+// Shadow-enabled ground shader
+u32 ground_shadow_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  (void)input;
+
+  // Get the actual terrain height at this world position
+  float terrain_height = get_terrain_height((const scene_t *)args, ctx->world_pos.x, ctx->world_pos.z);
+
+  return shade_ground(ground_albedo(ctx, terrain_height, ctx->normal), ctx, args, argc);
+}
+
+// Ground shader for chunks with a baked shading cache, input is the albedo sampled from it
+u32 ground_cached_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+  return shade_ground(input, ctx, args, argc);
+}
+
 // Global scene pointer for shadow calculations
 static scene_t *g_scene_for_shadows = NULL;
 
@@ -198,6 +197,7 @@ u32 white_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc)
 }
 
 fragment_shader_t ground_shadow_frag = { .func = ground_shadow_func, .argv = NULL, .argc = 0, .valid = true };
+fragment_shader_t ground_cached_frag = { .func = ground_cached_func, .argv = NULL, .argc = 0, .valid = true };
 fragment_shader_t tree_frag = { .func = tree_frag_func, .argv = NULL, .argc = 0, .valid = true};
 fragment_shader_t white_frag = { .func = white_frag_func, .argv = NULL, .argc = 0, .valid = true};
 
@@ -207,4 +207,6 @@ void set_shadow_scene(scene_t *scene) {
   // Update the shader arguments to point to the scene
   ground_shadow_frag.argv = g_scene_for_shadows;
   ground_shadow_frag.argc = sizeof(scene_t);
+  ground_cached_frag.argv = g_scene_for_shadows;
+  ground_cached_frag.argc = sizeof(scene_t);
 }
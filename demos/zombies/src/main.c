@@ -19,6 +19,8 @@
 #define WIN_TITLE "zombies"
 #define MAX_DEPTH 32.f
 
+void init_post_processing(renderer_t *state);
+
 renderer_t renderer_state = { 0 };
 bool mouse_captured = true;
 
@@ -67,6 +69,7 @@ int main(int argc, char const *argv[]) {
 
   sys_init(&window, &renderer, &fb_tex, &mouse_captured);
   init_renderer(&renderer_state, WIN_WIDTH, WIN_HEIGHT, 0, 0, framebuffer, depthbuffer, NULL, MAX_DEPTH);
+  init_post_processing(&renderer_state);
 
   fsm_init(&game_state, STATE_GENERATE_MAP, STATE_NUM_STATES);
   fsm_set_state_interface(&game_state, STATE_GENERATE_MAP, &generate_map_state);
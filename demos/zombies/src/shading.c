@@ -6,6 +6,7 @@
 #include <shader-works/renderer.h>
 #include <shader-works/maths.h>
 #include <shader-works/shaders.h>
+#include <shader-works/post_process.h>
 
 #include "common/noise.h"
 
@@ -106,15 +107,27 @@ void apply_dust_particles(renderer_t *state, world_t *world, transform_t *cam) {
   }
 }
 
-extern renderer_t renderer_state;
+// Fog and dither run once per screen pixel after the world is drawn, instead of per fragment
+static post_process_chain_t post_chain;
 
-u32 light_and_dither_frag(u32 input, fragment_context_t *ctx, void *args, usize argc) {
+void init_post_processing(renderer_t *state) {
+  set_fog_lut(state, 5, state->max_depth, 47, 20, 60);
+  set_dither_lut(state, 8.0f);
+
+  init_post_process_chain(&post_chain);
+  post_chain.clear_depth = state->max_depth; // main clears the depth buffer to MAX_DEPTH
+  add_post_process_pass(&post_chain, fog_pass, NULL);
+  add_post_process_pass(&post_chain, dither_pass, NULL);
+}
+
+void apply_post_processing(renderer_t *state) {
+  apply_post_process_chain(state, &post_chain);
+}
+
+u32 entity_lighting_frag(u32 input, fragment_context_t *ctx, void *args, usize argc) {
   UNUSED(args); UNUSED(argc);
 
-  // Lighting and Dither
-  u32 lit = default_lighting_frag_shader.func(input, ctx, default_lighting_frag_shader.argv, default_lighting_frag_shader.argc);
-  lit = apply_fog_to_pixel(&renderer_state, lit, (int)ctx->screen_pos.x, (int)ctx->screen_pos.y, ctx->depth, 5, renderer_state.max_depth, 47, 20, 60);
-  return apply_dither_u32(lit, ctx->screen_pos, 8.0f);
+  return default_lighting_frag_shader.func(input, ctx, default_lighting_frag_shader.argv, default_lighting_frag_shader.argc);
 }
 
 u32 ground_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc) {
@@ -147,9 +160,7 @@ u32 ground_frag_func(u32 input, fragment_context_t *ctx, void *args, usize argc)
   u8 g = 0;
   u8 b = (u8)(160.0f * intensity);
 
-  u32 lit = default_lighting_frag_shader.func(rgb_to_u32(r, g, b), ctx, default_lighting_frag_shader.argv, default_lighting_frag_shader.argc);
-  lit = apply_fog_to_pixel(&renderer_state, lit, (int)ctx->screen_pos.x, (int)ctx->screen_pos.y, ctx->depth, 5, renderer_state.max_depth, 47, 20, 60);
-  return apply_dither_u32(lit, ctx->screen_pos, 8.0f);
+  return default_lighting_frag_shader.func(rgb_to_u32(r, g, b), ctx, default_lighting_frag_shader.argv, default_lighting_frag_shader.argc);
 }
 
 fragment_shader_t ground_shader = {
@@ -159,9 +170,9 @@ fragment_shader_t ground_shader = {
   .func = ground_frag_func
 };
 
-fragment_shader_t light_and_dither = {
+fragment_shader_t entity_lighting = {
   .valid = true,
   .argc = 0,
   .argv = NULL,
-  .func = light_and_dither_frag
+  .func = entity_lighting_frag
 };
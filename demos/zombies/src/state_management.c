@@ -14,6 +14,7 @@
 
 void init_particles(world_t *world, transform_t *cam);
 void apply_dust_particles(renderer_t *state, world_t *world, transform_t *cam);
+void apply_post_processing(renderer_t *state);
 
 extern renderer_t renderer_state;
 
@@ -89,6 +90,7 @@ int normal_state_render(void *state, size_t size) {
   UNUSED(state); UNUSED(size);
 
   render_world(&renderer_state, &world, &camera);
+  apply_post_processing(&renderer_state);
   apply_dust_particles(&renderer_state, &world, &camera);
   return 0;
 }
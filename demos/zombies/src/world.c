@@ -5,10 +5,11 @@
 
 #include <SDL3/SDL.h>
 #include <shader-works/maths.h>
+#include <shader-works/lod.h>
 
 #include "world.h"
 
-extern fragment_shader_t light_and_dither;
+extern fragment_shader_t entity_lighting;
 extern fragment_shader_t ground_shader;
 extern renderer_t renderer_state;
 
@@ -54,9 +55,9 @@ void init_world(world_t *world) {
   world->num_lights = 0;
   world->entities = calloc(MAX_ENTITIES, sizeof(entity_t));
   world->num_entities = 0;
+  world->enemy_mesh = NULL;
   world->entity_bodies = calloc(MAX_ENTITIES + 1, sizeof(physics_body_t *));
   world->entity_bodies[MAX_ENTITIES] = NULL; // Last body reserved for player
-  world->entity_bodies[MAX_ENTITIES]->type = TYPE_PLAYER;
 }
 
 void delete_world(world_t *world) {
@@ -77,10 +78,14 @@ void delete_world(world_t *world) {
   }
 
   if (world->entities) {
+    for (usize i = 0; i < world->num_entities; ++i) delete_model(&world->entities[i].mesh);
     free(world->entities);
     world->num_entities = 0;
   }
 
+  release_shared_mesh(world->enemy_mesh);
+  world->enemy_mesh = NULL;
+
   if (world->entity_bodies) {
     free(world->entity_bodies);
   }
@@ -262,7 +267,22 @@ static void process_wall_side(world_t *world, sector_t *s, direction_t side, flo
   #undef SPAWN_WALL
 }
 
+// The skeleton mesh, atlas UVs and LODs are built once and every enemy draws the same copy
+static shared_mesh_t *get_enemy_mesh(world_t *world) {
+  if (!world->enemy_mesh) {
+    world->enemy_mesh = load_shared_mesh("res/skeleton.obj", true);
+    if (!world->enemy_mesh) return NULL;
+
+    model_t *skeleton = &world->enemy_mesh->model;
+    generate_model_uvs_from_atlas(skeleton, renderer_state.atlas_dim, make_float2(32.0f, 0.0f), make_float2(32.0f, 32.0f));
+    generate_model_lods(skeleton, 2, 0.5f); // after the UVs, levels copy them
+  }
+
+  return world->enemy_mesh;
+}
+
 static void add_entities(world_t *world) {
+  shared_mesh_t *enemy_mesh = get_enemy_mesh(world);
   sector_t *head = world->sectors;
   while (head) {
     if (world->num_entities < MAX_ENTITIES && rand() % 2 == 0) {
@@ -275,12 +295,12 @@ static void add_entities(world_t *world) {
       new_entity->body.radius = 0.5f;
       new_entity->body.floor_offset = 1.0f; // Enemy center, not
       new_entity->body.position = (float3){ head->x + x_off, head->floor_height + new_entity->body.floor_offset, head->z + z_off };
-      load_obj_model(&new_entity->mesh, "res/skeleton.obj", new_entity->body.position, 0.5f, true);
-
-      generate_model_uvs_from_atlas(&new_entity->mesh, renderer_state.atlas_dim, make_float2(32.0f, 0.0f), make_float2(32.0f, 32.0f));
+      if (enemy_mesh) init_model_from_shared_mesh(&new_entity->mesh, enemy_mesh);
+      new_entity->mesh.scale = make_float3(0.5f, 0.5f, 0.5f);
+      new_entity->mesh.transform.position = new_entity->body.position;
 
       new_entity->mesh.vertex_shader = &default_vertex_shader;
-      new_entity->mesh.frag_shader = &light_and_dither;
+      new_entity->mesh.frag_shader = &entity_lighting;
       new_entity->target_pos = new_entity->body.position;
       new_entity->body.active = true;
       new_entity->body.type = TYPE_ENEMY;
@@ -528,22 +548,172 @@ void tick_entities(world_t *world, fps_controller_t *controller, float delta_tim
   }
 }
 
-void render_world(renderer_t *renderer, world_t *world, transform_t *camera) {
-  sector_t *sector = world->sectors;
-  while (sector) {
-    render_model(renderer, camera, &sector->floor, world->lights, world->num_lights);
-    render_model(renderer, camera, &sector->ceiling, world->lights, world->num_lights);
+#define MAX_PORTAL_DEPTH 16
+#define PORTAL_NEAR_PLANE 0.05f   // view distance portal outlines are clipped against
+#define PORTAL_NEAR_MARGIN 0.25f  // closer than this to a portal, its neighbor inherits the whole window
+
+// Screen space rectangle that everything seen through a chain of portals must fall inside
+typedef struct {
+  float x0, y0, x1, y1;
+} portal_window_t;
+
+// Renders a sector's own geometry, once per frame however many portals lead to it
+static void render_sector(renderer_t *renderer, world_t *world, sector_t *sector, transform_t *camera) {
+  if (sector->visited) return;
+  sector->visited = true;
+
+  render_model(renderer, camera, &sector->floor, world->lights, world->num_lights);
+  render_model(renderer, camera, &sector->ceiling, world->lights, world->num_lights);
+
+  for (usize i = 0; i < sector->num_walls && sector->num_walls > 0; i++) {
+    if (sector->walls[i].num_vertices > 0) {
+      render_model(renderer, camera, &sector->walls[i], world->lights, world->num_lights);
+    }
+  }
+}
+
+// Projects a portal quad to screen and narrows the window to its bounds
+// Returns false if the portal is outside the window or behind the camera
+static bool clip_portal_window(renderer_t *renderer, transform_t *camera, const float3 corners[4], portal_window_t *window) {
+  // Corners in view space, where the camera looks down -Z
+  float3 view[4];
+  for (int i = 0; i < 4; i++) {
+    float3 d = float3_sub(corners[i], camera->position);
+    view[i] = make_float3(float3_dot(d, renderer->cam_right), float3_dot(d, renderer->cam_up), float3_dot(d, renderer->cam_forward));
+  }
+
+  // Clip the outline against the near plane, a quad gains at most one vertex
+  float3 clipped[5];
+  int count = 0;
+  for (int i = 0; i < 4; i++) {
+    float3 a = view[i], b = view[(i + 1) % 4];
+    bool a_in = a.z <= -PORTAL_NEAR_PLANE, b_in = b.z <= -PORTAL_NEAR_PLANE;
+
+    if (a_in) clipped[count++] = a;
+    if (a_in != b_in) {
+      float t = (-PORTAL_NEAR_PLANE - a.z) / (b.z - a.z);
+      clipped[count++] = float3_lerp(a, b, t);
+    }
+  }
+  if (count < 3) return false;
+
+  portal_window_t bounds = { renderer->screen_dim.x, renderer->screen_dim.y, 0.0f, 0.0f };
+  for (int i = 0; i < count; i++) {
+    float scale = renderer->projection_scale / clipped[i].z;
+    float sx = renderer->screen_dim.x * 0.5f + clipped[i].x * scale;
+    float sy = renderer->screen_dim.y * 0.5f + clipped[i].y * scale;
+    bounds.x0 = fminf(bounds.x0, sx);
+    bounds.y0 = fminf(bounds.y0, sy);
+    bounds.x1 = fmaxf(bounds.x1, sx);
+    bounds.y1 = fmaxf(bounds.y1, sy);
+  }
+
+  window->x0 = fmaxf(window->x0, bounds.x0);
+  window->y0 = fmaxf(window->y0, bounds.y0);
+  window->x1 = fminf(window->x1, bounds.x1);
+  window->y1 = fminf(window->y1, bounds.y1);
+  return window->x0 < window->x1 && window->y0 < window->y1;
+}
+
+// Renders a sector, then recurses into every neighbor whose shared opening is visible through window
+// A sector reached again is only traversed when the new window reaches outside the ones it was already entered
+// through, and then through their union, so the work is bounded by sectors and neighbors rather than by paths
+static void render_through_portals(renderer_t *renderer, world_t *world, sector_t *sector, transform_t *camera, portal_window_t window, int depth) {
+  if (sector->visited) {
+    bool covered = window.x0 >= sector->portal_x0 && window.y0 >= sector->portal_y0 &&
+                   window.x1 <= sector->portal_x1 && window.y1 <= sector->portal_y1;
+    if (covered && depth >= sector->portal_depth) return;
+
+    window.x0 = fminf(window.x0, sector->portal_x0);
+    window.y0 = fminf(window.y0, sector->portal_y0);
+    window.x1 = fmaxf(window.x1, sector->portal_x1);
+    window.y1 = fmaxf(window.y1, sector->portal_y1);
+    if (sector->portal_depth < depth) depth = sector->portal_depth;
+  }
+
+  sector->portal_x0 = window.x0;
+  sector->portal_y0 = window.y0;
+  sector->portal_x1 = window.x1;
+  sector->portal_y1 = window.y1;
+  sector->portal_depth = depth;
+
+  render_sector(renderer, world, sector, camera);
+  if (depth >= MAX_PORTAL_DEPTH) return;
+
+  float3 cam = camera->position;
 
-    for (usize i = 0; i < sector->num_walls && sector->num_walls > 0; i++) {
-      if (sector->walls[i].num_vertices > 0) {
-        render_model(renderer, camera, &sector->walls[i], world->lights, world->num_lights);
+  for (direction_t side = DIR_NORTH; side <= DIR_WEST; side++) {
+    sector_t *n = find_neighbor(world, sector, side);
+    if (!n) continue;
+
+    // The opening both sectors share, matching the gap process_wall_side leaves between wings, header and footer
+    bool is_horizontal = side == DIR_NORTH || side == DIR_SOUTH;
+    float start = is_horizontal ? fmaxf(sector->x, n->x) : fmaxf(sector->z, n->z);
+    float end = is_horizontal ? fminf(sector->x + sector->w, n->x + n->w) : fminf(sector->z + sector->d, n->z + n->d);
+    float bottom = (float)(sector->floor_height > n->floor_height ? sector->floor_height : n->floor_height);
+    float top = (float)(sector->ceiling_height < n->ceiling_height ? sector->ceiling_height : n->ceiling_height);
+    if (start >= end || bottom >= top) continue;
+
+    float plane = 0.0f, cam_along = 0.0f, cam_across = 0.0f, outward = 0.0f;
+    switch (side) {
+      case DIR_NORTH: plane = sector->z + sector->d; cam_across = cam.z; cam_along = cam.x; outward = 1.0f; break;
+      case DIR_SOUTH: plane = sector->z;             cam_across = cam.z; cam_along = cam.x; outward = -1.0f; break;
+      case DIR_EAST:  plane = sector->x + sector->w; cam_across = cam.x; cam_along = cam.z; outward = 1.0f; break;
+      case DIR_WEST:  plane = sector->x;             cam_across = cam.x; cam_along = cam.z; outward = -1.0f; break;
+    }
+
+    // Only portals leading away from the camera can show anything new, this also stops cycles
+    float distance = (plane - cam_across) * outward;
+    if (distance <= 0.0f) continue;
+
+    portal_window_t next = window;
+    bool straddling = distance < PORTAL_NEAR_MARGIN && cam_along > start && cam_along < end;
+    if (!straddling) {
+      float3 corners[4];
+      if (is_horizontal) {
+        corners[0] = make_float3(start, bottom, plane);
+        corners[1] = make_float3(end, bottom, plane);
+        corners[2] = make_float3(end, top, plane);
+        corners[3] = make_float3(start, top, plane);
+      } else {
+        corners[0] = make_float3(plane, bottom, start);
+        corners[1] = make_float3(plane, bottom, end);
+        corners[2] = make_float3(plane, top, end);
+        corners[3] = make_float3(plane, top, start);
       }
+
+      if (!clip_portal_window(renderer, camera, corners, &next)) continue;
+    }
+
+    render_through_portals(renderer, world, n, camera, next, depth + 1);
+  }
+}
+
+// Renders the sectors visible from the camera's sector through chains of portals, and the entities inside them
+void render_world(renderer_t *renderer, world_t *world, transform_t *camera) {
+  sector_t *start = point_in_sector(world, camera->position, NULL);
+
+  if (start) {
+    portal_window_t screen = { 0.0f, 0.0f, renderer->screen_dim.x, renderer->screen_dim.y };
+    render_through_portals(renderer, world, start, camera, screen, 0);
+  } else {
+    // Outside the map (e.g. noclip), nothing to traverse from so draw every sector
+    for (sector_t *sector = world->sectors; sector; sector = sector->next) {
+      render_sector(renderer, world, sector, camera);
     }
+  }
 
-    for (usize i = 0; i < world->num_entities && world->num_entities > 0; i++) {
+  // Each entity once, if the sector it stands in was reached
+  // Entities without a sector can't be placed in the traversal, so they are drawn as before it existed
+  for (usize i = 0; i < world->num_entities; i++) {
+    sector_t *sector = world->entities[i].body.current_sector;
+    if (!sector || sector->visited) {
       render_model(renderer, camera, &world->entities[i].mesh, world->lights, world->num_lights);
     }
+  }
 
-    sector = sector->next;
+  // visited is shared with the AI path search, which expects it clear
+  for (sector_t *sector = world->sectors; sector; sector = sector->next) {
+    sector->visited = false;
   }
 }
@@ -2,6 +2,7 @@
 #define __WORLD_H__
 
 #include <shader-works/renderer.h>
+#include <shader-works/shared_mesh.h>
 
 #define MAX_LIGHTS 5
 #define MAX_ENTITIES 8
@@ -27,6 +28,11 @@ typedef struct sector_t {
   model_t floor, ceiling;
   struct sector_t *next, *prev;
   bool visited; // For portal rendering
+
+  // Portal rendering: bounds of every screen window the sector was entered through this frame, and the shallowest
+  // portal depth it was reached at, valid while visited is set
+  float portal_x0, portal_y0, portal_x1, portal_y1;
+  int portal_depth;
 } sector_t;
 
 typedef struct {
@@ -70,6 +76,7 @@ typedef struct {
   light_t *lights;
   entity_t *entities;
   physics_body_t **entity_bodies;
+  shared_mesh_t *enemy_mesh; // skeleton every enemy draws, loaded with the first enemy
 
   usize num_sectors, num_lights, num_entities;
 } world_t;
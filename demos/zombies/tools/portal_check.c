@@ -0,0 +1,123 @@
+// Portal culling check
+// Renders random camera placements on random maps twice, once through render_world's portal traversal and once
+// drawing every sector and entity, and compares the frames. Culling must only skip what can't be seen
+// Run from the directory holding res/, exits non-zero when any placement differs
+// Usage: zombies_portal_check [placements] [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shader-works/renderer.h>
+
+#include "common/util.h"
+
+#include "world.h"
+
+#define WIN_WIDTH 320
+#define WIN_HEIGHT 155
+#define MAX_DEPTH 32.f
+#define PLACEMENTS_PER_MAP 50
+
+// world.c reads the atlas size from the demo's renderer
+renderer_t renderer_state = { 0 };
+
+static u32 framebuffer[WIN_WIDTH * WIN_HEIGHT], portal_frame[WIN_WIDTH * WIN_HEIGHT];
+static f32 depthbuffer[WIN_WIDTH * WIN_HEIGHT];
+
+static float random_range(float min, float max) {
+  return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static void clear_frame(void) {
+  for (int i = 0; i < WIN_WIDTH * WIN_HEIGHT; i++) {
+    framebuffer[i] = 0;
+    depthbuffer[i] = MAX_DEPTH;
+  }
+}
+
+// The ground shader scrolls with the renderer's clock, which moves between the two renders of a placement
+// Plain lighting keeps both frames comparable without changing what is drawn where
+static void freeze_sector_shaders(world_t *world) {
+  for (sector_t *sector = world->sectors; sector; sector = sector->next) {
+    sector->floor.frag_shader = &default_lighting_frag_shader;
+    sector->ceiling.frag_shader = &default_lighting_frag_shader;
+    for (usize i = 0; i < sector->num_walls; i++) sector->walls[i].frag_shader = &default_lighting_frag_shader;
+  }
+}
+
+// The frame render_world would draw without any culling
+static void render_everything(world_t *world, transform_t *camera) {
+  for (sector_t *sector = world->sectors; sector; sector = sector->next) {
+    render_model(&renderer_state, camera, &sector->floor, world->lights, world->num_lights);
+    render_model(&renderer_state, camera, &sector->ceiling, world->lights, world->num_lights);
+    for (usize i = 0; i < sector->num_walls; i++) {
+      if (sector->walls[i].num_vertices > 0) render_model(&renderer_state, camera, &sector->walls[i], world->lights, world->num_lights);
+    }
+  }
+
+  for (usize i = 0; i < world->num_entities; i++) {
+    render_model(&renderer_state, camera, &world->entities[i].mesh, world->lights, world->num_lights);
+  }
+}
+
+int main(int argc, char const *argv[]) {
+  int placements = argc > 1 ? atoi(argv[1]) : 300;
+  unsigned seed = argc > 2 ? (unsigned)atoi(argv[2]) : 1;
+  srand(seed);
+
+  init_renderer(&renderer_state, WIN_WIDTH, WIN_HEIGHT, 0, 0, framebuffer, depthbuffer, NULL, MAX_DEPTH);
+
+  u32 atlas_w, atlas_h;
+  if (!load_bmp_texture("res/base.bmp", &atlas_w, &atlas_h, &renderer_state.texture_atlas)) {
+    fprintf(stderr, "Failed to load res/base.bmp, run from the zombies binary directory\n");
+    return 1;
+  }
+  renderer_state.atlas_dim.x = (float)atlas_w;
+  renderer_state.atlas_dim.y = (float)atlas_h;
+
+  world_t world;
+  int failed = 0;
+
+  for (int i = 0; i < placements; i++) {
+    if (i % PLACEMENTS_PER_MAP == 0) {
+      if (i > 0) delete_world(&world);
+      init_world(&world);
+      generate_random_map(&world, MAX_LIGHTS + 10);
+      finalize_world_geometry(&world);
+      freeze_sector_shaders(&world);
+    }
+
+    // Eye height somewhere inside a random sector, looking anywhere but straight up or down
+    sector_t *sector = world.sectors;
+    for (int skip = rand() % (int)world.num_sectors; skip > 0 && sector->next; skip--) sector = sector->next;
+
+    transform_t camera = { 0 };
+    camera.position = make_float3(random_range(sector->x + 0.2f, sector->x + sector->w - 0.2f), sector->floor_height + 2.0f,
+                                  random_range(sector->z + 0.2f, sector->z + sector->d - 0.2f));
+    camera.yaw = random_range(0.0f, 2.0f * PI);
+    camera.pitch = random_range(-PI / 2 + 0.1f, PI / 2 - 0.1f);
+    update_camera(&renderer_state, &camera);
+
+    clear_frame();
+    render_world(&renderer_state, &world, &camera);
+    memcpy(portal_frame, framebuffer, sizeof(framebuffer));
+
+    clear_frame();
+    render_everything(&world, &camera);
+
+    int differing = 0;
+    for (int p = 0; p < WIN_WIDTH * WIN_HEIGHT; p++) differing += portal_frame[p] != framebuffer[p];
+
+    if (differing) {
+      printf("Placement %d differs in %d pixels: position (%.2f, %.2f, %.2f), yaw %.3f, pitch %.3f\n", i, differing,
+             camera.position.x, camera.position.y, camera.position.z, camera.yaw, camera.pitch);
+      failed++;
+    }
+  }
+
+  if (placements > 0) delete_world(&world);
+
+  printf("%d of %d placements match drawing every sector\n", placements - failed, placements);
+  return failed ? 1 : 0;
+}
@@ -41,8 +41,10 @@ static void system_poll_events(game_state_t* state) {
       }
 
       if (event.key.key == SDLK_W) {
-        state->renderer_state.wireframe_mode = !state->renderer_state.wireframe_mode;
-        printf("Wireframe mode: %s\n", state->renderer_state.wireframe_mode ? "ON" : "OFF");
+        // Cycle shaded -> edges -> hidden-line
+        static const char *mode_names[] = { "OFF", "EDGES", "HIDDEN LINE" };
+        state->renderer_state.wireframe_mode = (state->renderer_state.wireframe_mode + 1) % (WIREFRAME_HIDDEN_LINE + 1);
+        printf("Wireframe mode: %s\n", mode_names[state->renderer_state.wireframe_mode]);
       }
     }
   }
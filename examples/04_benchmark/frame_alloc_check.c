@@ -0,0 +1,151 @@
+// Steady frame allocation check
+// Renders a lit sphere with per frame scratch from the frame arena and a fog and dither chain, counting every
+// call into the library's allocator. After a few warm-up frames the counters must not move
+// Exits non-zero when a steady frame allocates
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shader-works/memory.h>
+#include <shader-works/post_process.h>
+#include <shader-works/primitives.h>
+#include <shader-works/renderer.h>
+
+#define WIN_WIDTH 320
+#define WIN_HEIGHT 240
+#define MAX_DEPTH 100
+#define FRAME_ARENA_SIZE (64 * 1024)
+#define WARMUP_FRAMES 5
+#define STEADY_FRAMES 100
+
+// The library expects the client to provide these
+u32 rgb_to_u32(u8 r, u8 g, u8 b) {
+  return (r << 24) | (g << 16) | (b << 8) | 0xFF;
+}
+
+void u32_to_rgb(u32 color, u8 *r, u8 *g, u8 *b) {
+  *r = (color >> 24) & 0xFF;
+  *g = (color >> 16) & 0xFF;
+  *b = (color >> 8) & 0xFF;
+}
+
+// Calls that reached the allocator, independent of the library's own stats
+static u64 alloc_calls, realloc_calls, free_calls;
+
+static void *counting_alloc(usize size, void *user) {
+  (void)user;
+  ++alloc_calls;
+  return malloc(size);
+}
+
+static void *counting_realloc(void *ptr, usize size, void *user) {
+  (void)user;
+  ++realloc_calls;
+  return realloc(ptr, size);
+}
+
+static void counting_free(void *ptr, void *user) {
+  (void)user;
+  ++free_calls;
+  free(ptr);
+}
+
+static void render_frame(renderer_t *state, transform_t *camera, model_t *sphere, light_t *sun,
+                         post_process_chain_t *chain) {
+  begin_frame(state);
+
+  // Application scratch, the kind of per frame list a scene builds before drawing
+  usize num_pixels = (usize)WIN_WIDTH * WIN_HEIGHT;
+  u32 *row_counts = frame_alloc(state, WIN_HEIGHT * sizeof(u32));
+  if (row_counts) memset(row_counts, 0, WIN_HEIGHT * sizeof(u32));
+
+  for (usize i = 0; i < num_pixels; ++i) {
+    state->framebuffer[i] = rgb_to_u32(0, 0, 0);
+    state->depthbuffer[i] = MAX_DEPTH;
+  }
+
+  sphere->transform.yaw += 0.01f;
+  render_model(state, camera, sphere, sun, 1);
+  apply_post_process_chain(state, chain);
+}
+
+int main(void) {
+  printf("Shader-Works Frame Allocation Check\n");
+  printf("===================================\n\n");
+
+  sw_allocator_t allocator = {
+    .alloc = counting_alloc,
+    .realloc = counting_realloc,
+    .free = counting_free
+  };
+  sw_set_allocator(&allocator);
+
+  u32 *framebuffer = malloc(WIN_WIDTH * WIN_HEIGHT * sizeof(u32));
+  f32 *depthbuffer = malloc(WIN_WIDTH * WIN_HEIGHT * sizeof(f32));
+  void *frame_memory = malloc(FRAME_ARENA_SIZE);
+  if (!framebuffer || !depthbuffer || !frame_memory) {
+    fprintf(stderr, "Failed to allocate buffers\n");
+    return 1;
+  }
+
+  renderer_t renderer_state = {0};
+  init_renderer(&renderer_state, WIN_WIDTH, WIN_HEIGHT, 0, 0, framebuffer, depthbuffer, NULL, MAX_DEPTH);
+  set_frame_arena(&renderer_state, frame_memory, FRAME_ARENA_SIZE);
+  set_dither_lut(&renderer_state, 8.0f);
+
+  post_process_chain_t chain;
+  init_post_process_chain(&chain);
+  chain.clear_depth = MAX_DEPTH;
+  add_post_process_pass(&chain, fog_pass, NULL);
+  add_post_process_pass(&chain, dither_pass, NULL);
+
+  model_t sphere = {0};
+  generate_sphere(&sphere, 2.0f, 24, 24, make_float3(0.0f, 0.0f, -6.0f));
+  sphere.frag_shader = &default_lighting_frag_shader;
+  sphere.vertex_shader = &default_vertex_shader;
+  sphere.use_textures = false;
+
+  transform_t camera = {0};
+  update_camera(&renderer_state, &camera);
+
+  light_t sun = {
+    .is_directional = true,
+    .direction = make_float3(-1, -1, -1),
+    .color = rgb_to_u32(255, 255, 255)
+  };
+
+  // Lazily built state such as thread pools settles during warm-up
+  for (int frame = 0; frame < WARMUP_FRAMES; ++frame) {
+    render_frame(&renderer_state, &camera, &sphere, &sun, &chain);
+  }
+
+  sw_memory_stats_t before, after;
+  sw_get_memory_stats(&before);
+  u64 calls_before = alloc_calls + realloc_calls + free_calls;
+
+  for (int frame = 0; frame < STEADY_FRAMES; ++frame) {
+    render_frame(&renderer_state, &camera, &sphere, &sun, &chain);
+  }
+
+  sw_get_memory_stats(&after);
+  u64 steady_calls = alloc_calls + realloc_calls + free_calls - calls_before;
+  u64 steady_allocations = after.total_allocations - before.total_allocations;
+
+  printf("Warm-up frames: %d, steady frames: %d\n", WARMUP_FRAMES, STEADY_FRAMES);
+  printf("Allocator calls during steady frames: %llu\n", (unsigned long long)steady_calls);
+  printf("Counted allocations during steady frames: %llu\n", (unsigned long long)steady_allocations);
+
+  delete_model(&sphere);
+  free(frame_memory);
+  free(framebuffer);
+  free(depthbuffer);
+
+  if (steady_calls != 0 || steady_allocations != 0) {
+    fprintf(stderr, "FAILED: steady frames allocated\n");
+    return 1;
+  }
+
+  printf("OK: steady frames made no allocations\n");
+  return 0;
+}
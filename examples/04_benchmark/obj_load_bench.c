@@ -0,0 +1,151 @@
+// OBJ loading throughput benchmark
+// Writes a grid mesh with shared v/vt/vn corners and quad faces, the way modelling tools export
+// large scans, then times load_obj_mesh, and load_obj_model parsing and from its cache
+// Pass a path to time an existing file instead
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <shader-works/mesh_cache.h>
+#include <shader-works/obj.h>
+#include <shader-works/primitives.h>
+
+#define GRID_SIZE 600   // quads along each side, 720k triangles
+#define NUM_RUNS 5
+
+// The library expects the client to provide these
+u32 rgb_to_u32(u8 r, u8 g, u8 b) {
+  return (r << 24) | (g << 16) | (b << 8) | 0xFF;
+}
+
+void u32_to_rgb(u32 color, u8 *r, u8 *g, u8 *b) {
+  *r = (color >> 24) & 0xFF;
+  *g = (color >> 16) & 0xFF;
+  *b = (color >> 8) & 0xFF;
+}
+
+// Get current time in seconds
+static double get_time_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// A rippled grid, one position, UV and normal per grid point
+static int write_grid_obj(const char *path, int size) {
+  FILE *file = fopen(path, "w");
+  if (!file) return -1;
+
+  fprintf(file, "# %dx%d benchmark grid\n", size, size);
+  for (int z = 0; z <= size; ++z) {
+    for (int x = 0; x <= size; ++x) {
+      fprintf(file, "v %.6f %.6f %.6f\n", x * 0.1f, ((x * 7 + z * 13) % 17) * 0.01f, z * 0.1f);
+    }
+  }
+  for (int z = 0; z <= size; ++z) {
+    for (int x = 0; x <= size; ++x) fprintf(file, "vt %.6f %.6f\n", (float)x / size, (float)z / size);
+  }
+  for (int z = 0; z <= size; ++z) {
+    for (int x = 0; x <= size; ++x) fprintf(file, "vn %.4f %.4f %.4f\n", 0.0f, 1.0f, 0.0f);
+  }
+
+  for (int z = 0; z < size; ++z) {
+    for (int x = 0; x < size; ++x) {
+      int a = z * (size + 1) + x + 1, b = a + 1, c = a + size + 2, d = a + size + 1;
+      fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+    }
+  }
+
+  fclose(file);
+  return 0;
+}
+
+static long file_size(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return -1;
+
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  return size;
+}
+
+int main(int argc, char *argv[]) {
+  const char *path = argc > 1 ? argv[1] : "obj_load_bench.obj";
+
+  printf("Shader-Works OBJ Load Benchmark\n");
+  printf("===============================\n\n");
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  printf("Threading: ENABLED\n");
+#else
+  printf("Threading: DISABLED\n");
+#endif
+
+  if (argc <= 1) {
+    printf("Writing %dx%d grid to %s... ", GRID_SIZE, GRID_SIZE, path);
+    fflush(stdout);
+    if (write_grid_obj(path, GRID_SIZE) != 0) {
+      fprintf(stderr, "Failed to write %s\n", path);
+      return 1;
+    }
+    printf("done\n");
+  }
+
+  long bytes = file_size(path);
+  if (bytes < 0) {
+    fprintf(stderr, "Failed to open %s\n", path);
+    return 1;
+  }
+  printf("File size: %.1f MB\n\n", bytes / (1024.0 * 1024.0));
+
+  // load_obj_model keeps a binary cache beside the file, start without one so the first load parses
+  char cache_path[1024];
+  snprintf(cache_path, sizeof(cache_path), "%s%s", path, MESH_CACHE_EXTENSION);
+  remove(cache_path);
+
+  model_t model = {0};
+  double start = get_time_seconds();
+  if (load_obj_model(&model, path, make_float3(0, 0, 0), 1.0f, false) != 0) {
+    fprintf(stderr, "load_obj_model failed on %s\n", path);
+    return 1;
+  }
+  double first_model = get_time_seconds() - start;
+  delete_model(&model);
+
+  double best_mesh = 1e9, best_cached = 1e9;
+  obj_mesh_t mesh = {0};
+
+  for (int run = 0; run < NUM_RUNS; ++run) {
+    start = get_time_seconds();
+    if (load_obj_mesh(&mesh, path, false) != 0) {
+      fprintf(stderr, "load_obj_mesh failed on %s\n", path);
+      return 1;
+    }
+    double elapsed = get_time_seconds() - start;
+    if (elapsed < best_mesh) best_mesh = elapsed;
+    if (run < NUM_RUNS - 1) free_obj_mesh(&mesh);
+
+    start = get_time_seconds();
+    if (load_obj_model(&model, path, make_float3(0, 0, 0), 1.0f, false) != 0) {
+      fprintf(stderr, "load_obj_model failed on %s\n", path);
+      return 1;
+    }
+    elapsed = get_time_seconds() - start;
+    if (elapsed < best_cached) best_cached = elapsed;
+    delete_model(&model);
+  }
+
+  printf("Triangles: %zu, unique vertices: %zu\n", mesh.num_triangles, mesh.num_vertices);
+  printf("load_obj_mesh:           %.3f s, %.1f MB/s, %.2f M triangles/s (best of %d)\n",
+         best_mesh, bytes / (1024.0 * 1024.0) / best_mesh, mesh.num_triangles / best_mesh / 1e6, NUM_RUNS);
+  printf("load_obj_model, parsed:  %.3f s, %.1f MB/s, %.2f M triangles/s (includes writing the cache)\n",
+         first_model, bytes / (1024.0 * 1024.0) / first_model, mesh.num_triangles / first_model / 1e6);
+  printf("load_obj_model, cached:  %.6f s (best of %d)\n", best_cached, NUM_RUNS);
+
+  free_obj_mesh(&mesh);
+  remove(cache_path);
+  if (argc <= 1) remove(path);
+  return 0;
+}
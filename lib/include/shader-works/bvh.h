@@ -0,0 +1,68 @@
+#ifndef SHADER_WORKS_BVH_H
+#define SHADER_WORKS_BVH_H
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+#include <shader-works/renderer.h>
+
+// Node index meaning "no node"
+#define BVH_NULL_NODE (-1)
+
+// A node of the hierarchy, leaves hold one client object each
+typedef struct {
+  float3 min, max;      // world space bounds, the union of both children for internal nodes
+  void *user;           // client object of a leaf, e.g. a model_t or a chunk
+  int parent;           // parent node, or the next free node while on the free list
+  int left, right;      // children, BVH_NULL_NODE for leaves
+  int height;           // 0 for leaves, -1 for free nodes
+} bvh_node_t;
+
+// Dynamic bounding volume hierarchy of client objects
+// Inserting and removing only touches the path to the root, keeping the tree balanced with rotations,
+// so objects can stream in and out every frame without a rebuild
+typedef struct {
+  bvh_node_t *nodes;    // node pool, indices stay valid while the object is in the tree
+  int capacity;
+  int root;             // BVH_NULL_NODE when empty
+  int free_list;        // first free node in the pool
+  int leaf_count;       // number of objects in the tree
+} bvh_t;
+
+// A leaf that survived culling, see bvh_cull
+typedef struct {
+  void *user;           // client object passed to bvh_insert
+  f32 depth;            // view space depth of the leaf's box center, smaller is closer
+} bvh_draw_item_t;
+
+// Initialize an empty hierarchy
+// initial_capacity: number of nodes to allocate up front, the pool grows as needed
+// Returns 0 on success, -1 on allocation failure
+int init_bvh(bvh_t *bvh, int initial_capacity);
+
+// Free the node pool, client objects are not touched
+void free_bvh(bvh_t *bvh);
+
+// Add an object to the hierarchy
+// min, max: world space bounds of the object
+// user: client object returned by bvh_cull
+// Returns the object's proxy id for bvh_remove and bvh_refit, or -1 on allocation failure
+int bvh_insert(bvh_t *bvh, float3 min, float3 max, void *user);
+
+// Remove an object by the proxy id bvh_insert returned
+void bvh_remove(bvh_t *bvh, int proxy);
+
+// Update an object's bounds after it moved, resizing its ancestors up to the root
+// Cheap for small moves; remove and insert again when an object jumps across the scene so the tree stays tight
+void bvh_refit(bvh_t *bvh, int proxy, float3 min, float3 max);
+
+// Collect every object whose bounds intersect the camera's view frustum, sorted front to back
+// Subtrees entirely outside are skipped and subtrees entirely inside are taken without further plane tests,
+// so the cost follows what is visible rather than what is loaded. Call update_camera first
+// items: output array, filled with the max_items closest entries when more are visible
+// Returns the number of entries written to items
+usize bvh_cull(const bvh_t *bvh, const renderer_t *state, const transform_t *cam, bvh_draw_item_t *items, usize max_items);
+
+// World space axis aligned box of a model from its bounds, scale and transform, for use with bvh_insert
+void get_model_world_bounds(const model_t *model, float3 *min, float3 *max);
+
+#endif // SHADER_WORKS_BVH_H
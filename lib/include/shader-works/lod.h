@@ -0,0 +1,31 @@
+#ifndef SHADER_WORKS_LOD_H
+#define SHADER_WORKS_LOD_H
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+
+// Screen area in pixels each triangle should cover, render_model draws the finest level of a model with lods
+// that stays within this budget for the model's projected bounding sphere
+#define LOD_PIXELS_PER_TRIANGLE 8.0f
+
+// Build progressively coarser copies of a model's mesh into model->lods by quadric error edge collapse
+// Corners are welded by position only and keep their own UVs. A collapse goes ahead only if every surviving
+// corner of the removed vertex can take a UV from keep's side of the same chart, so vertices on UV seams
+// move along the seam or not at all and the texture never tears. Open edges resist moving off their line
+// so outlines keep their shape
+// Works on any triangle mesh, e.g. one from load_obj_model; call again after editing vertex_data
+// model: model to simplify, any previous levels are replaced. For shared geometry simplify the shared_mesh_t's model
+// num_levels: number of levels to build
+// reduction: fraction of the previous level's triangles each level keeps, e.g. 0.5
+// Returns the number of levels built (fewer when the mesh stops simplifying), -1 on allocation failure
+int generate_model_lods(model_t *model, int num_levels, f32 reduction);
+
+// Drop a model's simplified levels, render_model goes back to the full mesh. Levels borrowed from a shared mesh aren't freed
+void free_model_lods(model_t *model);
+
+// The mesh render_model draws for model at the given size on screen
+// screen_radius: radius of the model's bounding sphere in pixels
+// out: filled with a copy of model pointing at the chosen level's arrays
+void select_model_lod(const model_t *model, f32 screen_radius, model_t *out);
+
+#endif // SHADER_WORKS_LOD_H
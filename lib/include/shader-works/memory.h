@@ -0,0 +1,101 @@
+#ifndef SHADER_WORKS_MEMORY_H
+#define SHADER_WORKS_MEMORY_H
+
+#include <stdbool.h>
+#include <shader-works/maths.h>
+
+// Alignment of every arena and pool allocation, enough for any vector type the library uses
+#define SW_MEMORY_ALIGNMENT 16
+
+// What the library's heap memory holds, for sw_get_memory_stats
+typedef enum {
+  SW_MEMORY_GEOMETRY = 0, // model vertex data, face normals and LOD levels
+  SW_MEMORY_TEXTURES,     // shading caches and shadow maps
+  SW_MEMORY_SCRATCH,      // temporaries while building meshes, and arena and pool blocks whatever is carved from them
+  SW_MEMORY_OTHER,        // bookkeeping such as BVH nodes
+  SW_MEMORY_CATEGORY_COUNT
+} sw_memory_category_t;
+
+// Heap the library allocates from, every call gets the user pointer it was registered with
+// realloc must behave like the standard one: NULL leaves ptr untouched
+typedef struct {
+  void *(*alloc)(usize size, void *user);
+  void *(*realloc)(void *ptr, usize size, void *user);
+  void (*free)(void *ptr, void *user);
+  void *user;
+} sw_allocator_t;
+
+// Live heap use of the library, sizes are what callers asked for without the allocator's own overhead
+typedef struct {
+  usize live_bytes[SW_MEMORY_CATEGORY_COUNT];
+  usize live_allocations[SW_MEMORY_CATEGORY_COUNT];
+  u64 total_allocations;  // allocations and reallocations since startup, steady frames should not move it
+} sw_memory_stats_t;
+
+// Route every library allocation through allocator, or back to malloc, realloc and free when NULL
+// Set it before the library allocates anything, memory must be freed by the allocator that made it
+void sw_set_allocator(const sw_allocator_t *allocator);
+
+// The library's own allocation functions, counted under category
+// Buffers the library frees, such as a model's vertex_data for delete_model, must come from these
+void *sw_alloc(usize size, sw_memory_category_t category);
+void *sw_calloc(usize count, usize size, sw_memory_category_t category);
+// category applies when ptr is NULL, a resized buffer stays in the category it was made in
+void *sw_realloc(void *ptr, usize size, sw_memory_category_t category);
+void sw_free(void *ptr);
+
+void sw_get_memory_stats(sw_memory_stats_t *stats);
+usize sw_memory_in_use(sw_memory_category_t category);
+const char *sw_memory_category_name(sw_memory_category_t category);
+
+// Linear allocator over one block, allocations are bumped off the front and released all at once
+// Neither allocator locks, share one between threads only with the caller's own synchronisation
+typedef struct arena_t {
+  u8 *base;
+  usize capacity, used;
+  void *allocation;     // block from init_arena, freed with the arena, NULL over caller memory
+} arena_t;
+
+// Fixed size blocks handed out from slabs of blocks_per_slab, freed blocks are reused before a new slab is made
+typedef struct pool_t {
+  usize block_size;     // rounded up to SW_MEMORY_ALIGNMENT
+  usize blocks_per_slab;
+  void *free_list;      // first free block, each free block holds the next
+  void **slabs;
+  usize num_slabs, slab_capacity;
+  usize live_blocks;    // blocks handed out and not yet freed
+} pool_t;
+
+// Allocate an arena of capacity bytes
+// Returns 0 on success, -1 on allocation failure
+int init_arena(arena_t *arena, usize capacity);
+
+// Wrap caller owned memory, e.g. a pool block, free_arena then leaves it alone
+void init_arena_from(arena_t *arena, void *memory, usize capacity);
+void free_arena(arena_t *arena);
+
+// size bytes aligned to SW_MEMORY_ALIGNMENT, or NULL when the arena is NULL or out of room
+void *arena_alloc(arena_t *arena, usize size);
+
+// Scoped temporaries: take a mark, allocate, then release back to it, dropping everything allocated after the mark
+usize arena_mark(const arena_t *arena);
+void arena_release(arena_t *arena, usize mark);
+void arena_reset(arena_t *arena);
+
+// Whether ptr points into the arena's block, false for a NULL arena
+// Lets owners of mixed heap and arena buffers tell which ones to free
+bool arena_contains(const arena_t *arena, const void *ptr);
+
+// block_size: bytes per block, at least a pointer
+// blocks_per_slab: blocks allocated together whenever the pool runs dry
+// Returns 0 on success, -1 on allocation failure
+int init_pool(pool_t *pool, usize block_size, usize blocks_per_slab);
+
+// Frees every slab, blocks still handed out become invalid
+void free_pool(pool_t *pool);
+
+// A free block, growing the pool by a slab when none is left. Returns NULL on allocation failure
+void *pool_alloc(pool_t *pool);
+void pool_free(pool_t *pool, void *block);
+
+#endif // SHADER_WORKS_MEMORY_H
@@ -0,0 +1,52 @@
+#ifndef SHADER_WORKS_MESH_CACHE_H
+#define SHADER_WORKS_MESH_CACHE_H
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+
+// Binary copy of a model's geometry laid out exactly as model_t uses it, so loading is a file mapping
+// Files are in the writer's byte order and vertex layout, anything else is rejected as stale
+
+#define MESH_CACHE_MAGIC 0x434D5753u  // "SWMC" in a little endian file
+#define MESH_CACHE_VERSION 1
+
+// Appended to an OBJ's path by load_obj_model for the cache it keeps beside it, one per winding
+#define MESH_CACHE_EXTENSION ".swmesh"
+#define MESH_CACHE_FLIPPED_EXTENSION ".flipped.swmesh"
+
+#define MESH_CACHE_USE_TEXTURES 1u
+
+// Start of every cache file, the streams follow at their offsets
+typedef struct {
+  u32 magic;              // MESH_CACHE_MAGIC
+  u32 version;            // MESH_CACHE_VERSION
+  u32 vertex_size;        // sizeof(vertex_data_t) of the writer
+  u32 flags;              // MESH_CACHE_USE_TEXTURES
+  u64 source_stamp;       // identifies what the cache was built from, 0 when it doesn't matter
+  u64 num_vertices, num_faces;
+  u64 vertex_offset;      // num_vertices vertex_data_t from the start of the file, a multiple of 16
+  u64 face_normal_offset; // num_faces float3, a multiple of 16
+  float3 bounds_min, bounds_max, bounds_center;
+  f32 bounds_radius;
+} mesh_cache_header_t;
+
+// Mapped cache file a model's geometry points into, see load_mesh_cache
+struct mesh_cache_t;
+
+// Write model's vertex_data, face_normals, bounds and use_textures to path
+// source_stamp: stored for load_mesh_cache to check, e.g. something that changes with the source file
+// Returns 0 on success, -1 when the file can't be written
+int write_mesh_cache(const char *path, const model_t *model, u64 source_stamp);
+
+// Map a cache file and point model's vertex_data and face_normals straight into it, nothing is copied
+// Sets the geometry counts, bounds and use_textures, the rest of the model is left alone
+// Writes to the vertices stay private to the model, every model mapping the same file shares the untouched pages
+// source_stamp: must match the written one, or 0 to accept any
+// Files whose counts, offsets or length don't match the layout write_mesh_cache produces count as malformed
+// Returns 0 on success, -1 when the file is missing, malformed or stale
+int load_mesh_cache(model_t *model, const char *path, u64 source_stamp);
+
+// Unmap a model's cache, delete_model calls this for models from load_mesh_cache
+void close_mesh_cache(struct mesh_cache_t *cache);
+
+#endif // SHADER_WORKS_MESH_CACHE_H
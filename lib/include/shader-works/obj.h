@@ -0,0 +1,26 @@
+#ifndef SHADER_WORKS_OBJ_H
+#define SHADER_WORKS_OBJ_H
+
+#include <stdbool.h>
+#include <shader-works/maths.h>
+
+// Indexed triangle mesh read from a Wavefront OBJ file
+// Every distinct v/vt/vn combination the faces use becomes one vertex, shared by all triangles that use it
+typedef struct {
+  float3 *positions;      // num_vertices each, Z flipped to the renderer's -Z forward and centred on the file's bounding box
+  float2 *uvs;            // (0, 0) where a face gave no texture coordinate
+  float3 *normals;        // flipped like the positions, (0, 1, 0) where a face gave no normal
+  u32 *indices;           // 3 per triangle, polygons fan triangulated
+  usize num_vertices, num_triangles;
+  bool has_texcoords;     // the file had vt lines, load_obj_model turns textures on for these
+} obj_mesh_t;
+
+// Parse an OBJ file in a single pass over a memory mapped copy
+// Files above a few megabytes are split into line ranges parsed on the worker threads
+// Supports v, vt, vn and f lines with v, v/vt, v//vn and v/vt/vn corners, negative indices count back from the end
+// flip_winding: reverse every triangle, as for load_obj_model
+// Returns 0 on success, -1 when the file can't be read, a face uses a missing position, or allocation fails
+int load_obj_mesh(obj_mesh_t *mesh, const char *filename, bool flip_winding);
+void free_obj_mesh(obj_mesh_t *mesh);
+
+#endif // SHADER_WORKS_OBJ_H
@@ -0,0 +1,74 @@
+#ifndef SHADER_WORKS_POST_PROCESS_H
+#define SHADER_WORKS_POST_PROCESS_H
+
+#include <shader-works/maths.h>
+#include <shader-works/renderer.h>
+
+// Maximum number of passes in a post-process chain
+#define MAX_POST_PROCESS_PASSES 8
+
+// Maximum number of pixels handed to a pass at once, spans never cross rows
+#define POST_PROCESS_SPAN_SIZE 256
+
+// A run of framebuffer pixels handed to each pass of a chain
+// Pixels are unpacked into separate channels once per chain, so every pass works on plain byte arrays
+// and the client's u32_to_rgb/rgb_to_u32 run once per pixel however many passes there are
+typedef struct post_process_span_t {
+  renderer_t *state;
+  u8 *r, *g, *b;        // channels of each pixel, modified in place
+  const f32 *depth;     // depth of each pixel
+  f32 clear_depth;      // the chain's clear_depth, pixels at or beyond it hold no geometry
+  int x, y;             // screen position of the first pixel
+  int count;            // number of pixels, at most POST_PROCESS_SPAN_SIZE
+} post_process_span_t;
+
+// Post-process pass function, modifies the span's channels in place
+typedef void (*post_process_func)(post_process_span_t *span, void *args);
+
+typedef struct {
+  post_process_func func;
+  void *args;           // user data passed to func, must stay valid while the chain is used
+} post_process_pass_t;
+
+// An ordered list of passes applied together in a single sweep over the framebuffer
+typedef struct {
+  post_process_pass_t passes[MAX_POST_PROCESS_PASSES];
+  usize num_passes;
+  f32 clear_depth;      // value the client clears the depth buffer to, FLT_MAX unless changed after init
+} post_process_chain_t;
+
+// Arguments for tone_curve_pass, a lookup table per channel
+typedef struct {
+  u8 r[256], g[256], b[256];
+} tone_curve_t;
+
+// Initialize an empty post-process chain with a clear_depth of FLT_MAX
+void init_post_process_chain(post_process_chain_t *chain);
+
+// Append a pass to a chain, passes run in the order they are added
+// func: pass function, args: user data passed to func
+// Returns 0 on success, non-zero if the chain is full
+int add_post_process_pass(post_process_chain_t *chain, post_process_func func, void *args);
+
+// Apply every pass of a chain to the framebuffer in one sweep, split into row ranges across worker threads
+void apply_post_process_chain(renderer_t *state, post_process_chain_t *chain);
+
+// Built-in passes
+
+// Depth fog, args: a fog_lut_t from init_fog_lut, or NULL for the renderer's table (set_fog_lut)
+// Pixels at the chain's clear_depth still show the clear color and are left untouched, drawn pixels past the
+// fog end get full fog
+void fog_pass(post_process_span_t *span, void *args);
+
+// Checkerboard dither and quantize using the renderer's dither table (set_dither_lut), args unused
+// Like fog_pass it skips pixels at the chain's clear_depth
+void dither_pass(post_process_span_t *span, void *args);
+
+// Per-channel tone curve lookup, args: tone_curve_t
+void tone_curve_pass(post_process_span_t *span, void *args);
+
+// Fill a tone curve applying contrast around mid grey, then gamma
+// contrast: 1 leaves colors unchanged, gamma: 1 leaves colors unchanged, > 1 brightens midtones
+void init_tone_curve(tone_curve_t *curve, f32 contrast, f32 gamma);
+
+#endif // SHADER_WORKS_POST_PROCESS_H
@@ -4,6 +4,10 @@
 #include <shader-works/maths.h>
 #include <shader-works/shaders.h>
 
+struct arena_t;
+struct mesh_cache_t;
+struct shared_mesh_t;
+
 // Transform structure
 typedef struct {
   f32 yaw;
@@ -19,6 +23,20 @@ typedef struct {
   float3 normal;
 } vertex_data_t;
 
+// Fragment shader output baked into texture space, see bake_shading_cache
+typedef struct {
+  u32 *texels;          // width * height colors, NULL when nothing is baked
+  u32 width, height;
+} shading_cache_t;
+
+// Simplified copy of a model's mesh, see generate_model_lods
+typedef struct {
+  vertex_data_t *vertex_data;
+  float3 *face_normals;
+  usize num_vertices;
+  usize num_faces;
+} model_lod_t;
+
 // Model structure with cache-friendly vertex layout
 typedef struct {
   // Cache-friendly: all vertex data together
@@ -32,13 +50,46 @@ typedef struct {
   float3 scale;
   transform_t transform;
 
+  // Model space bounds of vertex_data positions (before scale), see compute_model_bounds
+  float3 bounds_min, bounds_max;  // axis aligned box
+  float3 bounds_center;           // bounding sphere, a radius of 0 means unknown and disables whole-model culling
+  f32 bounds_radius;
+
+  // Size of one texture atlas tile in UV units, or 0 to sample UVs as given
+  // When set, each triangle repeats the tile its smallest UV falls in, so a merged quad can span several tiles
+  float2 atlas_tile_dim;
+
+  // Baked procedural colors, sampled at each pixel's UV in place of the texture atlas or flat color
+  shading_cache_t shading_cache;
+
+  // Set before calling a generator or bake_shading_cache to carve their buffers from this arena instead of the heap
+  // Buffers that do not fit still come from the heap, delete_model frees only those
+  struct arena_t *arena;
+
+  // Mapped cache file vertex_data and face_normals point into, see load_mesh_cache. delete_model unmaps it
+  struct mesh_cache_t *mesh_cache;
+
+  // Mesh the geometry, bounds and LODs are borrowed from, see shared_mesh.h. delete_model releases it
+  struct shared_mesh_t *shared_mesh;
+
+  // Coarser versions of the mesh, finest first, render_model picks one from the model's size on screen
+  model_lod_t *lods;
+  usize num_lods;
+
   bool use_textures;
   bool disable_behind_camera_culling; // For particles that should render 360 degrees
   vertex_shader_t *vertex_shader;
   fragment_shader_t *frag_shader;
 } model_t;
 
+// One placement of a shared model for render_model_instanced
+typedef struct {
+  transform_t transform;  // Replaces the model's own transform
+  instance_data_t data;   // Passed to shaders through their context's instance pointer
+} model_instance_t;
+
 // Model generation functions
+// Models start zeroed, generators allocate from model->arena when it is set, see memory.h
 
 // Generates a plane centered at position with given size and segment size
 // model: pointer to model structure to populate
@@ -80,7 +131,9 @@ int generate_sphere(model_t* model, f32 radius, int segments, int rings, float3
 // Returns 0 on success, non-zero on failure
 int generate_quad(model_t* model, float2 size, float3 position);
 
-// Loads an OBJ model from file
+// Loads an OBJ model from file, parsed by load_obj_mesh (see obj.h) and expanded to unindexed triangles
+// The result is kept in a binary cache beside the file (filename + MESH_CACHE_EXTENSION, or
+// MESH_CACHE_FLIPPED_EXTENSION with flip_winding), later loads map it while the OBJ is unchanged. Models with an arena are always parsed so their geometry lands in it
 // model: pointer to model structure to populate
 // filename: path to the .OBJ file to load
 // position: center position to place the model at (x, y, z)
@@ -89,6 +142,11 @@ int generate_quad(model_t* model, float2 size, float3 position);
 // Returns 0 on success, non-zero on failure
 int load_obj_model(model_t* model, const char* filename, float3 position, float scale, bool flip_winding);
 
+// Recomputes a model's bounding box and sphere from its vertex positions
+// Generators and load_obj_model call this, call it again after editing vertex positions
+// model: pointer to model with vertex_data populated
+void compute_model_bounds(model_t* model);
+
 // Model cleanup
 void delete_model(model_t* model);
 
@@ -5,6 +5,7 @@
 #include <shader-works/maths.h>
 #include <shader-works/shaders.h>
 #include <shader-works/primitives.h>
+#include <shader-works/memory.h>
 
 // Handle restrict keyword for C++ compatibility
 #ifdef __cplusplus
@@ -26,6 +27,9 @@
 typedef struct triangle_context_t {
   struct renderer_t *state;
   model_t *model;
+  const transform_t *transform;         // model placement, the model's own or an instance's
+  float3 model_ihat, model_jhat, model_khat; // basis vectors of transform, computed once per placement
+  const instance_data_t *instance;      // per-instance attributes, NULL for render_model
   transform_t *cam;
   light_t *lights;
   usize light_count;
@@ -36,11 +40,45 @@ typedef struct triangle_context_t {
   fragment_context_t frag_ctx;
 
   int tri;
+  bool depth_only;      // hidden-line pre-pass, only fill the depth buffer
+  bool cull_bounds;     // model bounds are trustworthy for whole-model frustum culling
 
   f32 frustum_bound;
   f32 max_depth;
 } triangle_context_t;
 
+// Storage formats for the texture atlas
+typedef enum {
+  TEXTURE_FORMAT_DIRECT = 0, // texture_atlas holds one packed u32 color per texel
+  TEXTURE_FORMAT_INDEXED8,   // texture_indices holds one u8 palette index per texel
+  TEXTURE_FORMAT_INDEXED4    // texture_indices holds two 4-bit palette indices per byte, low nibble first
+} texture_format_t;
+
+// Wireframe modes for renderer_t.wireframe_mode
+typedef enum {
+  WIREFRAME_OFF = 0,    // normal shaded rendering
+  WIREFRAME_EDGES,      // draw triangle edges only, depth tested against what is already drawn
+  WIREFRAME_HIDDEN_LINE // fill each model's depth first so edges behind its closer faces are hidden
+} wireframe_mode_t;
+
+// Number of depth steps in the fog table
+#define FOG_LUT_SIZE 256
+
+// Precomputed fog, quantized depth to 8-bit blend weight, see set_fog_lut
+typedef struct {
+  u8 weight[FOG_LUT_SIZE];  // fog blend weight (0-255) per depth step
+  f32 start, scale;         // depth to step: (depth - start) * scale
+  u8 r, g, b;               // fog color
+  u32 color;                // fog color packed with rgb_to_u32
+  f32 end;
+} fog_lut_t;
+
+// Precomputed checkerboard dither and quantization, see set_dither_lut
+typedef struct {
+  u8 table[2][256];         // quantized channel value, indexed by checkerboard parity then input value
+  f32 steps;
+} dither_lut_t;
+
 // Renderer state structure
 typedef struct renderer_t {
   u32 *framebuffer;     // framebuffer, client allocated
@@ -48,15 +86,27 @@ typedef struct renderer_t {
   u32 *texture_atlas;   // pointer to texture atlas data (static data)
   u32 *skybox_buffer;   // panoramic skybox texture, client allocated
 
+  const u8 *texture_indices;  // palettized texture atlas indices (static data), see set_texture_atlas_indexed
+  const u32 *texture_palette; // palette colors for texture_indices, in the client's pixel format
+  u32 texture_format;         // texture_format_t of the atlas, packed as u32 for alignment
+
   f32 time;             // Time since renderer initialization
   u64 start_time;       // Start time in milliseconds
   f32 max_depth;        // Maximum depth value for depth buffering
 
-  u32 wireframe_mode;   // If true, render in wireframe mode, packed as u32 for alignment
+  u32 wireframe_mode;   // wireframe_mode_t, packed as u32 for alignment
+  u32 wireframe_color;  // color of wireframe edges
 
   float3 cam_right, cam_up, cam_forward;
   float2 screen_dim, atlas_dim;
   f32 screen_height_world, projection_scale, frustum_bound;
+
+  fog_lut_t fog_lut;       // fog table shared by shaders and the post pass
+  dither_lut_t dither_lut; // dither table shared by shaders and the post pass
+
+  const struct shadow_map_t *shadow_map; // handed to fragment shaders, see shadow_map.h
+
+  arena_t frame_arena;  // per frame scratch memory, client allocated, see set_frame_arena
 } renderer_t;
 
 // User-defined color conversion functions (must be implemented by client)
@@ -75,6 +125,25 @@ extern void u32_to_rgb(u32 color, u8 *r, u8 *g, u8 *b);
 // max_depth: maximum depth value for depth buffering
 void init_renderer(renderer_t *state, u32 win_width, u32 win_height, u32 atlas_width, u32 atlas_height, u32 *framebuffer, f32 *depthbuffer, u32 *skybox_buffer, f32 max_depth);
 
+// Hand the renderer client allocated scratch memory for frame_alloc, call after init_renderer
+// memory: at least size bytes that outlive the renderer's use of them, or NULL to drop the arena
+void set_frame_arena(renderer_t *state, void *memory, usize size);
+
+// Start a frame, everything frame_alloc handed out during the previous one becomes invalid
+void begin_frame(renderer_t *state);
+
+// size bytes of scratch memory valid until the next begin_frame, for the library and application alike
+// Returns NULL when no frame arena is set or it is full, callers then fall back to the heap
+// Not thread safe, call it from the thread driving the renderer rather than from shaders
+void *frame_alloc(renderer_t *state, usize size);
+
+// Use a palettized texture atlas instead of texture_atlas
+// indices: atlas_width * atlas_height palette indices. TEXTURE_FORMAT_INDEXED4 packs two per byte
+//          (low nibble first) with each row padded to a whole byte
+// palette: 256 (INDEXED8) or 16 (INDEXED4) colors packed with rgb_to_u32's pixel format
+// format: TEXTURE_FORMAT_INDEXED8 or TEXTURE_FORMAT_INDEXED4, TEXTURE_FORMAT_DIRECT switches back to texture_atlas
+void set_texture_atlas_indexed(renderer_t *state, const u8 *indices, const u32 *palette, texture_format_t format);
+
 // Update camera basis vectors based on transform
 // cam: pointer to camera transform
 void update_camera(renderer_t *restrict state, transform_t *restrict cam);
@@ -88,6 +157,19 @@ void update_camera(renderer_t *restrict state, transform_t *restrict cam);
 // Returns the number of triangles rendered
 usize render_model(renderer_t *state, transform_t *cam, model_t *model, light_t *lights, usize light_count);
 
+// Render many placements of one model in a single submission, spread across worker threads by instance
+// Each instance replaces the model's transform; its uv_offset shifts the model's UVs, its color replaces
+// flat_color on untextured models, and shaders reach all of its data through their context's instance pointer
+// state: pointer to renderer state
+// cam: pointer to camera transform
+// model: pointer to model shared by every instance
+// instances: array of instance placements and attributes
+// instance_count: number of instances in the array
+// lights: array of lights affecting the model
+// light_count: number of lights in the array
+// Returns the number of triangles rendered
+usize render_model_instanced(renderer_t *state, transform_t *cam, model_t *model, const model_instance_t *instances, usize instance_count, light_t *lights, usize light_count);
+
 // Render a single point in world space, applying transformations and depth testing
 // Returns true if the point was drawn (not occluded), false if it was behind something
 // state: pointer to renderer state
@@ -96,25 +178,58 @@ usize render_model(renderer_t *state, transform_t *cam, model_t *model, light_t
 // color: color of the point as a packed u32
 bool render_point(renderer_t *restrict state, transform_t *restrict cam, float3 point, u32 color);
 
+// Draw an equirectangular panorama behind the scene, call after geometry so only uncovered pixels are shaded
+// The view ray is stepped per pixel from the camera basis set by update_camera, no sphere model is needed
+// state: pointer to renderer state
+// sky: panorama to sample, u wraps around the +Y axis and v runs from straight up to straight down
+// sky_depth: depth written to filled pixels, e.g. a fraction of max_depth so fog tints the sky
+// Returns the number of pixels filled
+usize render_skybox(renderer_t *restrict state, const skybox_shader_args_t *restrict sky, f32 sky_depth);
+
 // Built-in effects
 
-// Apply fog effect to the entire screen based on depth values
+// Apply fog effect to a single pixel based on its depth
+// Recomputes the blend per call, prefer set_fog_lut + apply_fog_lut in shaders
 // fog_start: distance at which fog starts
 // fog_end: distance at which fog fully obscures
 // fog_r, fog_g, fog_b: RGB color of the fog
 u32 apply_fog_to_pixel(renderer_t *restrict state, u32 input, int screen_x, int screen_y, f32 depth, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b);
 
-// TODO: Implement post processing shaders and convert this to new format
 // Apply fog effect to the entire screen based on depth values
+// Shorthand for a post-process chain holding only fog_pass, see post_process.h to combine it with other passes
+// Uses its own fog table, the renderer's one set with set_fog_lut is left alone
 // fog_start: distance at which fog starts
 // fog_end: distance at which fog fully obscures
 // fog_r, fog_g, fog_b: RGB color of the fog
 void apply_fog_to_screen(renderer_t *restrict state, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b);
 
 // Apply dithering effect to a color based on fragment coordinates and number of steps, used in fragment shaders to reduce color banding
+// Recomputes the quantization per call, prefer set_dither_lut + apply_dither_lut in shaders
 u32 apply_dither_u32(u32 color, float2 frag_coord, float steps);
 
-void transform_get_basis_vectors(transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat);
-void transform_get_inverse_basis_vectors(transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat);
+// Precompute a fog table, e.g. one handed to fog_pass in place of the renderer's
+// fog_start: distance at which fog starts
+// fog_end: distance at which fog fully obscures, must be greater than fog_start
+// fog_r, fog_g, fog_b: RGB color of the fog
+void init_fog_lut(fog_lut_t *lut, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b);
+
+// Precompute the renderer's fog table, used by apply_fog_lut and fog_pass, arguments as for init_fog_lut
+// init_renderer sets one fading to black over the back half of max_depth
+void set_fog_lut(renderer_t *state, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b);
+
+// Blend a color toward the fog color using the renderer's fog table
+// depth: depth of the pixel, as stored in the depth buffer
+u32 apply_fog_lut(const renderer_t *restrict state, u32 color, f32 depth);
+
+// Precompute the renderer's dither table, used by apply_dither_lut and dither_pass
+// steps: quantization levels per channel
+void set_dither_lut(renderer_t *state, f32 steps);
+
+// Dither and quantize a color using the renderer's dither table, same result as apply_dither_u32
+// screen_x, screen_y: pixel coordinates, selecting the checkerboard offset
+u32 apply_dither_lut(const renderer_t *restrict state, u32 color, int screen_x, int screen_y);
+
+void transform_get_basis_vectors(const transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat);
+void transform_get_inverse_basis_vectors(const transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat);
 
 #endif // SHADER_WORKS_RENDERER_H
@@ -12,6 +12,15 @@ typedef struct {
   bool is_directional;
 } light_t;
 
+struct shadow_map_t;
+
+// Per-instance attributes for render_model_instanced, see model_instance_t
+typedef struct {
+  float2 uv_offset;     // Added to every vertex UV, e.g. to pick an atlas tile
+  u32 color;            // Base color of untextured models, in place of model_t.flat_color
+  void *arg;            // User-defined per-instance shader argument
+} instance_data_t;
+
 // Fragment shader context structures
 typedef struct {
   float3 world_pos;     // Interpolated world position of this specific pixel
@@ -23,6 +32,8 @@ typedef struct {
   float time;           // Frame time for animations
   light_t *light;       // Light information
   usize light_count;    // Number of lights
+  const instance_data_t *instance; // Attributes of the instance being drawn, NULL outside render_model_instanced
+  const struct shadow_map_t *shadow_map; // Light depth for shadow_map_occluded, NULL unless set_shadow_map was called
 } fragment_context_t;
 
 // Vertex shader context structure
@@ -50,6 +61,8 @@ typedef struct {
   float2 original_uv;       // Original UV coordinates
 
   float3 *original_normal;  // Original normal vector
+
+  const instance_data_t *instance; // Attributes of the instance being drawn, NULL outside render_model_instanced
 } vertex_context_t;
 
 // Shader function pointers
@@ -0,0 +1,23 @@
+#ifndef SHADER_WORKS_SHADING_CACHE_H
+#define SHADER_WORKS_SHADING_CACHE_H
+
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+#include <shader-works/shaders.h>
+
+// Bake a procedural fragment shader over a model's surface into model->shading_cache
+// Each texel is shaded once at the world position its UV maps to. From then on render_model samples the cache at
+// each pixel's UV and passes that color to the model's frag_shader as input, so per-pixel noise becomes a fetch
+// The model's UVs must cover its surface in [0, 1] without overlapping, and the baked shader may only read
+// world_pos, normal and uv from its context; time, depth, lights and screen data are zero
+// Only the model is touched, so a model that is not being drawn can be baked on a worker thread
+// model: model to bake, any previous cache is replaced. Vertex shaders are not applied
+// shader: shader to bake, called with the model's flat_color as input
+// width, height: cache resolution, e.g. texels per world unit times the surface's extent
+// Returns 0 on success, -1 on allocation failure (the model is left without a cache)
+int bake_shading_cache(model_t *model, const fragment_shader_t *shader, u32 width, u32 height);
+
+// Drop a model's baked colors, rendering goes back to its texture or flat color
+void free_shading_cache(model_t *model);
+
+#endif // SHADER_WORKS_SHADING_CACHE_H
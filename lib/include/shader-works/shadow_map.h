@@ -0,0 +1,49 @@
+#ifndef SHADER_WORKS_SHADOW_MAP_H
+#define SHADER_WORKS_SHADOW_MAP_H
+
+#include <stdbool.h>
+#include <shader-works/maths.h>
+#include <shader-works/shaders.h>
+#include <shader-works/primitives.h>
+
+struct renderer_t;
+
+// Depth of the scene seen along a directional light, through an orthographic square centred on a point of interest
+typedef struct shadow_map_t {
+  f32 *depth;           // size * size distances along forward from center, rows run down the up axis
+  u32 size;             // texels along each side
+
+  float3 center;        // world point at the middle of the map
+  float3 right, up, forward; // light basis, forward is the way the light's rays travel
+  f32 extent;           // half the width of the covered square in world units
+  f32 texels_per_unit;  // size / (2 * extent)
+  f32 bias;             // depth a receiver must lie behind the stored depth to count as shadowed
+} shadow_map_t;
+
+// Allocate a square shadow map
+// size: texels along each side
+// bias: depth offset in world units against self shadowing, around a texel's width works for most scenes
+// Returns 0 on success, -1 on allocation failure
+int init_shadow_map(shadow_map_t *map, u32 size, f32 bias);
+void free_shadow_map(shadow_map_t *map);
+
+// Clear the map and aim it for this frame's casters
+// light: directional light, its direction is taken as the way its rays travel
+// center: world point the map is centred on, e.g. the camera position
+// extent: half the width of the covered square, receivers outside it are never shadowed
+void begin_shadow_map(shadow_map_t *map, const light_t *light, float3 center, f32 extent);
+
+// Rasterize a model's depth into the map, the same triangles render_model would draw but depth only from the light
+// Vertex shaders run as they do for render_model, with the light basis in place of the camera's
+// Both faces are drawn, so thin or open casters still block light. Returns the number of triangles rasterized
+usize render_model_shadow(struct renderer_t *state, shadow_map_t *map, model_t *model);
+
+// Hand the map to fragment shaders of everything rendered after this, through fragment_context_t.shadow_map
+// map: the map to expose, or NULL to stop
+void set_shadow_map(struct renderer_t *state, const shadow_map_t *map);
+
+// Whether world_pos is hidden from the map's light, a single depth compare
+// Returns false when map is NULL or world_pos lies outside the map
+bool shadow_map_occluded(const shadow_map_t *map, float3 world_pos);
+
+#endif // SHADER_WORKS_SHADOW_MAP_H
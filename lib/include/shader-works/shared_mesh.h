@@ -0,0 +1,37 @@
+#ifndef SHADER_WORKS_SHARED_MESH_H
+#define SHADER_WORKS_SHARED_MESH_H
+
+#include <stdbool.h>
+#include <shader-works/maths.h>
+#include <shader-works/primitives.h>
+
+// Geometry many models draw from one copy: vertices, face normals, bounds and LODs, freed with the last reference
+// Models made from it differ only in transform, scale, shaders and anything baked per model such as shading caches
+// Treat it as immutable once a second model uses it, an edit shows up on every model
+typedef struct shared_mesh_t {
+  model_t model;                // owns the geometry, its transform and shaders are unused
+  u32 ref_count;
+  char *path;                   // key in the loader cache, NULL for meshes from create_shared_mesh
+  bool flip_winding;
+  struct shared_mesh_t *next;   // loader cache chain
+} shared_mesh_t;
+
+// Take over a populated model as a shared mesh with one reference, the model is zeroed
+// Returns NULL on allocation failure, with the model untouched
+shared_mesh_t *create_shared_mesh(model_t *model);
+
+// The shared mesh for an OBJ file, from load_obj_model on the first request and looked up by path and winding after that
+// Each call adds a reference, the cache forgets the mesh when its last reference is released
+// Edits made before anyone else loads the path, e.g. remapped UVs or LODs, are what later callers get
+// The cache doesn't lock, load and release cached meshes from one thread
+// Returns NULL when the file can't be loaded
+shared_mesh_t *load_shared_mesh(const char *filename, bool flip_winding);
+
+void retain_shared_mesh(shared_mesh_t *mesh);
+void release_shared_mesh(shared_mesh_t *mesh);
+
+// Point model at mesh's geometry, bounds and LODs without copying them and copy its use_textures
+// Adds a reference that delete_model releases, the model's transform, scale and shaders are left alone
+void init_model_from_shared_mesh(model_t *model, shared_mesh_t *mesh);
+
+#endif // SHADER_WORKS_SHARED_MESH_H
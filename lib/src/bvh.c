@@ -0,0 +1,413 @@
+#include <shader-works/bvh.h>
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Traversal stack bvh_cull keeps on the C stack, balancing keeps real trees far below this and deeper ones get a heap stack
+#define BVH_STACK_SIZE 128
+
+static inline float3 box_union_min(float3 a, float3 b) {
+  return make_float3(fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z));
+}
+
+static inline float3 box_union_max(float3 a, float3 b) {
+  return make_float3(fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z));
+}
+
+// Surface area of a box, the cost metric used to choose where leaves are inserted
+static inline f32 box_area(float3 min, float3 max) {
+  f32 dx = max.x - min.x, dy = max.y - min.y, dz = max.z - min.z;
+  return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+static inline bool is_leaf(const bvh_node_t *node) {
+  return node->left == BVH_NULL_NODE;
+}
+
+// Chains nodes [first, capacity) onto the free list
+static void link_free_nodes(bvh_t *bvh, int first) {
+  for (int i = first; i < bvh->capacity - 1; ++i) {
+    bvh->nodes[i].parent = i + 1;
+    bvh->nodes[i].height = -1;
+  }
+  bvh->nodes[bvh->capacity - 1].parent = BVH_NULL_NODE;
+  bvh->nodes[bvh->capacity - 1].height = -1;
+  bvh->free_list = first;
+}
+
+// Takes a node from the free list, doubling the pool when it runs out
+static int alloc_node(bvh_t *bvh) {
+  if (bvh->free_list == BVH_NULL_NODE) {
+    int new_capacity = bvh->capacity * 2;
+    bvh_node_t *nodes = sw_realloc(bvh->nodes, new_capacity * sizeof(bvh_node_t), SW_MEMORY_OTHER);
+    if (!nodes) return BVH_NULL_NODE;
+
+    int old_capacity = bvh->capacity;
+    bvh->nodes = nodes;
+    bvh->capacity = new_capacity;
+    link_free_nodes(bvh, old_capacity);
+  }
+
+  int id = bvh->free_list;
+  bvh_node_t *node = &bvh->nodes[id];
+  bvh->free_list = node->parent;
+
+  node->parent = node->left = node->right = BVH_NULL_NODE;
+  node->height = 0;
+  node->user = NULL;
+  return id;
+}
+
+static void release_node(bvh_t *bvh, int id) {
+  bvh->nodes[id].parent = bvh->free_list;
+  bvh->nodes[id].height = -1;
+  bvh->free_list = id;
+}
+
+// Recomputes an internal node's box and height from its children
+static void fit_node(bvh_t *bvh, int id) {
+  bvh_node_t *node = &bvh->nodes[id];
+  const bvh_node_t *left = &bvh->nodes[node->left];
+  const bvh_node_t *right = &bvh->nodes[node->right];
+
+  node->min = box_union_min(left->min, right->min);
+  node->max = box_union_max(left->max, right->max);
+  node->height = 1 + (left->height > right->height ? left->height : right->height);
+}
+
+// Rotates the taller child of an unbalanced node above it, returns the subtree's new root
+static int balance_node(bvh_t *bvh, int a_id) {
+  bvh_node_t *a = &bvh->nodes[a_id];
+  if (is_leaf(a) || a->height < 2) return a_id;
+
+  int b_id = a->left, c_id = a->right;
+  int balance = bvh->nodes[c_id].height - bvh->nodes[b_id].height;
+  if (balance >= -1 && balance <= 1) return a_id;
+
+  // Promote the taller child, its taller grandchild stays below it and the other one moves under a
+  int up_id = balance > 1 ? c_id : b_id;
+  int other_id = balance > 1 ? b_id : c_id;
+  bvh_node_t *up = &bvh->nodes[up_id];
+
+  int f_id = up->left, g_id = up->right;
+  int keep_id = bvh->nodes[f_id].height > bvh->nodes[g_id].height ? f_id : g_id;
+  int move_id = keep_id == f_id ? g_id : f_id;
+
+  // up takes a's place
+  up->parent = a->parent;
+  if (up->parent != BVH_NULL_NODE) {
+    bvh_node_t *parent = &bvh->nodes[up->parent];
+    if (parent->left == a_id) parent->left = up_id;
+    else parent->right = up_id;
+  } else {
+    bvh->root = up_id;
+  }
+
+  up->left = a_id;
+  up->right = keep_id;
+  a->parent = up_id;
+  bvh->nodes[keep_id].parent = up_id;
+
+  a->left = other_id;
+  a->right = move_id;
+  bvh->nodes[other_id].parent = a_id;
+  bvh->nodes[move_id].parent = a_id;
+
+  fit_node(bvh, a_id);
+  fit_node(bvh, up_id);
+  return up_id;
+}
+
+// Walks from a node to the root, rebalancing and refitting every ancestor
+static void refit_ancestors(bvh_t *bvh, int id) {
+  while (id != BVH_NULL_NODE) {
+    id = balance_node(bvh, id);
+    fit_node(bvh, id);
+    id = bvh->nodes[id].parent;
+  }
+}
+
+int init_bvh(bvh_t *bvh, int initial_capacity) {
+  assert(bvh != NULL);
+
+  if (initial_capacity < 16) initial_capacity = 16;
+
+  bvh->nodes = sw_alloc(initial_capacity * sizeof(bvh_node_t), SW_MEMORY_OTHER);
+  if (!bvh->nodes) return -1;
+
+  bvh->capacity = initial_capacity;
+  bvh->root = BVH_NULL_NODE;
+  bvh->leaf_count = 0;
+  link_free_nodes(bvh, 0);
+  return 0;
+}
+
+void free_bvh(bvh_t *bvh) {
+  if (!bvh) return;
+
+  sw_free(bvh->nodes);
+  bvh->nodes = NULL;
+  bvh->capacity = 0;
+  bvh->root = bvh->free_list = BVH_NULL_NODE;
+  bvh->leaf_count = 0;
+}
+
+int bvh_insert(bvh_t *bvh, float3 min, float3 max, void *user) {
+  assert(bvh != NULL && bvh->nodes != NULL);
+
+  int leaf = alloc_node(bvh);
+  if (leaf == BVH_NULL_NODE) return -1;
+
+  bvh->nodes[leaf].min = min;
+  bvh->nodes[leaf].max = max;
+  bvh->nodes[leaf].user = user;
+  bvh->leaf_count++;
+
+  if (bvh->root == BVH_NULL_NODE) {
+    bvh->root = leaf;
+    return leaf;
+  }
+
+  // Descend toward the sibling that grows the tree's total surface area the least
+  int index = bvh->root;
+  while (!is_leaf(&bvh->nodes[index])) {
+    const bvh_node_t *node = &bvh->nodes[index];
+    f32 area = box_area(node->min, node->max);
+    f32 combined = box_area(box_union_min(node->min, min), box_union_max(node->max, max));
+
+    f32 cost_here = 2.0f * combined;           // pair the leaf with this whole subtree
+    f32 inherited = 2.0f * (combined - area);  // growth pushed onto every ancestor by going deeper
+
+    f32 child_cost[2];
+    int children[2] = { node->left, node->right };
+    for (int i = 0; i < 2; ++i) {
+      const bvh_node_t *child = &bvh->nodes[children[i]];
+      f32 grown = box_area(box_union_min(child->min, min), box_union_max(child->max, max));
+      child_cost[i] = (is_leaf(child) ? grown : grown - box_area(child->min, child->max)) + inherited;
+    }
+
+    if (cost_here < child_cost[0] && cost_here < child_cost[1]) break;
+    index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+  }
+
+  // Join the leaf and its sibling under a new parent
+  int sibling = index;
+  int old_parent = bvh->nodes[sibling].parent;
+  int new_parent = alloc_node(bvh);
+  if (new_parent == BVH_NULL_NODE) {
+    release_node(bvh, leaf);
+    bvh->leaf_count--;
+    return -1;
+  }
+
+  bvh->nodes[new_parent].parent = old_parent;
+  bvh->nodes[new_parent].left = sibling;
+  bvh->nodes[new_parent].right = leaf;
+  bvh->nodes[sibling].parent = new_parent;
+  bvh->nodes[leaf].parent = new_parent;
+
+  if (old_parent != BVH_NULL_NODE) {
+    bvh_node_t *parent = &bvh->nodes[old_parent];
+    if (parent->left == sibling) parent->left = new_parent;
+    else parent->right = new_parent;
+  } else {
+    bvh->root = new_parent;
+  }
+
+  refit_ancestors(bvh, new_parent);
+  return leaf;
+}
+
+void bvh_remove(bvh_t *bvh, int proxy) {
+  assert(bvh != NULL);
+  assert(proxy >= 0 && proxy < bvh->capacity && is_leaf(&bvh->nodes[proxy]) && bvh->nodes[proxy].height == 0);
+
+  bvh->leaf_count--;
+
+  if (proxy == bvh->root) {
+    bvh->root = BVH_NULL_NODE;
+    release_node(bvh, proxy);
+    return;
+  }
+
+  // The sibling takes the parent's place
+  int parent = bvh->nodes[proxy].parent;
+  int grandparent = bvh->nodes[parent].parent;
+  int sibling = bvh->nodes[parent].left == proxy ? bvh->nodes[parent].right : bvh->nodes[parent].left;
+
+  bvh->nodes[sibling].parent = grandparent;
+  if (grandparent != BVH_NULL_NODE) {
+    bvh_node_t *node = &bvh->nodes[grandparent];
+    if (node->left == parent) node->left = sibling;
+    else node->right = sibling;
+    refit_ancestors(bvh, grandparent);
+  } else {
+    bvh->root = sibling;
+  }
+
+  release_node(bvh, parent);
+  release_node(bvh, proxy);
+}
+
+void bvh_refit(bvh_t *bvh, int proxy, float3 min, float3 max) {
+  assert(bvh != NULL);
+  assert(proxy >= 0 && proxy < bvh->capacity && is_leaf(&bvh->nodes[proxy]) && bvh->nodes[proxy].height == 0);
+
+  bvh->nodes[proxy].min = min;
+  bvh->nodes[proxy].max = max;
+
+  // Only box sizes change, so fit without rotating
+  for (int id = bvh->nodes[proxy].parent; id != BVH_NULL_NODE; id = bvh->nodes[id].parent) {
+    fit_node(bvh, id);
+  }
+}
+
+typedef struct {
+  float3 normal;
+  f32 offset;           // inside when dot(normal, p) + offset >= 0
+} bvh_plane_t;
+
+// A node waiting to be visited with the planes its subtree still straddles, a cleared bit means fully inside that plane
+typedef struct {
+  int node;
+  u32 mask;
+} bvh_stack_entry_t;
+
+static int compare_draw_items(const void *a, const void *b) {
+  f32 da = ((const bvh_draw_item_t *)a)->depth;
+  f32 db = ((const bvh_draw_item_t *)b)->depth;
+  return (da > db) - (da < db);
+}
+
+// Keeps the closest items seen so far as a max heap on depth, so the farthest one is first in line to be replaced
+static void push_draw_item(bvh_draw_item_t *items, usize *count, usize max_items, bvh_draw_item_t item) {
+  usize i;
+  if (*count < max_items) {
+    // Sift the new item up from the end
+    i = (*count)++;
+    while (i > 0 && items[(i - 1) / 2].depth < item.depth) {
+      items[i] = items[(i - 1) / 2];
+      i = (i - 1) / 2;
+    }
+    items[i] = item;
+    return;
+  }
+
+  if (item.depth >= items[0].depth) return;
+
+  // Replace the farthest and sift it down
+  i = 0;
+  for (;;) {
+    usize child = 2 * i + 1;
+    if (child >= max_items) break;
+    if (child + 1 < max_items && items[child + 1].depth > items[child].depth) child++;
+    if (items[child].depth <= item.depth) break;
+
+    items[i] = items[child];
+    i = child;
+  }
+  items[i] = item;
+}
+
+usize bvh_cull(const bvh_t *bvh, const renderer_t *state, const transform_t *cam, bvh_draw_item_t *items, usize max_items) {
+  assert(bvh != NULL);
+  assert(state != NULL);
+  assert(cam != NULL);
+  assert(items != NULL || max_items == 0);
+
+  if (bvh->root == BVH_NULL_NODE || max_items == 0) return 0;
+
+  // The region render_model keeps, |x|, |y| <= -z * frustum_bound and z <= 0 in view space, as world space planes
+  f32 fb = state->frustum_bound;
+  float3 right = state->cam_right, up = state->cam_up, forward = state->cam_forward;
+  float3 back = float3_scale(forward, -fb);
+  float3 normals[5] = {
+    float3_add(right, back),                      // left
+    float3_add(float3_scale(right, -1.0f), back), // right
+    float3_add(up, back),                         // bottom
+    float3_add(float3_scale(up, -1.0f), back),    // top
+    float3_scale(forward, -1.0f),                 // behind the camera
+  };
+
+  bvh_plane_t planes[5];
+  for (int i = 0; i < 5; ++i) {
+    planes[i].normal = normals[i];
+    planes[i].offset = -float3_dot(normals[i], cam->position);
+  }
+
+  // Depth first, each visit pops one entry and pushes two a level down, so the stack never holds more than height + 1
+  bvh_stack_entry_t local_stack[BVH_STACK_SIZE];
+  bvh_stack_entry_t *stack = local_stack;
+  usize stack_size = (usize)bvh->nodes[bvh->root].height + 1;
+  if (stack_size > BVH_STACK_SIZE) {
+    stack = sw_alloc(stack_size * sizeof(bvh_stack_entry_t), SW_MEMORY_SCRATCH);
+    if (!stack) return 0;
+  }
+
+  usize top = 0;
+  stack[top++] = (bvh_stack_entry_t){ bvh->root, (1u << 5) - 1 };
+
+  usize count = 0;
+  while (top > 0) {
+    bvh_stack_entry_t entry = stack[--top];
+    const bvh_node_t *node = &bvh->nodes[entry.node];
+    u32 mask = entry.mask;
+
+    bool outside = false;
+    for (int i = 0; i < 5 && mask; ++i) {
+      if (!(mask & (1u << i))) continue;
+
+      float3 n = planes[i].normal;
+      // Box corners farthest along and against the plane normal
+      float3 far = make_float3(n.x >= 0 ? node->max.x : node->min.x, n.y >= 0 ? node->max.y : node->min.y, n.z >= 0 ? node->max.z : node->min.z);
+      float3 near = make_float3(n.x >= 0 ? node->min.x : node->max.x, n.y >= 0 ? node->min.y : node->max.y, n.z >= 0 ? node->min.z : node->max.z);
+
+      if (float3_dot(n, far) + planes[i].offset < 0.0f) { outside = true; break; }
+      if (float3_dot(n, near) + planes[i].offset >= 0.0f) mask &= ~(1u << i);
+    }
+    if (outside) continue;
+
+    if (is_leaf(node)) {
+      float3 center = float3_scale(float3_add(node->min, node->max), 0.5f);
+      bvh_draw_item_t item = { node->user, -float3_dot(float3_sub(center, cam->position), forward) };
+      push_draw_item(items, &count, max_items, item);
+      continue;
+    }
+
+    stack[top++] = (bvh_stack_entry_t){ node->left, mask };
+    stack[top++] = (bvh_stack_entry_t){ node->right, mask };
+  }
+
+  if (stack != local_stack) sw_free(stack);
+
+  qsort(items, count, sizeof(bvh_draw_item_t), compare_draw_items);
+  return count;
+}
+
+void get_model_world_bounds(const model_t *model, float3 *min, float3 *max) {
+  assert(model != NULL);
+  assert(min != NULL && max != NULL);
+
+  float3 ihat, jhat, khat;
+  transform_get_basis_vectors(&model->transform, &ihat, &jhat, &khat);
+
+  float3 s = model->scale;
+  float3 local_center = float3_scale(float3_add(model->bounds_min, model->bounds_max), 0.5f);
+  float3 local_extent = float3_scale(float3_sub(model->bounds_max, model->bounds_min), 0.5f);
+  local_center = make_float3(local_center.x * s.x, local_center.y * s.y, local_center.z * s.z);
+  local_extent = make_float3(local_extent.x * fabsf(s.x), local_extent.y * fabsf(s.y), local_extent.z * fabsf(s.z));
+
+  // Rotated box extents: each world axis collects the absolute projection of every local axis
+  float3 center = float3_add(float3_add(float3_add(float3_scale(ihat, local_center.x), float3_scale(jhat, local_center.y)),
+                                        float3_scale(khat, local_center.z)), model->transform.position);
+  float3 extent = make_float3(
+    fabsf(ihat.x) * local_extent.x + fabsf(jhat.x) * local_extent.y + fabsf(khat.x) * local_extent.z,
+    fabsf(ihat.y) * local_extent.x + fabsf(jhat.y) * local_extent.y + fabsf(khat.y) * local_extent.z,
+    fabsf(ihat.z) * local_extent.x + fabsf(jhat.z) * local_extent.y + fabsf(khat.z) * local_extent.z
+  );
+
+  *min = float3_sub(center, extent);
+  *max = float3_add(center, extent);
+}
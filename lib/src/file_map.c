@@ -0,0 +1,114 @@
+#include "file_map.h"
+
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define FILE_MAP_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef FILE_MAP_USE_MMAP
+int map_file(file_map_t *map, const char *path) {
+  assert(map != NULL && path != NULL);
+  *map = (file_map_t){0};
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return -1;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  // mmap refuses zero lengths, an empty file is just no data
+  if (info.st_size == 0) {
+    close(fd);
+    return 0;
+  }
+
+  // Copy on write, pages are shared with every other mapping of the file until someone writes to them
+  void *data = mmap(NULL, (usize)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return -1;
+
+#ifdef MADV_SEQUENTIAL
+  madvise(data, (usize)info.st_size, MADV_SEQUENTIAL);
+#endif
+
+  map->data = data;
+  map->size = (usize)info.st_size;
+  return 0;
+}
+
+void unmap_file(file_map_t *map) {
+  if (!map) return;
+
+  if (map->data) munmap(map->data, map->size);
+  *map = (file_map_t){0};
+}
+#else
+int map_file(file_map_t *map, const char *path) {
+  assert(map != NULL && path != NULL);
+  *map = (file_map_t){0};
+
+  FILE *file = fopen(path, "rb");
+  if (!file) return -1;
+
+  long size = -1;
+  if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+  if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+    fclose(file);
+    return -1;
+  }
+
+  if (size == 0) {
+    fclose(file);
+    return 0;
+  }
+
+  map->buffer = sw_alloc((usize)size, SW_MEMORY_SCRATCH);
+  if (!map->buffer || fread(map->buffer, 1, (usize)size, file) != (usize)size) {
+    sw_free(map->buffer);
+    map->buffer = NULL;
+    fclose(file);
+    return -1;
+  }
+
+  fclose(file);
+  map->data = map->buffer;
+  map->size = (usize)size;
+  return 0;
+}
+
+void unmap_file(file_map_t *map) {
+  if (!map) return;
+
+  sw_free(map->buffer);
+  *map = (file_map_t){0};
+}
+#endif
+
+u64 file_stamp(const char *path) {
+  assert(path != NULL);
+
+  struct stat info;
+  if (stat(path, &info) != 0) return 0;
+
+  // Whole seconds miss an edit made within a second of the last one, fold in the nanoseconds where stat has them
+  u64 nanoseconds = 0;
+#if defined(__APPLE__)
+  nanoseconds = (u64)info.st_mtimespec.tv_nsec;
+#elif defined(__unix__)
+  nanoseconds = (u64)info.st_mtim.tv_nsec;
+#endif
+
+  u64 stamp = (u64)info.st_size * 0x9E3779B97F4A7C15ull ^ ((u64)info.st_mtime * 1000000000ull + nanoseconds);
+  return stamp ? stamp : 1;
+}
@@ -0,0 +1,22 @@
+#ifndef SHADER_WORKS_FILE_MAP_H
+#define SHADER_WORKS_FILE_MAP_H
+
+#include <shader-works/maths.h>
+
+// Internal private view of a whole file, shared by the mesh loaders
+
+typedef struct {
+  u8 *data;         // file contents, not NUL terminated, NULL for an empty file. Writes stay private and never reach the file
+  usize size;
+  void *buffer;     // heap copy where the platform can't map files, freed by unmap_file
+} file_map_t;
+
+// Map path into memory, or read it into a buffer where mapping isn't available
+// Returns 0 on success, -1 when the file can't be opened or read
+int map_file(file_map_t *map, const char *path);
+void unmap_file(file_map_t *map);
+
+// Size and modification time, to the nanosecond where the platform keeps it, of path folded into one value that changes when the file does, 0 when it doesn't exist
+u64 file_stamp(const char *path);
+
+#endif // SHADER_WORKS_FILE_MAP_H
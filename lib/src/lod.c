@@ -0,0 +1,509 @@
+#include <shader-works/lod.h>
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Weight of the planes holding open edges on their line, relative to the surface's own planes
+#define BOUNDARY_WEIGHT 100.0
+
+// Smallest cosine between a face's normal before and after a collapse, anything less folds the surface over
+#define MIN_FLIP_COSINE 0.2f
+
+// Symmetric 4x4 error quadric, upper triangle: aa ab ac ad bb bc bd cc cd dd
+typedef struct {
+  double q[10];
+} quadric_t;
+
+// Welded position, corners keep their own UVs so seams do not stop the mesh simplifying
+typedef struct {
+  float3 position;
+  quadric_t quadric;
+  int *faces;             // faces using this vertex, may hold faces that have since collapsed
+  int num_faces, face_capacity;
+  u32 stamp;              // bumped whenever the vertex changes, invalidating queued collapses that used it
+  bool removed;
+} lod_vertex_t;
+
+// Candidate edge collapse, remove is merged into keep which stays where it is
+typedef struct {
+  double cost;
+  int keep, remove;
+  u32 keep_stamp, remove_stamp;
+} collapse_t;
+
+// UV a corner of the removed vertex takes on, read from a face the collapse deletes
+typedef struct {
+  float2 from, to;
+} uv_remap_t;
+
+#define MAX_UV_REMAPS 8
+
+typedef struct {
+  lod_vertex_t *verts;
+  int num_verts;
+
+  int (*tris)[3];
+  float2 (*tri_uvs)[3];   // UV of each corner
+  float3 *tri_normals;    // original face normals, keeps emitted faces facing the way the source did
+  bool *tri_alive;
+  int num_tris, alive_tris;
+
+  collapse_t *heap;       // binary min-heap on cost
+  usize heap_count, heap_capacity;
+} simplifier_t;
+
+static void quadric_add_plane(quadric_t *quadric, double a, double b, double c, double d, double weight) {
+  double *q = quadric->q;
+  q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c; q[3] += weight * a * d;
+  q[4] += weight * b * b; q[5] += weight * b * c; q[6] += weight * b * d;
+  q[7] += weight * c * c; q[8] += weight * c * d;
+  q[9] += weight * d * d;
+}
+
+static double quadric_error(const quadric_t *quadric, float3 v) {
+  const double *q = quadric->q;
+  double x = v.x, y = v.y, z = v.z;
+  return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x
+       + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y
+       + q[7] * z * z + 2 * q[8] * z
+       + q[9];
+}
+
+static bool heap_push(simplifier_t *s, collapse_t item) {
+  if (s->heap_count == s->heap_capacity) {
+    usize capacity = s->heap_capacity ? s->heap_capacity * 2 : 256;
+    collapse_t *heap = sw_realloc(s->heap, capacity * sizeof(collapse_t), SW_MEMORY_SCRATCH);
+    if (!heap) return false;
+
+    s->heap = heap;
+    s->heap_capacity = capacity;
+  }
+
+  usize i = s->heap_count++;
+  while (i > 0) {
+    usize parent = (i - 1) / 2;
+    if (s->heap[parent].cost <= item.cost) break;
+    s->heap[i] = s->heap[parent];
+    i = parent;
+  }
+  s->heap[i] = item;
+  return true;
+}
+
+static collapse_t heap_pop(simplifier_t *s) {
+  collapse_t top = s->heap[0];
+  collapse_t last = s->heap[--s->heap_count];
+
+  usize i = 0;
+  for (;;) {
+    usize child = 2 * i + 1;
+    if (child >= s->heap_count) break;
+    if (child + 1 < s->heap_count && s->heap[child + 1].cost < s->heap[child].cost) ++child;
+    if (last.cost <= s->heap[child].cost) break;
+    s->heap[i] = s->heap[child];
+    i = child;
+  }
+  if (s->heap_count > 0) s->heap[i] = last;
+
+  return top;
+}
+
+static bool add_vertex_face(lod_vertex_t *v, int face) {
+  if (v->num_faces == v->face_capacity) {
+    int capacity = v->face_capacity ? v->face_capacity * 2 : 8;
+    int *faces = sw_realloc(v->faces, (usize)capacity * sizeof(int), SW_MEMORY_SCRATCH);
+    if (!faces) return false;
+
+    v->faces = faces;
+    v->face_capacity = capacity;
+  }
+
+  v->faces[v->num_faces++] = face;
+  return true;
+}
+
+// Cheaper direction to merge edge a-b, onto a or onto b
+// Only the end positions are tried, so corners keep UVs that exist on the surface
+static collapse_t find_collapse(const simplifier_t *s, int a, int b) {
+  const lod_vertex_t *va = &s->verts[a], *vb = &s->verts[b];
+
+  quadric_t q = va->quadric;
+  for (int i = 0; i < 10; ++i) q.q[i] += vb->quadric.q[i];
+
+  double onto_a = quadric_error(&q, va->position);
+  double onto_b = quadric_error(&q, vb->position);
+
+  if (onto_a <= onto_b) return (collapse_t){ onto_a, a, b, va->stamp, vb->stamp };
+  return (collapse_t){ onto_b, b, a, vb->stamp, va->stamp };
+}
+
+static bool queue_edge(simplifier_t *s, int a, int b) {
+  return heap_push(s, find_collapse(s, a, b));
+}
+
+static inline int tri_corner(const int tri[3], int v) {
+  return tri[0] == v ? 0 : (tri[1] == v ? 1 : (tri[2] == v ? 2 : -1));
+}
+
+// Pairs each UV remove has on the deleted faces with keep's UV on the same face
+// Returns the number of pairs
+static int find_uv_remaps(const simplifier_t *s, const collapse_t *c, uv_remap_t remaps[MAX_UV_REMAPS]) {
+  const lod_vertex_t *remove = &s->verts[c->remove];
+  int count = 0;
+
+  for (int i = 0; i < remove->num_faces && count < MAX_UV_REMAPS; ++i) {
+    int f = remove->faces[i];
+    int k = tri_corner(s->tris[f], c->keep);
+    if (!s->tri_alive[f] || k < 0) continue;
+
+    remaps[count++] = (uv_remap_t){ s->tri_uvs[f][tri_corner(s->tris[f], c->remove)], s->tri_uvs[f][k] };
+  }
+
+  return count;
+}
+
+static const uv_remap_t *find_remap(const uv_remap_t *remaps, int count, float2 uv) {
+  for (int i = 0; i < count; ++i) {
+    if (remaps[i].from.x == uv.x && remaps[i].from.y == uv.y) return &remaps[i];
+  }
+  return NULL;
+}
+
+static inline bool tri_has(const int tri[3], int v) {
+  return tri[0] == v || tri[1] == v || tri[2] == v;
+}
+
+// Whether merging remove into keep leaves every surviving face around remove facing the same way, with a UV
+// taken from keep's side of the same chart; a corner whose UV no deleted face shares lies across a seam
+static bool can_collapse(const simplifier_t *s, const collapse_t *c, const uv_remap_t *remaps, int num_remaps) {
+  const lod_vertex_t *remove = &s->verts[c->remove];
+  float3 target = s->verts[c->keep].position;
+
+  for (int i = 0; i < remove->num_faces; ++i) {
+    int f = remove->faces[i];
+    const int *tri = s->tris[f];
+    if (!s->tri_alive[f] || tri_has(tri, c->keep)) continue; // collapses away
+
+    int corner = tri_corner(tri, c->remove);
+    if (!find_remap(remaps, num_remaps, s->tri_uvs[f][corner])) return false;
+
+    float3 before[3], after[3];
+    for (int k = 0; k < 3; ++k) {
+      before[k] = s->verts[tri[k]].position;
+      after[k] = k == corner ? target : before[k];
+    }
+
+    float3 n0 = float3_cross(float3_sub(before[1], before[0]), float3_sub(before[2], before[0]));
+    float3 n1 = float3_cross(float3_sub(after[1], after[0]), float3_sub(after[2], after[0]));
+    f32 len0 = float3_magnitude(n0), len1 = float3_magnitude(n1);
+    if (len1 <= 1e-12f) return false;
+    if (len0 > 1e-12f && float3_dot(n0, n1) < MIN_FLIP_COSINE * len0 * len1) return false;
+  }
+
+  return true;
+}
+
+// Merges c->remove into c->keep and queues the edges around keep again
+static bool apply_collapse(simplifier_t *s, const collapse_t *c, const uv_remap_t *remaps, int num_remaps) {
+  lod_vertex_t *keep = &s->verts[c->keep], *remove = &s->verts[c->remove];
+
+  for (int i = 0; i < 10; ++i) keep->quadric.q[i] += remove->quadric.q[i];
+  keep->stamp++;
+  remove->removed = true;
+
+  for (int i = 0; i < remove->num_faces; ++i) {
+    int f = remove->faces[i];
+    int *tri = s->tris[f];
+    if (!s->tri_alive[f]) continue;
+
+    if (tri_has(tri, c->keep)) {
+      s->tri_alive[f] = false;
+      s->alive_tris--;
+      continue;
+    }
+
+    int corner = tri_corner(tri, c->remove);
+    tri[corner] = c->keep;
+    s->tri_uvs[f][corner] = find_remap(remaps, num_remaps, s->tri_uvs[f][corner])->to;
+    if (!add_vertex_face(keep, f)) return false;
+  }
+
+  sw_free(remove->faces);
+  remove->faces = NULL;
+  remove->num_faces = remove->face_capacity = 0;
+
+  // Drop faces that collapsed while requeueing keep's edges
+  int kept = 0;
+  for (int i = 0; i < keep->num_faces; ++i) {
+    int f = keep->faces[i];
+    if (!s->tri_alive[f]) continue;
+    keep->faces[kept++] = f;
+
+    for (int k = 0; k < 3; ++k) {
+      int n = s->tris[f][k];
+      if (n != c->keep && !queue_edge(s, c->keep, n)) return false;
+    }
+  }
+  keep->num_faces = kept;
+
+  return true;
+}
+
+// Edge of one face, sorted to find the edges only one face uses
+typedef struct {
+  int a, b, face;
+} face_edge_t;
+
+static int compare_face_edges(const void *a, const void *b) {
+  const face_edge_t *ea = a, *eb = b;
+  if (ea->a != eb->a) return ea->a < eb->a ? -1 : 1;
+  if (ea->b != eb->b) return ea->b < eb->b ? -1 : 1;
+  return 0;
+}
+
+static inline u32 hash_position(float3 p) {
+  u32 bits[3];
+  memcpy(bits, &p, sizeof(float3));
+
+  u32 h = 2166136261u;
+  for (int i = 0; i < 3; ++i) h = (h ^ bits[i]) * 16777619u;
+  return h;
+}
+
+// Welds corners sharing a position into vertices and builds their faces and quadrics
+static bool build_simplifier(simplifier_t *s, const model_t *model) {
+  usize num_corners = model->num_vertices;
+  s->num_tris = (int)(num_corners / 3);
+
+  usize table_size = 16;
+  while (table_size < num_corners * 2) table_size <<= 1;
+
+  int *table = sw_alloc(table_size * sizeof(int), SW_MEMORY_SCRATCH);
+  int *corner_vertex = sw_alloc(num_corners * sizeof(int), SW_MEMORY_SCRATCH);
+  s->verts = sw_calloc(num_corners, sizeof(lod_vertex_t), SW_MEMORY_SCRATCH);
+  s->tris = sw_alloc((usize)s->num_tris * sizeof(*s->tris), SW_MEMORY_SCRATCH);
+  s->tri_uvs = sw_alloc((usize)s->num_tris * sizeof(*s->tri_uvs), SW_MEMORY_SCRATCH);
+  s->tri_normals = sw_alloc((usize)s->num_tris * sizeof(float3), SW_MEMORY_SCRATCH);
+  s->tri_alive = sw_alloc((usize)s->num_tris * sizeof(bool), SW_MEMORY_SCRATCH);
+  face_edge_t *edges = sw_alloc((usize)s->num_tris * 3 * sizeof(face_edge_t), SW_MEMORY_SCRATCH);
+
+  bool ok = table && corner_vertex && s->verts && s->tris && s->tri_uvs && s->tri_normals && s->tri_alive && edges;
+  if (!ok) goto done;
+
+  memset(table, 0xff, table_size * sizeof(int));
+  for (usize i = 0; i < num_corners; ++i) {
+    const vertex_data_t *corner = &model->vertex_data[i];
+    usize slot = hash_position(corner->position) & (table_size - 1);
+
+    while (table[slot] >= 0) {
+      if (memcmp(&s->verts[table[slot]].position, &corner->position, sizeof(float3)) == 0) break;
+      slot = (slot + 1) & (table_size - 1);
+    }
+
+    if (table[slot] < 0) {
+      table[slot] = s->num_verts;
+      s->verts[s->num_verts++] = (lod_vertex_t){ .position = corner->position };
+    }
+    corner_vertex[i] = table[slot];
+  }
+
+  int num_edges = 0;
+  for (int f = 0; f < s->num_tris; ++f) {
+    int *tri = s->tris[f];
+    for (int k = 0; k < 3; ++k) {
+      tri[k] = corner_vertex[f * 3 + k];
+      s->tri_uvs[f][k] = model->vertex_data[f * 3 + k].uv;
+    }
+
+    s->tri_normals[f] = model->face_normals ? model->face_normals[f] : make_float3(0, 0, 0);
+    s->tri_alive[f] = tri[0] != tri[1] && tri[1] != tri[2] && tri[2] != tri[0];
+    if (!s->tri_alive[f]) continue;
+    s->alive_tris++;
+
+    // Plane of the face weighted by its area, so large faces hold their shape more than slivers
+    float3 p0 = s->verts[tri[0]].position, p1 = s->verts[tri[1]].position, p2 = s->verts[tri[2]].position;
+    float3 n = float3_cross(float3_sub(p1, p0), float3_sub(p2, p0));
+    f32 len = float3_magnitude(n);
+    if (len > 0.0f) {
+      n = float3_scale(n, 1.0f / len);
+      for (int k = 0; k < 3; ++k) quadric_add_plane(&s->verts[tri[k]].quadric, n.x, n.y, n.z, -float3_dot(n, p0), 0.5 * len);
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      if (!add_vertex_face(&s->verts[tri[k]], f)) { ok = false; goto done; }
+
+      int a = tri[k], b = tri[(k + 1) % 3];
+      edges[num_edges++] = (face_edge_t){ a < b ? a : b, a < b ? b : a, f };
+    }
+  }
+
+  // Open edges get a plane through them at right angles to their face
+  qsort(edges, (usize)num_edges, sizeof(face_edge_t), compare_face_edges);
+  for (int i = 0; i < num_edges; ) {
+    int run = 1;
+    while (i + run < num_edges && compare_face_edges(&edges[i], &edges[i + run]) == 0) ++run;
+
+    if (run == 1) {
+      const int *tri = s->tris[edges[i].face];
+      float3 p0 = s->verts[edges[i].a].position, p1 = s->verts[edges[i].b].position;
+      float3 face_n = float3_cross(float3_sub(s->verts[tri[1]].position, s->verts[tri[0]].position),
+                                   float3_sub(s->verts[tri[2]].position, s->verts[tri[0]].position));
+      float3 edge = float3_sub(p1, p0);
+      float3 n = float3_cross(edge, face_n);
+      f32 len = float3_magnitude(n);
+
+      if (len > 0.0f) {
+        n = float3_scale(n, 1.0f / len);
+        double weight = BOUNDARY_WEIGHT * float3_dot(edge, edge);
+        quadric_add_plane(&s->verts[edges[i].a].quadric, n.x, n.y, n.z, -float3_dot(n, p0), weight);
+        quadric_add_plane(&s->verts[edges[i].b].quadric, n.x, n.y, n.z, -float3_dot(n, p0), weight);
+      }
+    }
+
+    if (!queue_edge(s, edges[i].a, edges[i].b)) { ok = false; goto done; }
+    i += run;
+  }
+
+done:
+  sw_free(table);
+  sw_free(corner_vertex);
+  sw_free(edges);
+  return ok;
+}
+
+static void free_simplifier(simplifier_t *s) {
+  if (s->verts) {
+    for (int i = 0; i < s->num_verts; ++i) sw_free(s->verts[i].faces);
+  }
+
+  sw_free(s->verts);
+  sw_free(s->tris);
+  sw_free(s->tri_uvs);
+  sw_free(s->tri_normals);
+  sw_free(s->tri_alive);
+  sw_free(s->heap);
+}
+
+// Copies the surviving faces out as a triangle soup like the source model's
+static bool emit_level(const simplifier_t *s, model_lod_t *lod) {
+  lod->num_faces = (usize)s->alive_tris;
+  lod->num_vertices = lod->num_faces * 3;
+  lod->vertex_data = sw_alloc(lod->num_vertices * sizeof(vertex_data_t), SW_MEMORY_GEOMETRY);
+  lod->face_normals = sw_alloc(lod->num_faces * sizeof(float3), SW_MEMORY_GEOMETRY);
+  if (!lod->vertex_data || !lod->face_normals) {
+    sw_free(lod->vertex_data);
+    sw_free(lod->face_normals);
+    return false;
+  }
+
+  usize face = 0;
+  for (int f = 0; f < s->num_tris; ++f) {
+    if (!s->tri_alive[f]) continue;
+
+    const int *tri = s->tris[f];
+    float3 p0 = s->verts[tri[0]].position, p1 = s->verts[tri[1]].position, p2 = s->verts[tri[2]].position;
+    float3 n = float3_normalize(float3_cross(float3_sub(p1, p0), float3_sub(p2, p0)));
+    if (float3_dot(n, s->tri_normals[f]) < 0.0f) n = float3_scale(n, -1.0f);
+
+    lod->face_normals[face] = n;
+    for (int k = 0; k < 3; ++k) {
+      lod->vertex_data[face * 3 + k] = (vertex_data_t){ s->verts[tri[k]].position, s->tri_uvs[f][k], n };
+    }
+    ++face;
+  }
+
+  return true;
+}
+
+int generate_model_lods(model_t *model, int num_levels, f32 reduction) {
+  assert(model != NULL && model->vertex_data != NULL);
+  assert(model->shared_mesh == NULL);
+  assert(model->num_vertices % 3 == 0);
+  assert(num_levels > 0);
+  assert(reduction > 0.0f && reduction < 1.0f);
+
+  free_model_lods(model);
+
+  model->lods = sw_calloc((usize)num_levels, sizeof(model_lod_t), SW_MEMORY_GEOMETRY);
+  if (!model->lods) return -1;
+
+  simplifier_t s = {0};
+  bool ok = build_simplifier(&s, model);
+
+  int built = 0;
+  while (ok && built < num_levels) {
+    int previous = s.alive_tris;
+    int target = (int)((f32)previous * reduction);
+
+    while (s.alive_tris > target && s.heap_count > 0) {
+      collapse_t c = heap_pop(&s);
+      const lod_vertex_t *keep = &s.verts[c.keep], *remove = &s.verts[c.remove];
+
+      // Stale entries: an end moved or merged since this was queued
+      if (keep->removed || remove->removed || keep->stamp != c.keep_stamp || remove->stamp != c.remove_stamp) continue;
+      uv_remap_t remaps[MAX_UV_REMAPS];
+      int num_remaps = find_uv_remaps(&s, &c, remaps);
+      if (!can_collapse(&s, &c, remaps, num_remaps)) continue;
+
+      if (!apply_collapse(&s, &c, remaps, num_remaps)) { ok = false; break; }
+    }
+
+    if (!ok || s.alive_tris >= previous) break; // out of memory, or nothing left that can collapse
+    if (!emit_level(&s, &model->lods[built])) { ok = false; break; }
+    model->num_lods = (usize)++built;
+  }
+
+  free_simplifier(&s);
+
+  if (!ok) {
+    free_model_lods(model);
+    return -1;
+  }
+
+  return built;
+}
+
+void free_model_lods(model_t *model) {
+  if (!model) return;
+
+  // LODs borrowed from a shared mesh are only dropped
+  if (model->shared_mesh) {
+    model->lods = NULL;
+    model->num_lods = 0;
+    return;
+  }
+
+  for (usize i = 0; i < model->num_lods; ++i) {
+    sw_free(model->lods[i].vertex_data);
+    sw_free(model->lods[i].face_normals);
+  }
+
+  sw_free(model->lods);
+  model->lods = NULL;
+  model->num_lods = 0;
+}
+
+void select_model_lod(const model_t *model, f32 screen_radius, model_t *out) {
+  assert(model != NULL && out != NULL);
+
+  *out = *model;
+  if (model->num_lods == 0) return;
+
+  f32 budget = PI * screen_radius * screen_radius / LOD_PIXELS_PER_TRIANGLE;
+  if ((f32)(model->num_vertices / 3) <= budget) return;
+
+  // Finest level within the budget, the coarsest one when none is
+  for (usize i = 0; i < model->num_lods; ++i) {
+    const model_lod_t *lod = &model->lods[i];
+    if ((f32)lod->num_faces > budget && i + 1 < model->num_lods) continue;
+
+    out->vertex_data = lod->vertex_data;
+    out->face_normals = lod->face_normals;
+    out->num_vertices = lod->num_vertices;
+    out->num_faces = lod->num_faces;
+    return;
+  }
+}
@@ -0,0 +1,257 @@
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline usize align_size(usize size) {
+  return (size + SW_MEMORY_ALIGNMENT - 1) & ~(usize)(SW_MEMORY_ALIGNMENT - 1);
+}
+
+// First aligned address at or after ptr
+static inline u8 *align_pointer(void *ptr) {
+  return (u8 *)(((uintptr_t)ptr + SW_MEMORY_ALIGNMENT - 1) & ~(uintptr_t)(SW_MEMORY_ALIGNMENT - 1));
+}
+
+// Counters are bumped from worker threads when threads are enabled
+#ifdef SHADER_WORKS_USE_PTHREADS
+#define COUNTER_ADD(counter, value) __sync_fetch_and_add(&(counter), (value))
+#define COUNTER_SUB(counter, value) __sync_fetch_and_sub(&(counter), (value))
+#else
+#define COUNTER_ADD(counter, value) ((counter) += (value))
+#define COUNTER_SUB(counter, value) ((counter) -= (value))
+#endif
+
+// Sits in front of every sw_alloc block so frees know what to take off the counters
+typedef struct {
+  usize size;
+  u32 category;
+} alloc_header_t;
+
+#define HEADER_SIZE ((sizeof(alloc_header_t) + SW_MEMORY_ALIGNMENT - 1) & ~(usize)(SW_MEMORY_ALIGNMENT - 1))
+
+static void *heap_alloc(usize size, void *user) { (void)user; return malloc(size); }
+static void *heap_realloc(void *ptr, usize size, void *user) { (void)user; return realloc(ptr, size); }
+static void heap_free(void *ptr, void *user) { (void)user; free(ptr); }
+
+static sw_allocator_t allocator = { heap_alloc, heap_realloc, heap_free, NULL };
+static sw_memory_stats_t stats;
+
+void sw_set_allocator(const sw_allocator_t *new_allocator) {
+  if (new_allocator) {
+    assert(new_allocator->alloc && new_allocator->realloc && new_allocator->free);
+    allocator = *new_allocator;
+  } else {
+    allocator = (sw_allocator_t){ heap_alloc, heap_realloc, heap_free, NULL };
+  }
+}
+
+void *sw_alloc(usize size, sw_memory_category_t category) {
+  assert(category < SW_MEMORY_CATEGORY_COUNT);
+
+  u8 *block = allocator.alloc(HEADER_SIZE + size, allocator.user);
+  if (!block) return NULL;
+
+  *(alloc_header_t *)block = (alloc_header_t){ .size = size, .category = (u32)category };
+  COUNTER_ADD(stats.live_bytes[category], size);
+  COUNTER_ADD(stats.live_allocations[category], 1);
+  COUNTER_ADD(stats.total_allocations, 1);
+
+  return block + HEADER_SIZE;
+}
+
+void *sw_calloc(usize count, usize size, sw_memory_category_t category) {
+  if (size && count > (usize)-1 / size) return NULL;
+
+  void *ptr = sw_alloc(count * size, category);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void *sw_realloc(void *ptr, usize size, sw_memory_category_t category) {
+  if (!ptr) return sw_alloc(size, category);
+
+  u8 *block = (u8 *)ptr - HEADER_SIZE;
+  alloc_header_t header = *(alloc_header_t *)block;
+
+  block = allocator.realloc(block, HEADER_SIZE + size, allocator.user);
+  if (!block) return NULL;
+
+  ((alloc_header_t *)block)->size = size;
+  COUNTER_SUB(stats.live_bytes[header.category], header.size);
+  COUNTER_ADD(stats.live_bytes[header.category], size);
+  COUNTER_ADD(stats.total_allocations, 1);
+
+  return block + HEADER_SIZE;
+}
+
+void sw_free(void *ptr) {
+  if (!ptr) return;
+
+  u8 *block = (u8 *)ptr - HEADER_SIZE;
+  const alloc_header_t *header = (const alloc_header_t *)block;
+
+  COUNTER_SUB(stats.live_bytes[header->category], header->size);
+  COUNTER_SUB(stats.live_allocations[header->category], 1);
+
+  allocator.free(block, allocator.user);
+}
+
+void sw_get_memory_stats(sw_memory_stats_t *out) {
+  assert(out != NULL);
+  *out = stats;
+}
+
+usize sw_memory_in_use(sw_memory_category_t category) {
+  assert(category < SW_MEMORY_CATEGORY_COUNT);
+  return stats.live_bytes[category];
+}
+
+const char *sw_memory_category_name(sw_memory_category_t category) {
+  switch (category) {
+    case SW_MEMORY_GEOMETRY: return "geometry";
+    case SW_MEMORY_TEXTURES: return "textures";
+    case SW_MEMORY_SCRATCH:  return "scratch";
+    case SW_MEMORY_OTHER:    return "other";
+    default:                 return "unknown";
+  }
+}
+
+int init_arena(arena_t *arena, usize capacity) {
+  assert(arena != NULL);
+
+  // The heap only promises alignment for the largest standard type, leave room to align by hand
+  *arena = (arena_t){0};
+  void *allocation = sw_alloc(capacity + SW_MEMORY_ALIGNMENT - 1, SW_MEMORY_SCRATCH);
+  if (!allocation) return -1;
+
+  init_arena_from(arena, allocation, capacity + SW_MEMORY_ALIGNMENT - 1);
+  arena->allocation = allocation;
+  return 0;
+}
+
+void init_arena_from(arena_t *arena, void *memory, usize capacity) {
+  assert(arena != NULL);
+  assert(memory != NULL || capacity == 0);
+
+  // Skip to the first aligned byte, the caller's block may not be
+  u8 *start = align_pointer(memory);
+  usize skipped = (usize)(start - (u8 *)memory);
+
+  arena->base = start;
+  arena->capacity = capacity > skipped ? capacity - skipped : 0;
+  arena->used = 0;
+  arena->allocation = NULL;
+}
+
+void free_arena(arena_t *arena) {
+  if (!arena) return;
+
+  sw_free(arena->allocation);
+  *arena = (arena_t){0};
+}
+
+void *arena_alloc(arena_t *arena, usize size) {
+  if (!arena || !arena->base) return NULL;
+
+  usize aligned = align_size(size);
+  if (aligned > arena->capacity - arena->used) return NULL;
+
+  void *ptr = arena->base + arena->used;
+  arena->used += aligned;
+  return ptr;
+}
+
+usize arena_mark(const arena_t *arena) {
+  return arena ? arena->used : 0;
+}
+
+void arena_release(arena_t *arena, usize mark) {
+  if (!arena) return;
+
+  assert(mark <= arena->used);
+  arena->used = mark;
+}
+
+void arena_reset(arena_t *arena) {
+  if (arena) arena->used = 0;
+}
+
+bool arena_contains(const arena_t *arena, const void *ptr) {
+  if (!arena || !arena->base || !ptr) return false;
+
+  const u8 *p = (const u8 *)ptr;
+  return p >= arena->base && p < arena->base + arena->capacity;
+}
+
+int init_pool(pool_t *pool, usize block_size, usize blocks_per_slab) {
+  assert(pool != NULL);
+  assert(block_size >= sizeof(void *));
+  assert(blocks_per_slab > 0);
+
+  *pool = (pool_t){ .block_size = align_size(block_size), .blocks_per_slab = blocks_per_slab, .slab_capacity = 8 };
+  pool->slabs = sw_alloc(pool->slab_capacity * sizeof(void *), SW_MEMORY_SCRATCH);
+  if (!pool->slabs) {
+    pool->slab_capacity = 0;
+    return -1;
+  }
+
+  return 0;
+}
+
+void free_pool(pool_t *pool) {
+  if (!pool) return;
+
+  for (usize i = 0; i < pool->num_slabs; ++i) sw_free(pool->slabs[i]);
+  sw_free(pool->slabs);
+  *pool = (pool_t){0};
+}
+
+// Allocates a slab and threads its blocks onto the free list
+static bool grow_pool(pool_t *pool) {
+  if (pool->num_slabs == pool->slab_capacity) {
+    usize capacity = pool->slab_capacity ? pool->slab_capacity * 2 : 8;
+    void **slabs = sw_realloc(pool->slabs, capacity * sizeof(void *), SW_MEMORY_SCRATCH);
+    if (!slabs) return false;
+
+    pool->slabs = slabs;
+    pool->slab_capacity = capacity;
+  }
+
+  void *allocation = sw_alloc(pool->block_size * pool->blocks_per_slab + SW_MEMORY_ALIGNMENT - 1, SW_MEMORY_SCRATCH);
+  if (!allocation) return false;
+
+  pool->slabs[pool->num_slabs++] = allocation;
+  u8 *slab = align_pointer(allocation);
+
+  // Last block first so blocks come out in address order
+  for (usize i = pool->blocks_per_slab; i-- > 0;) {
+    void *block = slab + i * pool->block_size;
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+  }
+
+  return true;
+}
+
+void *pool_alloc(pool_t *pool) {
+  assert(pool != NULL);
+
+  if (!pool->free_list && !grow_pool(pool)) return NULL;
+
+  void *block = pool->free_list;
+  pool->free_list = *(void **)block;
+  ++pool->live_blocks;
+  return block;
+}
+
+void pool_free(pool_t *pool, void *block) {
+  assert(pool != NULL);
+  if (!block) return;
+
+  assert(pool->live_blocks > 0);
+  *(void **)block = pool->free_list;
+  pool->free_list = block;
+  --pool->live_blocks;
+}
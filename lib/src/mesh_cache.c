@@ -0,0 +1,147 @@
+#include <shader-works/mesh_cache.h>
+#include <shader-works/memory.h>
+
+#include "file_map.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+struct mesh_cache_t {
+  file_map_t file;
+};
+
+static inline u64 align_offset(u64 offset) {
+  return (offset + SW_MEMORY_ALIGNMENT - 1) & ~(u64)(SW_MEMORY_ALIGNMENT - 1);
+}
+
+// Zero fill from *position up to offset
+static bool write_padding(FILE *file, u64 *position, u64 offset) {
+  static const u8 zeros[SW_MEMORY_ALIGNMENT] = {0};
+
+  usize padding = (usize)(offset - *position);
+  if (padding && fwrite(zeros, 1, padding, file) != padding) return false;
+
+  *position = offset;
+  return true;
+}
+
+int write_mesh_cache(const char *path, const model_t *model, u64 source_stamp) {
+  assert(path != NULL && model != NULL);
+  if ((model->num_vertices && !model->vertex_data) || (model->num_faces && !model->face_normals)) return -1;
+
+  mesh_cache_header_t header = {
+    .magic = MESH_CACHE_MAGIC,
+    .version = MESH_CACHE_VERSION,
+    .vertex_size = sizeof(vertex_data_t),
+    .flags = model->use_textures ? MESH_CACHE_USE_TEXTURES : 0,
+    .source_stamp = source_stamp,
+    .num_vertices = model->num_vertices,
+    .num_faces = model->num_faces,
+    .bounds_min = model->bounds_min,
+    .bounds_max = model->bounds_max,
+    .bounds_center = model->bounds_center,
+    .bounds_radius = model->bounds_radius
+  };
+  header.vertex_offset = align_offset(sizeof(header));
+  header.face_normal_offset = align_offset(header.vertex_offset + header.num_vertices * sizeof(vertex_data_t));
+
+  // Written beside path and renamed over it, so a reader never maps half a file
+  usize path_length = strlen(path);
+  char *temp_path = sw_alloc(path_length + sizeof(".tmp"), SW_MEMORY_SCRATCH);
+  if (!temp_path) return -1;
+  memcpy(temp_path, path, path_length);
+  memcpy(temp_path + path_length, ".tmp", sizeof(".tmp"));
+
+  FILE *file = fopen(temp_path, "wb");
+  if (!file) {
+    sw_free(temp_path);
+    return -1;
+  }
+
+  u64 position = sizeof(header);
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 write_padding(file, &position, header.vertex_offset) &&
+                 fwrite(model->vertex_data, sizeof(vertex_data_t), model->num_vertices, file) == model->num_vertices;
+
+  position = header.vertex_offset + header.num_vertices * sizeof(vertex_data_t);
+  written = written &&
+            write_padding(file, &position, header.face_normal_offset) &&
+            fwrite(model->face_normals, sizeof(float3), model->num_faces, file) == model->num_faces;
+  written = fclose(file) == 0 && written;
+
+  // rename won't replace an existing file everywhere
+  if (written && rename(temp_path, path) != 0) {
+    remove(path);
+    written = rename(temp_path, path) == 0;
+  }
+
+  if (!written) remove(temp_path);
+  sw_free(temp_path);
+  return written ? 0 : -1;
+}
+
+// Whether count elements of stride bytes at offset lie inside the file, aligned for direct use
+static bool valid_stream(const file_map_t *file, u64 offset, u64 count, u64 stride) {
+  return offset % SW_MEMORY_ALIGNMENT == 0 && offset <= file->size && count <= (file->size - offset) / stride;
+}
+
+static bool valid_cache(const file_map_t *file, u64 source_stamp) {
+  if (file->size < sizeof(mesh_cache_header_t)) return false;
+
+  const mesh_cache_header_t *header = (const mesh_cache_header_t *)file->data;
+  if (header->magic != MESH_CACHE_MAGIC || header->version != MESH_CACHE_VERSION) return false;
+  if (header->vertex_size != sizeof(vertex_data_t)) return false;
+  if (source_stamp && header->source_stamp != source_stamp) return false;
+
+  if (!valid_stream(file, header->vertex_offset, header->num_vertices, sizeof(vertex_data_t)) ||
+      !valid_stream(file, header->face_normal_offset, header->num_faces, sizeof(float3))) return false;
+
+  // The renderer reads three vertices and one face normal per face, both counts are bounded by the file size here
+  if (header->num_vertices != header->num_faces * 3) return false;
+
+  // Streams must sit where write_mesh_cache puts them, so they can't overlap the header or each other and a
+  // truncated or padded file is caught
+  u64 vertex_end = header->vertex_offset + header->num_vertices * sizeof(vertex_data_t);
+  return header->vertex_offset == align_offset(sizeof(mesh_cache_header_t)) &&
+         header->face_normal_offset == align_offset(vertex_end) &&
+         header->face_normal_offset + header->num_faces * sizeof(float3) == file->size;
+}
+
+int load_mesh_cache(model_t *model, const char *path, u64 source_stamp) {
+  assert(model != NULL && path != NULL);
+
+  struct mesh_cache_t *cache = sw_alloc(sizeof(*cache), SW_MEMORY_OTHER);
+  if (!cache) return -1;
+
+  if (map_file(&cache->file, path) != 0) {
+    sw_free(cache);
+    return -1;
+  }
+
+  if (!valid_cache(&cache->file, source_stamp)) {
+    close_mesh_cache(cache);
+    return -1;
+  }
+
+  const mesh_cache_header_t *header = (const mesh_cache_header_t *)cache->file.data;
+  model->vertex_data = (vertex_data_t *)(cache->file.data + header->vertex_offset);
+  model->face_normals = (float3 *)(cache->file.data + header->face_normal_offset);
+  model->num_vertices = (usize)header->num_vertices;
+  model->num_faces = (usize)header->num_faces;
+  model->bounds_min = header->bounds_min;
+  model->bounds_max = header->bounds_max;
+  model->bounds_center = header->bounds_center;
+  model->bounds_radius = header->bounds_radius;
+  model->use_textures = (header->flags & MESH_CACHE_USE_TEXTURES) != 0;
+  model->mesh_cache = cache;
+
+  return 0;
+}
+
+void close_mesh_cache(struct mesh_cache_t *cache) {
+  if (!cache) return;
+
+  unmap_file(&cache->file);
+  sw_free(cache);
+}
@@ -0,0 +1,563 @@
+#include <shader-works/obj.h>
+#include <shader-works/memory.h>
+
+#include "file_map.h"
+#include "parallel.h"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Bytes of file each parse job covers, files below this are parsed on the calling thread
+#define OBJ_RANGE_SIZE (4u << 20)
+#define OBJ_INITIAL_CAPACITY 1024
+
+// Index a corner leaves out, or gives as 0
+#define OBJ_NO_INDEX INT32_MIN
+
+// Bits of obj_corner_t.relative, set for indices counted back from the end of their range's lines
+#define OBJ_RELATIVE_V  1u
+#define OBJ_RELATIVE_VT 2u
+#define OBJ_RELATIVE_VN 4u
+
+// One face corner as parsed: 0 based indices, relative ones still local to the range
+typedef struct {
+  i32 v, vt, vn;
+  u32 relative;
+} obj_corner_t;
+
+// Parse state and output of the lines starting in [begin, end)
+typedef struct {
+  const char *begin, *end, *file_end;
+
+  float3 *positions;
+  float2 *texcoords;
+  float3 *normals;
+  usize num_positions, num_texcoords, num_normals;
+  usize position_capacity, texcoord_capacity, normal_capacity;
+
+  obj_corner_t *corners;    // 3 per triangle
+  usize num_corners, corner_capacity;
+
+  obj_corner_t *polygon;    // corners of the face being parsed
+  usize polygon_capacity;
+
+  usize position_base, texcoord_base, normal_base; // elements in earlier ranges
+  bool flip_winding;
+  bool failed;
+} obj_range_t;
+
+// buffer with room for needed elements, NULL on allocation failure with buffer left as it was
+static void *reserve(void *buffer, usize *capacity, usize needed, usize stride) {
+  if (needed <= *capacity) return buffer;
+
+  usize grown_capacity = *capacity ? *capacity * 2 : OBJ_INITIAL_CAPACITY;
+  while (grown_capacity < needed) grown_capacity *= 2;
+
+  void *grown = sw_realloc(buffer, grown_capacity * stride, SW_MEMORY_SCRATCH);
+  if (grown) *capacity = grown_capacity;
+  return grown;
+}
+
+static void free_range(obj_range_t *range) {
+  sw_free(range->positions);
+  sw_free(range->texcoords);
+  sw_free(range->normals);
+  sw_free(range->corners);
+  sw_free(range->polygon);
+}
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+static inline bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+static inline const char *skip_blanks(const char *p, const char *end) {
+  while (p < end && is_blank(*p)) ++p;
+  return p;
+}
+
+// Powers of ten a double holds exactly, scaling by them rounds once
+static const f64 exact_powers_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Decimal float with optional sign, fraction and exponent
+// Returns the character after it, or NULL when p doesn't start a number
+static const char *parse_float(const char *p, const char *end, f32 *out) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+
+  // The first 19 significant digits fit a u64, later ones only move the decimal point
+  u64 mantissa = 0;
+  int digits = 0, exponent = 0;
+  bool any_digits = false;
+
+  for (; p < end && is_digit(*p); ++p, any_digits = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (u64)(*p - '0');
+      if (mantissa) ++digits;
+    } else {
+      ++exponent;
+    }
+  }
+
+  if (p < end && *p == '.') {
+    for (++p; p < end && is_digit(*p); ++p, any_digits = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (u64)(*p - '0');
+        if (mantissa) ++digits;
+        --exponent;
+      }
+    }
+  }
+
+  if (!any_digits) return NULL;
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool negative_exponent = false;
+    if (q < end && (*q == '-' || *q == '+')) negative_exponent = *q++ == '-';
+
+    // A bare 'e' isn't part of the number
+    if (q < end && is_digit(*q)) {
+      int value = 0;
+      for (; q < end && is_digit(*q); ++q) {
+        if (value < 100000) value = value * 10 + (*q - '0');
+      }
+      exponent += negative_exponent ? -value : value;
+      p = q;
+    }
+  }
+
+  f64 value = (f64)mantissa;
+  if (mantissa != 0 && exponent != 0) {
+    if (exponent > 0 && exponent <= 22) value *= exact_powers_of_ten[exponent];
+    else if (exponent < 0 && exponent >= -22) value /= exact_powers_of_ten[-exponent];
+    else value *= pow(10.0, exponent);
+  }
+
+  *out = (f32)(negative ? -value : value);
+  return p;
+}
+
+// Decimal integer with optional sign, saturating well inside i32
+// Returns the character after it, or NULL when p doesn't start a number
+static const char *parse_int(const char *p, const char *end, i32 *out) {
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+  if (p >= end || !is_digit(*p)) return NULL;
+
+  i32 value = 0;
+  for (; p < end && is_digit(*p); ++p) {
+    if (value < 100000000) value = value * 10 + (*p - '0');
+  }
+
+  *out = negative ? -value : value;
+  return p;
+}
+
+// Up to max floats separated by blanks, returns how many were read
+static int parse_floats(const char *p, const char *end, f32 *values, int max) {
+  int count = 0;
+  while (count < max) {
+    p = parse_float(skip_blanks(p, end), end, &values[count]);
+    if (!p) break;
+    ++count;
+  }
+  return count;
+}
+
+// ============================================================================
+// Line parsing
+// ============================================================================
+
+// Turns an OBJ index into a 0 based one: positive counts from 1, negative back from the elements read so far
+static inline i32 corner_index(i32 index, usize local_count, u32 relative_bit, u32 *relative) {
+  if (index > 0) return index - 1;
+  if (index == 0) return OBJ_NO_INDEX;
+
+  // Earlier ranges' elements aren't counted yet, resolve_range adds them
+  *relative |= relative_bit;
+  return (i32)local_count + index;
+}
+
+// One v, v/vt, v//vn or v/vt/vn corner, returns the character after it or NULL if malformed
+static const char *parse_corner(const obj_range_t *range, const char *p, const char *end, obj_corner_t *corner) {
+  i32 v, vt = 0, vn = 0;
+  p = parse_int(p, end, &v);
+  if (!p) return NULL;
+
+  if (p < end && *p == '/') {
+    ++p;
+    if (p < end && *p != '/') {
+      const char *next = parse_int(p, end, &vt);
+      if (next) p = next;
+    }
+
+    if (p < end && *p == '/') {
+      const char *next = parse_int(p + 1, end, &vn);
+      p = next ? next : p + 1;
+    }
+  }
+
+  corner->relative = 0;
+  corner->v = corner_index(v, range->num_positions, OBJ_RELATIVE_V, &corner->relative);
+  corner->vt = corner_index(vt, range->num_texcoords, OBJ_RELATIVE_VT, &corner->relative);
+  corner->vn = corner_index(vn, range->num_normals, OBJ_RELATIVE_VN, &corner->relative);
+  return p;
+}
+
+// Reads a face's corners and appends its fan triangles
+static void parse_face(obj_range_t *range, const char *p, const char *end) {
+  usize count = 0;
+
+  for (;;) {
+    p = skip_blanks(p, end);
+    if (p >= end || *p == '#' || *p == '\r') break;
+
+    obj_corner_t corner;
+    const char *next = parse_corner(range, p, end, &corner);
+    if (!next) {
+      // Skip a token that isn't a corner
+      while (p < end && !is_blank(*p)) ++p;
+      continue;
+    }
+    p = next;
+
+    obj_corner_t *polygon = reserve(range->polygon, &range->polygon_capacity, count + 1, sizeof(obj_corner_t));
+    if (!polygon) {
+      range->failed = true;
+      return;
+    }
+    range->polygon = polygon;
+    range->polygon[count++] = corner;
+  }
+
+  if (count < 3) return;
+
+  usize needed = range->num_corners + (count - 2) * 3;
+  obj_corner_t *corners = reserve(range->corners, &range->corner_capacity, needed, sizeof(obj_corner_t));
+  if (!corners) {
+    range->failed = true;
+    return;
+  }
+  range->corners = corners;
+
+  for (usize tri = 1; tri < count - 1; ++tri) {
+    usize second = range->flip_winding ? tri + 1 : tri;
+    usize third = range->flip_winding ? tri : tri + 1;
+    corners[range->num_corners++] = range->polygon[0];
+    corners[range->num_corners++] = range->polygon[second];
+    corners[range->num_corners++] = range->polygon[third];
+  }
+}
+
+static void parse_line(obj_range_t *range, const char *p, const char *end) {
+  p = skip_blanks(p, end);
+  if (end - p < 2) return;
+
+  f32 values[3];
+
+  if (p[0] == 'v' && is_blank(p[1])) {
+    if (parse_floats(p + 2, end, values, 3) < 3) return;
+
+    float3 *positions = reserve(range->positions, &range->position_capacity, range->num_positions + 1, sizeof(float3));
+    if (!positions) {
+      range->failed = true;
+      return;
+    }
+
+    // Flip Z to convert from OBJ (+Z forward) to render system (-Z forward)
+    range->positions = positions;
+    range->positions[range->num_positions++] = (float3){values[0], values[1], -values[2]};
+  } else if (p[0] == 'v' && p[1] == 't' && end - p > 2 && is_blank(p[2])) {
+    int count = parse_floats(p + 3, end, values, 2);
+    if (count < 1) return;
+
+    float2 *texcoords = reserve(range->texcoords, &range->texcoord_capacity, range->num_texcoords + 1, sizeof(float2));
+    if (!texcoords) {
+      range->failed = true;
+      return;
+    }
+
+    range->texcoords = texcoords;
+    range->texcoords[range->num_texcoords++] = (float2){values[0], count == 2 ? values[1] : 0.0f};
+  } else if (p[0] == 'v' && p[1] == 'n' && end - p > 2 && is_blank(p[2])) {
+    if (parse_floats(p + 3, end, values, 3) < 3) return;
+
+    float3 *normals = reserve(range->normals, &range->normal_capacity, range->num_normals + 1, sizeof(float3));
+    if (!normals) {
+      range->failed = true;
+      return;
+    }
+
+    // Flip all normal components for correct lighting with -Z forward camera
+    range->normals = normals;
+    range->normals[range->num_normals++] = (float3){-values[0], -values[1], -values[2]};
+  } else if (p[0] == 'f' && is_blank(p[1])) {
+    parse_face(range, p + 2, end);
+  }
+}
+
+static usize parse_ranges(void *ctx, int begin, int end) {
+  obj_range_t *ranges = ctx;
+
+  for (int i = begin; i < end; ++i) {
+    obj_range_t *range = &ranges[i];
+    const char *p = range->begin;
+
+    // A range owns every line starting inside it, the last may run past its end
+    while (p < range->end && !range->failed) {
+      const char *line_end = memchr(p, '\n', (usize)(range->file_end - p));
+      if (!line_end) line_end = range->file_end;
+
+      parse_line(range, p, line_end);
+      p = line_end + 1;
+    }
+  }
+
+  return 0;
+}
+
+// ============================================================================
+// Index resolution and vertex dedup
+// ============================================================================
+
+// 0 based index into count elements, or -1 when missing or out of range
+static inline i32 resolve_index(i32 index, bool relative, usize base, usize count) {
+  if (index == OBJ_NO_INDEX) return -1;
+
+  i64 resolved = relative ? (i64)base + index : index;
+  return resolved >= 0 && resolved < (i64)count ? (i32)resolved : -1;
+}
+
+typedef struct {
+  obj_range_t *ranges;
+  usize num_positions, num_texcoords, num_normals;
+} obj_resolve_t;
+
+// Rewrites a range's corners as absolute indices, a corner without a valid position fails the range
+static usize resolve_ranges(void *ctx, int begin, int end) {
+  obj_resolve_t *resolve = ctx;
+
+  for (int i = begin; i < end; ++i) {
+    obj_range_t *range = &resolve->ranges[i];
+
+    for (usize c = 0; c < range->num_corners; ++c) {
+      obj_corner_t *corner = &range->corners[c];
+      corner->v = resolve_index(corner->v, corner->relative & OBJ_RELATIVE_V, range->position_base, resolve->num_positions);
+      corner->vt = resolve_index(corner->vt, corner->relative & OBJ_RELATIVE_VT, range->texcoord_base, resolve->num_texcoords);
+      corner->vn = resolve_index(corner->vn, corner->relative & OBJ_RELATIVE_VN, range->normal_base, resolve->num_normals);
+      corner->relative = 0;
+
+      if (corner->v < 0) range->failed = true;
+    }
+  }
+
+  return 0;
+}
+
+static inline u32 hash_corner(const obj_corner_t *corner) {
+  u32 hash = (u32)corner->v * 0x9E3779B1u;
+  hash ^= (u32)corner->vt * 0x85EBCA77u;
+  hash ^= (u32)corner->vn * 0xC2B2AE3Du;
+  hash ^= hash >> 15;
+  hash *= 0x2C1B3C6Du;
+  return hash ^ (hash >> 12);
+}
+
+// Builds mesh's indexed vertices from the resolved corners of every range
+static int build_indexed_mesh(obj_mesh_t *mesh, obj_range_t *ranges, int num_ranges, const float3 *positions,
+                              const float2 *texcoords, const float3 *normals, float3 center) {
+  usize num_corners = 0;
+  for (int i = 0; i < num_ranges; ++i) num_corners += ranges[i].num_corners;
+
+  mesh->num_triangles = num_corners / 3;
+  mesh->indices = sw_alloc(num_corners * sizeof(u32), SW_MEMORY_GEOMETRY);
+
+  // Open addressing table at most half full, slots hold a vertex index plus one
+  usize table_size = 16;
+  while (table_size < num_corners * 2) table_size *= 2;
+
+  u32 *table = sw_calloc(table_size, sizeof(u32), SW_MEMORY_SCRATCH);
+  obj_corner_t *keys = sw_alloc((num_corners ? num_corners : 1) * sizeof(obj_corner_t), SW_MEMORY_SCRATCH);
+
+  if (!mesh->indices || !table || !keys) {
+    sw_free(table);
+    sw_free(keys);
+    return -1;
+  }
+
+  usize num_vertices = 0, next_index = 0;
+  for (int i = 0; i < num_ranges; ++i) {
+    for (usize c = 0; c < ranges[i].num_corners; ++c) {
+      const obj_corner_t *corner = &ranges[i].corners[c];
+      usize slot = hash_corner(corner) & (table_size - 1);
+
+      while (table[slot]) {
+        const obj_corner_t *key = &keys[table[slot] - 1];
+        if (key->v == corner->v && key->vt == corner->vt && key->vn == corner->vn) break;
+        slot = (slot + 1) & (table_size - 1);
+      }
+
+      if (!table[slot]) {
+        keys[num_vertices++] = *corner;
+        table[slot] = (u32)num_vertices;
+      }
+
+      mesh->indices[next_index++] = table[slot] - 1;
+    }
+  }
+
+  sw_free(table);
+
+  mesh->num_vertices = num_vertices;
+  mesh->positions = sw_alloc((num_vertices ? num_vertices : 1) * sizeof(float3), SW_MEMORY_GEOMETRY);
+  mesh->uvs = sw_alloc((num_vertices ? num_vertices : 1) * sizeof(float2), SW_MEMORY_GEOMETRY);
+  mesh->normals = sw_alloc((num_vertices ? num_vertices : 1) * sizeof(float3), SW_MEMORY_GEOMETRY);
+
+  if (!mesh->positions || !mesh->uvs || !mesh->normals) {
+    sw_free(keys);
+    return -1;
+  }
+
+  for (usize i = 0; i < num_vertices; ++i) {
+    const obj_corner_t *key = &keys[i];
+    mesh->positions[i] = float3_sub(positions[key->v], center);
+    mesh->uvs[i] = key->vt >= 0 ? texcoords[key->vt] : (float2){0.0f, 0.0f};
+    mesh->normals[i] = key->vn >= 0 ? normals[key->vn] : (float3){0.0f, 1.0f, 0.0f};
+  }
+
+  sw_free(keys);
+  return 0;
+}
+
+// Concatenates every range's elements into arrays indexed like the whole file
+// Returns false on allocation failure, with whatever was allocated left for the caller to free
+static bool gather_elements(const obj_range_t *ranges, int num_ranges, const obj_resolve_t *totals,
+                            float3 **positions, float2 **texcoords, float3 **normals) {
+  *positions = sw_alloc((totals->num_positions ? totals->num_positions : 1) * sizeof(float3), SW_MEMORY_SCRATCH);
+  *texcoords = sw_alloc((totals->num_texcoords ? totals->num_texcoords : 1) * sizeof(float2), SW_MEMORY_SCRATCH);
+  *normals = sw_alloc((totals->num_normals ? totals->num_normals : 1) * sizeof(float3), SW_MEMORY_SCRATCH);
+  if (!*positions || !*texcoords || !*normals) return false;
+
+  for (int i = 0; i < num_ranges; ++i) {
+    const obj_range_t *range = &ranges[i];
+    if (range->num_positions) memcpy(*positions + range->position_base, range->positions, range->num_positions * sizeof(float3));
+    if (range->num_texcoords) memcpy(*texcoords + range->texcoord_base, range->texcoords, range->num_texcoords * sizeof(float2));
+    if (range->num_normals) memcpy(*normals + range->normal_base, range->normals, range->num_normals * sizeof(float3));
+  }
+
+  return true;
+}
+
+int load_obj_mesh(obj_mesh_t *mesh, const char *filename, bool flip_winding) {
+  assert(mesh != NULL);
+  *mesh = (obj_mesh_t){0};
+  if (!filename) return -1;
+
+  file_map_t file;
+  if (map_file(&file, filename) != 0) return -1;
+
+  const char *data = (const char *)file.data;
+  const char *file_end = data + file.size;
+
+  int num_ranges = (int)((file.size + OBJ_RANGE_SIZE - 1) / OBJ_RANGE_SIZE);
+  if (num_ranges < 1) num_ranges = 1;
+
+  obj_range_t *ranges = sw_calloc((usize)num_ranges, sizeof(obj_range_t), SW_MEMORY_SCRATCH);
+  if (!ranges) {
+    unmap_file(&file);
+    return -1;
+  }
+
+  // Split on line starts, each range begins after the first newline at or past its share of the file
+  for (int i = 0; i < num_ranges; ++i) {
+    const char *begin = data + (usize)i * OBJ_RANGE_SIZE;
+    if (i > 0 && begin[-1] != '\n') {
+      const char *newline = memchr(begin, '\n', (usize)(file_end - begin));
+      begin = newline ? newline + 1 : file_end;
+    }
+
+    ranges[i].begin = begin;
+    ranges[i].file_end = file_end;
+    ranges[i].flip_winding = flip_winding;
+    if (i > 0) ranges[i - 1].end = begin;
+  }
+  ranges[num_ranges - 1].end = file_end;
+
+  parallel_for(num_ranges, 1, parse_ranges, ranges);
+
+  // Each range's indices are relative to the elements before it
+  obj_resolve_t resolve = { .ranges = ranges };
+  bool failed = false;
+  for (int i = 0; i < num_ranges; ++i) {
+    ranges[i].position_base = resolve.num_positions;
+    ranges[i].texcoord_base = resolve.num_texcoords;
+    ranges[i].normal_base = resolve.num_normals;
+    resolve.num_positions += ranges[i].num_positions;
+    resolve.num_texcoords += ranges[i].num_texcoords;
+    resolve.num_normals += ranges[i].num_normals;
+    failed |= ranges[i].failed;
+  }
+
+  if (!failed) {
+    parallel_for(num_ranges, 1, resolve_ranges, &resolve);
+    for (int i = 0; i < num_ranges; ++i) failed |= ranges[i].failed;
+  }
+
+  float3 *positions = NULL;
+  float2 *texcoords = NULL;
+  float3 *normals = NULL;
+
+  if (!failed) {
+    failed = !gather_elements(ranges, num_ranges, &resolve, &positions, &texcoords, &normals);
+  }
+
+  if (!failed) {
+    // Centre the model on the bounding box of every position in the file
+    float3 min_bound = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float3 max_bound = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (usize i = 0; i < resolve.num_positions; ++i) {
+      min_bound.x = fminf(min_bound.x, positions[i].x);
+      min_bound.y = fminf(min_bound.y, positions[i].y);
+      min_bound.z = fminf(min_bound.z, positions[i].z);
+      max_bound.x = fmaxf(max_bound.x, positions[i].x);
+      max_bound.y = fmaxf(max_bound.y, positions[i].y);
+      max_bound.z = fmaxf(max_bound.z, positions[i].z);
+    }
+
+    float3 center = resolve.num_positions ? float3_scale(float3_add(min_bound, max_bound), 0.5f) : (float3){0};
+    failed = build_indexed_mesh(mesh, ranges, num_ranges, positions, texcoords, normals, center) != 0;
+    mesh->has_texcoords = resolve.num_texcoords > 0;
+  }
+
+  sw_free(positions);
+  sw_free(texcoords);
+  sw_free(normals);
+  for (int i = 0; i < num_ranges; ++i) free_range(&ranges[i]);
+  sw_free(ranges);
+  unmap_file(&file);
+
+  if (failed) {
+    free_obj_mesh(mesh);
+    return -1;
+  }
+
+  return 0;
+}
+
+void free_obj_mesh(obj_mesh_t *mesh) {
+  if (!mesh) return;
+
+  sw_free(mesh->positions);
+  sw_free(mesh->uvs);
+  sw_free(mesh->normals);
+  sw_free(mesh->indices);
+  *mesh = (obj_mesh_t){0};
+}
@@ -0,0 +1,108 @@
+#include "parallel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+#include <pthread.h>
+#include <unistd.h> // For sysconf
+
+// Threads a single parallel_for spreads across, their bookkeeping lives on the caller's stack
+#define PARALLEL_MAX_THREADS 64
+
+typedef struct {
+  parallel_for_func func;
+  void *ctx;
+  int count, batch_size;
+  int *next_item;
+  usize result;
+} parallel_worker_t;
+
+static void *parallel_worker(void *arg) {
+  parallel_worker_t *worker = (parallel_worker_t *)arg;
+  int begin;
+
+  // Atomically grab batches until the range is exhausted
+  while ((begin = __sync_fetch_and_add(worker->next_item, worker->batch_size)) < worker->count) {
+    int end = begin + worker->batch_size;
+    if (end > worker->count) end = worker->count;
+    worker->result += worker->func(worker->ctx, begin, end);
+  }
+
+  return NULL;
+}
+#endif
+
+int get_worker_count(void) {
+#ifdef SHADER_WORKS_USE_PTHREADS
+  // Get number of CPU cores (cross-platform)
+  int num_threads = 4; // Default fallback
+
+#ifdef _WIN32
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  num_threads = (int)sysinfo.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+  // POSIX systems (Linux, macOS)
+  num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (num_threads <= 0) num_threads = 4; // Safety fallback
+  return num_threads;
+#else
+  return 1;
+#endif
+}
+
+usize parallel_for(int count, int batch_size, parallel_for_func func, void *ctx) {
+  assert(func != NULL);
+  assert(batch_size > 0);
+
+  if (count <= 0) return 0;
+
+#ifdef SHADER_WORKS_USE_PTHREADS
+  int num_batches = (count + batch_size - 1) / batch_size;
+  int num_threads = get_worker_count();
+  if (num_threads > num_batches) num_threads = num_batches;
+  if (num_threads > PARALLEL_MAX_THREADS) num_threads = PARALLEL_MAX_THREADS;
+
+  // Not worth waking threads for a single batch
+  if (num_threads <= 1) return func(ctx, 0, count);
+
+  pthread_t threads[PARALLEL_MAX_THREADS];
+  parallel_worker_t workers[PARALLEL_MAX_THREADS];
+
+  // Shared atomic counter for work distribution
+  int next_item = 0;
+  usize result = 0;
+
+  // Launch worker threads
+  for (int t = 0; t < num_threads; t++) {
+    workers[t] = (parallel_worker_t){
+      .func = func,
+      .ctx = ctx,
+      .count = count,
+      .batch_size = batch_size,
+      .next_item = &next_item,
+      .result = 0
+    };
+
+    pthread_create(&threads[t], NULL, parallel_worker, &workers[t]);
+  }
+
+  // Wait for all threads to complete
+  for (int t = 0; t < num_threads; t++) {
+    pthread_join(threads[t], NULL);
+    result += workers[t].result;
+  }
+
+  return result;
+#else
+  // Single-threaded fallback
+  return func(ctx, 0, count);
+#endif
+}
@@ -0,0 +1,19 @@
+#ifndef SHADER_WORKS_PARALLEL_H
+#define SHADER_WORKS_PARALLEL_H
+
+#include <shader-works/maths.h>
+
+// Internal work distribution shared by the renderer and screen passes
+
+// Processes items [begin, end) and returns a count to accumulate (e.g. triangles drawn)
+typedef usize (*parallel_for_func)(void *ctx, int begin, int end);
+
+// Number of worker threads parallel_for spreads work across (1 when threads are disabled)
+int get_worker_count(void);
+
+// Runs func over items [0, count) in batches of batch_size, spread across worker threads
+// Batches are claimed atomically so uneven work balances itself; small jobs run on the calling thread
+// Returns the sum of func's return values
+usize parallel_for(int count, int batch_size, parallel_for_func func, void *ctx);
+
+#endif // SHADER_WORKS_PARALLEL_H
@@ -0,0 +1,153 @@
+#include <shader-works/post_process.h>
+
+#include <assert.h>
+#include <float.h> // For FLT_MAX
+#include <math.h>
+
+#include "parallel.h"
+
+// Rows claimed by a worker at a time, keeps threads on separate cache lines of the framebuffer
+#define POST_PROCESS_ROWS_PER_BATCH 8
+
+typedef struct {
+  renderer_t *state;
+  post_process_chain_t *chain;
+} post_process_job_t;
+
+void init_post_process_chain(post_process_chain_t *chain) {
+  assert(chain != NULL);
+  chain->num_passes = 0;
+  chain->clear_depth = FLT_MAX;
+}
+
+int add_post_process_pass(post_process_chain_t *chain, post_process_func func, void *args) {
+  assert(chain != NULL);
+  assert(func != NULL);
+
+  if (chain->num_passes >= MAX_POST_PROCESS_PASSES) return -1;
+
+  chain->passes[chain->num_passes++] = (post_process_pass_t){ .func = func, .args = args };
+  return 0;
+}
+
+// parallel_for callback, runs the whole chain over rows [begin, end)
+static usize post_process_rows(void *arg, int begin, int end) {
+  post_process_job_t *job = (post_process_job_t *)arg;
+  renderer_t *state = job->state;
+  int width = (int)state->screen_dim.x;
+
+  u8 r[POST_PROCESS_SPAN_SIZE], g[POST_PROCESS_SPAN_SIZE], b[POST_PROCESS_SPAN_SIZE];
+
+  for (int y = begin; y < end; ++y) {
+    for (int x = 0; x < width; x += POST_PROCESS_SPAN_SIZE) {
+      int count = width - x < POST_PROCESS_SPAN_SIZE ? width - x : POST_PROCESS_SPAN_SIZE;
+      u32 *restrict pixels = state->framebuffer + y * width + x;
+
+      for (int i = 0; i < count; ++i) u32_to_rgb(pixels[i], &r[i], &g[i], &b[i]);
+
+      post_process_span_t span = {
+        .state = state,
+        .r = r, .g = g, .b = b,
+        .depth = state->depthbuffer + y * width + x,
+        .clear_depth = job->chain->clear_depth,
+        .x = x, .y = y,
+        .count = count
+      };
+
+      // Every pass runs while the span is still in cache
+      for (usize p = 0; p < job->chain->num_passes; ++p) {
+        job->chain->passes[p].func(&span, job->chain->passes[p].args);
+      }
+
+      for (int i = 0; i < count; ++i) pixels[i] = rgb_to_u32(r[i], g[i], b[i]);
+    }
+  }
+
+  return 0;
+}
+
+void apply_post_process_chain(renderer_t *state, post_process_chain_t *chain) {
+  assert(state != NULL);
+  assert(chain != NULL);
+
+  if (chain->num_passes == 0) return;
+
+  post_process_job_t job = { .state = state, .chain = chain };
+  parallel_for((int)state->screen_dim.y, POST_PROCESS_ROWS_PER_BATCH, post_process_rows, &job);
+}
+
+void fog_pass(post_process_span_t *span, void *args) {
+  const fog_lut_t *lut = args ? (const fog_lut_t *)args : &span->state->fog_lut;
+  u8 *restrict r = span->r, *restrict g = span->g, *restrict b = span->b;
+  const f32 *restrict depth = span->depth;
+  f32 max_step = FOG_LUT_SIZE - 1, clear_depth = span->clear_depth;
+  int fog_r = lut->r, fog_g = lut->g, fog_b = lut->b;
+
+  // Clamp in float so any depth indexes the table safely (the last step is full fog), then an integer blend per channel
+  for (int i = 0; i < span->count; ++i) {
+    f32 step = fminf(fmaxf((depth[i] - lut->start) * lut->scale, -1.0f), max_step);
+    int w = step < 0.0f || depth[i] >= clear_depth ? 0 : lut->weight[(int)step];
+
+    r[i] = (u8)((r[i] * (255 - w) + fog_r * w + 127) / 255);
+    g[i] = (u8)((g[i] * (255 - w) + fog_g * w + 127) / 255);
+    b[i] = (u8)((b[i] * (255 - w) + fog_b * w + 127) / 255);
+  }
+}
+
+void dither_pass(post_process_span_t *span, void *args) {
+  UNUSED(args);
+
+  const u8 *even = span->state->dither_lut.table[(span->x + span->y) & 1];
+  const u8 *odd = span->state->dither_lut.table[(span->x + span->y + 1) & 1];
+  u8 *restrict r = span->r, *restrict g = span->g, *restrict b = span->b;
+  const f32 *restrict depth = span->depth;
+  f32 clear_depth = span->clear_depth;
+
+  // Alternate tables along the row for the checkerboard, every channel is a single lookup
+  for (int i = 0; i < span->count; ++i) {
+    if (depth[i] >= clear_depth) continue;
+
+    const u8 *restrict table = (i & 1) ? odd : even;
+    r[i] = table[r[i]];
+    g[i] = table[g[i]];
+    b[i] = table[b[i]];
+  }
+}
+
+void tone_curve_pass(post_process_span_t *span, void *args) {
+  tone_curve_t *curve = (tone_curve_t *)args;
+  assert(curve != NULL);
+
+  u8 *restrict r = span->r, *restrict g = span->g, *restrict b = span->b;
+
+  for (int i = 0; i < span->count; ++i) {
+    r[i] = curve->r[r[i]];
+    g[i] = curve->g[g[i]];
+    b[i] = curve->b[b[i]];
+  }
+}
+
+void init_tone_curve(tone_curve_t *curve, f32 contrast, f32 gamma) {
+  assert(curve != NULL);
+  assert(gamma > 0.0f);
+
+  f32 inv_gamma = 1.0f / gamma;
+  for (int i = 0; i < 256; ++i) {
+    f32 v = (i / 255.0f - 0.5f) * contrast + 0.5f;
+    v = powf(fmaxf(0.0f, fminf(1.0f, v)), inv_gamma);
+
+    curve->r[i] = curve->g[i] = curve->b[i] = (u8)(v * 255.0f + 0.5f);
+  }
+}
+
+// Applies fog to the whole screen as a single pass chain with a table of its own, so the one shaders read is kept
+void apply_fog_to_screen(renderer_t *restrict state, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b) {
+  fog_lut_t lut;
+  init_fog_lut(&lut, fog_start, fog_end, fog_r, fog_g, fog_b);
+
+  post_process_chain_t chain;
+  init_post_process_chain(&chain);
+  add_post_process_pass(&chain, fog_pass, &lut);
+
+  apply_post_process_chain(state, &chain);
+}
@@ -1,12 +1,49 @@
 #include <shader-works/primitives.h>
+#include <shader-works/lod.h>
+#include <shader-works/memory.h>
+#include <shader-works/obj.h>
+#include <shader-works/mesh_cache.h>
+#include <shader-works/shared_mesh.h>
+
+#include "file_map.h"
 
 #include <stdlib.h>
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
-#include <stdio.h>
 #include <string.h>
-#include <float.h>
+
+// A model buffer, carved from the model's arena while it has room and from the heap otherwise
+static void *alloc_model_buffer(model_t *model, usize size) {
+  void *buffer = arena_alloc(model->arena, size);
+  return buffer ? buffer : sw_alloc(size, SW_MEMORY_GEOMETRY);
+}
+
+// Frees a buffer from alloc_model_buffer, arena memory goes back with the arena
+static void free_model_buffer(model_t *model, void *buffer) {
+  if (!arena_contains(model->arena, buffer)) sw_free(buffer);
+}
+
+// vertex_data and face_normals for a generator. Returns 0 on success, -1 on allocation failure with neither set
+static int alloc_model_geometry(model_t *model, usize num_vertices, usize num_faces) {
+  model->vertex_data = alloc_model_buffer(model, num_vertices * sizeof(vertex_data_t));
+  model->face_normals = alloc_model_buffer(model, num_faces * sizeof(float3));
+
+  if (!model->vertex_data || !model->face_normals) {
+    free_model_buffer(model, model->vertex_data);
+    free_model_buffer(model, model->face_normals);
+    model->vertex_data = NULL;
+    model->face_normals = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+// Grid corner x, z of a plane, computed per quad rather than kept in a temporary grid
+static inline vertex_data_t plane_corner(float sx, float sz, float wx, float dz, float y, usize x, usize z, usize w_segs, usize d_segs) {
+  return (vertex_data_t){{sx + x * wx, y, sz + z * dz}, {(float)x / w_segs, (float)z / d_segs}, {0.0f, -1.0f, 0.0f}};
+}
 
 int generate_plane(model_t* model, float2 size, float2 segment_size, float3 position) {
   return generate_plane_with_norm(model, size, segment_size, position, (float3){0.0f, -1.0f, 0.0f});
@@ -19,74 +56,35 @@ int generate_plane_with_norm(model_t* model, float2 size, float2 segment_size, f
   usize w_segs = (usize)(size.x / segment_size.x);
   usize d_segs = (usize)(size.y / segment_size.y);
 
-  usize w = w_segs + 1, d = d_segs + 1;
-  usize grid_vertices = w * d;
-
   // Each quad becomes 2 triangles, so we need 6 vertices per quad
   usize num_quads = w_segs * d_segs;
   usize total_triangle_vertices = num_quads * 6;
   usize total_triangles = num_quads * 2; // Each quad has 2 triangles
 
-  model->vertex_data = malloc(total_triangle_vertices * sizeof(vertex_data_t));
-  model->face_normals = malloc(total_triangles * sizeof(float3));
-  if (!model->vertex_data || !model->face_normals) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    return -1;
-  }
-
-  // Create temporary grid of vertices
-  float3 *grid_verts = malloc(grid_vertices * sizeof(float3));
-  float2 *grid_uvs = malloc(grid_vertices * sizeof(float2));
-  if (!grid_verts || !grid_uvs) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    free(grid_verts);
-    free(grid_uvs);
-    return -1;
-  }
+  if (alloc_model_geometry(model, total_triangle_vertices, total_triangles) != 0) return -1;
 
   float wx = size.x / w_segs, dz = size.y / d_segs;
   float sx = position.x - size.x * 0.5f, sz = position.z - size.y * 0.5f;
 
-  // Generate grid vertices
-  for (usize z = 0; z < d; z++) {
-    for (usize x = 0; x < w; x++) {
-      usize i = z * w + x;
-      grid_verts[i] = (float3){sx + x * wx, position.y, sz + z * dz};
-      grid_uvs[i] = (float2){(float)x / w_segs, (float)z / d_segs};
-    }
-  }
-
   // Generate triangles from grid (CCW winding)
   usize vertex_idx = 0;
   for (usize z = 0; z < d_segs; z++) {
     for (usize x = 0; x < w_segs; x++) {
       // Get the four corners of current quad
-      usize tl = z * w + x;           // top-left
-      usize tr = z * w + (x + 1);     // top-right
-      usize bl = (z + 1) * w + x;     // bottom-left
-      usize br = (z + 1) * w + (x + 1); // bottom-right
+      vertex_data_t tl = plane_corner(sx, sz, wx, dz, position.y, x, z, w_segs, d_segs);         // top-left
+      vertex_data_t tr = plane_corner(sx, sz, wx, dz, position.y, x + 1, z, w_segs, d_segs);     // top-right
+      vertex_data_t bl = plane_corner(sx, sz, wx, dz, position.y, x, z + 1, w_segs, d_segs);     // bottom-left
+      vertex_data_t br = plane_corner(sx, sz, wx, dz, position.y, x + 1, z + 1, w_segs, d_segs); // bottom-right
 
       // First triangle: TL -> BL -> TR (CCW)
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[tl], grid_uvs[tl], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
-
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[bl], grid_uvs[bl], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
-
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[tr], grid_uvs[tr], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
+      model->vertex_data[vertex_idx++] = tl;
+      model->vertex_data[vertex_idx++] = bl;
+      model->vertex_data[vertex_idx++] = tr;
 
       // Second triangle: TR -> BL -> BR (CCW)
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[tr], grid_uvs[tr], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
-
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[bl], grid_uvs[bl], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
-
-      model->vertex_data[vertex_idx] = (vertex_data_t){grid_verts[br], grid_uvs[br], {0.0f, -1.0f, 0.0f}};
-      vertex_idx++;
+      model->vertex_data[vertex_idx++] = tr;
+      model->vertex_data[vertex_idx++] = bl;
+      model->vertex_data[vertex_idx++] = br;
     }
   }
 
@@ -100,9 +98,8 @@ int generate_plane_with_norm(model_t* model, float2 size, float2 segment_size, f
     model->face_normals[i] = normal;
   }
 
-  free(grid_verts);
-  free(grid_uvs);
   model->disable_behind_camera_culling = false;
+  compute_model_bounds(model);
   return 0;
 }
 
@@ -112,14 +109,7 @@ int generate_cube(model_t* model, float3 position, float3 size) {
   const int CUBE_VERTS = 36;  // 6 faces * 2 triangles * 3 vertices
 
   // Allocate cache-friendly vertex data and face normals
-  model->vertex_data = malloc(CUBE_VERTS * sizeof(vertex_data_t));
-  model->face_normals = malloc((CUBE_VERTS / 3) * sizeof(float3));
-
-  if (!model->vertex_data || !model->face_normals) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    return -1;
-  }
+  if (alloc_model_geometry(model, CUBE_VERTS, CUBE_VERTS / 3) != 0) return -1;
 
   // Half extents for more intuitive vertex positioning
   float3 half = {size.x * 0.5f, size.y * 0.5f, size.z * 0.5f};
@@ -199,6 +189,7 @@ int generate_cube(model_t* model, float3 position, float3 size) {
   model->transform.yaw = 0.0f;
   model->transform.pitch = 0.0f;
 
+  compute_model_bounds(model);
   return 0;
 }
 
@@ -207,14 +198,7 @@ int generate_inward_cube(model_t* model, float3 position, float3 size) {
 
   const int CUBE_VERTS = 36;  // 6 faces * 2 triangles * 3 vertices
 
-  model->vertex_data = malloc(CUBE_VERTS * sizeof(vertex_data_t));
-  model->face_normals = malloc((CUBE_VERTS / 3) * sizeof(float3));
-
-  if (!model->vertex_data || !model->face_normals) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    return -1;
-  }
+  if (alloc_model_geometry(model, CUBE_VERTS, CUBE_VERTS / 3) != 0) return -1;
 
   float3 half = {size.x * 0.5f, size.y * 0.5f, size.z * 0.5f};
   int v = 0;
@@ -287,6 +271,7 @@ for (int i = 0; i < CUBE_VERTS / 3; i++) {
   model->transform.yaw = 0.0f;
   model->transform.pitch = 0.0f;
 
+  compute_model_bounds(model);
   return 0;
 }
 
@@ -300,24 +285,20 @@ int generate_sphere(model_t* model, f32 radius, int segments, int rings, float3
   int num_triangles = 2 * rings * segments;
 
   // Allocate cache-friendly vertex data and face normals
-  model->vertex_data = (vertex_data_t*)malloc(num_triangles * 3 * sizeof(vertex_data_t)); // 3 vertices per triangle
-  model->face_normals = (float3*)malloc(num_triangles * sizeof(float3)); // 1 normal per triangle
-
-  if (!model->vertex_data || !model->face_normals) {
-    if (model->vertex_data) free(model->vertex_data);
-    if (model->face_normals) free(model->face_normals);
-    return -1;
-  }
+  // 3 vertices and 1 normal per triangle
+  if (alloc_model_geometry(model, num_triangles * 3, num_triangles) != 0) return -1;
 
   // Generate temporary vertex and UV grids
-  float3* temp_vertices = (float3*)malloc(num_vertices * sizeof(float3));
-  float2* temp_uvs = (float2*)malloc(num_vertices * sizeof(float2));
+  float3* temp_vertices = (float3*)sw_alloc(num_vertices * sizeof(float3), SW_MEMORY_SCRATCH);
+  float2* temp_uvs = (float2*)sw_alloc(num_vertices * sizeof(float2), SW_MEMORY_SCRATCH);
 
   if (!temp_vertices || !temp_uvs) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    if (temp_vertices) free(temp_vertices);
-    if (temp_uvs) free(temp_uvs);
+    free_model_buffer(model, model->vertex_data);
+    free_model_buffer(model, model->face_normals);
+    model->vertex_data = NULL;
+    model->face_normals = NULL;
+    sw_free(temp_vertices);
+    sw_free(temp_uvs);
     return -1;
   }
 
@@ -400,8 +381,8 @@ int generate_sphere(model_t* model, f32 radius, int segments, int rings, float3
     }
   }
 
-  free(temp_vertices);
-  free(temp_uvs);
+  sw_free(temp_vertices);
+  sw_free(temp_uvs);
 
   model->num_vertices = num_triangles * 3;
   model->num_faces = num_triangles;
@@ -411,6 +392,7 @@ int generate_sphere(model_t* model, f32 radius, int segments, int rings, float3
   model->transform.pitch = 0.0f;
   model->scale = make_float3(1.0f, 1.0f, 1.0f);
 
+  compute_model_bounds(model);
   return 0;
 }
 
@@ -420,14 +402,7 @@ int generate_quad(model_t* model, float2 size, float3 position) {
   const int BILLBOARD_VERTS = 6;  // 2 triangles * 3 vertices each
 
   // Allocate cache-friendly vertex data and face normals
-  model->vertex_data = malloc(BILLBOARD_VERTS * sizeof(vertex_data_t));
-  model->face_normals = malloc(2 * sizeof(float3));  // 2 triangles
-
-  if (!model->vertex_data || !model->face_normals) {
-    free(model->vertex_data);
-    free(model->face_normals);
-    return -1;
-  }
+  if (alloc_model_geometry(model, BILLBOARD_VERTS, 2) != 0) return -1; // 2 triangles
 
   // Half extents for quad positioning
   float half_width = size.x * 0.5f;
@@ -461,24 +436,80 @@ int generate_quad(model_t* model, float2 size, float3 position) {
   model->transform.yaw = 0.0f;
   model->transform.pitch = 0.0f;
 
+  compute_model_bounds(model);
   return 0;
 }
 
+void compute_model_bounds(model_t* model) {
+  assert(model != NULL);
+
+  if (!model->vertex_data || model->num_vertices == 0) {
+    model->bounds_min = model->bounds_max = model->bounds_center = make_float3(0.0f, 0.0f, 0.0f);
+    model->bounds_radius = 0.0f;
+    return;
+  }
+
+  float3 min = model->vertex_data[0].position;
+  float3 max = min;
+  for (usize i = 1; i < model->num_vertices; ++i) {
+    float3 p = model->vertex_data[i].position;
+    min = make_float3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+    max = make_float3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+  }
+
+  // Sphere around the box center, radius from the farthest vertex rather than the box corner for a tighter fit
+  float3 center = float3_scale(float3_add(min, max), 0.5f);
+  f32 radius_sq = 0.0f;
+  for (usize i = 0; i < model->num_vertices; ++i) {
+    float3 d = float3_sub(model->vertex_data[i].position, center);
+    radius_sq = fmaxf(radius_sq, float3_dot(d, d));
+  }
+
+  model->bounds_min = min;
+  model->bounds_max = max;
+  model->bounds_center = center;
+  model->bounds_radius = sqrtf(radius_sq) + EPSILON; // keep degenerate single point models cullable
+}
+
 void delete_model(model_t* model) {
   if (!model) return;
 
+  // Borrowed geometry stays with the shared mesh
+  if (model->shared_mesh) {
+    release_shared_mesh(model->shared_mesh);
+    model->shared_mesh = NULL;
+    model->vertex_data = NULL;
+    model->face_normals = NULL;
+    model->lods = NULL;
+    model->num_lods = 0;
+  }
+
+  // Mapped geometry goes back with the mapping
+  if (model->mesh_cache) {
+    close_mesh_cache(model->mesh_cache);
+    model->mesh_cache = NULL;
+    model->vertex_data = NULL;
+    model->face_normals = NULL;
+  }
+
   if (model->vertex_data) {
-    free(model->vertex_data);
+    free_model_buffer(model, model->vertex_data);
     model->vertex_data = NULL;
   }
 
   if (model->face_normals) {
-    free(model->face_normals);
+    free_model_buffer(model, model->face_normals);
     model->face_normals = NULL;
   }
 
+  free_model_buffer(model, model->shading_cache.texels);
+  model->shading_cache = (shading_cache_t){0};
+
+  free_model_lods(model);
+
   model->num_vertices = 0;
   model->num_faces = 0;
+  model->bounds_radius = 0.0f;
 
   model->frag_shader = NULL;
   model->vertex_shader = NULL;
@@ -490,386 +521,89 @@ void delete_model(model_t* model) {
 // OBJ Model Loader
 // ============================================================================
 
-#define OBJ_INITIAL_CAPACITY 1024
-
-typedef struct {
-  float3 *positions;
-  float2 *texcoords;
-  float3 *normals;
-  usize pos_count, tex_count, norm_count;
-  usize pos_capacity, tex_capacity, norm_capacity;
-} obj_buffers_t;
-
-static int obj_parse_face_vertex(const char* vert_str, int *v_idx, int *vt_idx, int *vn_idx) {
-  // Parse formats: v, v/vt, v//vn, v/vt/vn
-  int result = sscanf(vert_str, "%d/%d/%d", v_idx, vt_idx, vn_idx);
-
-  if (result == 1) {
-    // Format: v
-    *vt_idx = -1;
-    *vn_idx = -1;
-  } else if (result == 2) {
-    // Format: v/vt
-    *vn_idx = -1;
-  } else if (result != 3) {
-    // Try v//vn format
-    result = sscanf(vert_str, "%d//%d", v_idx, vn_idx);
-    if (result == 2) {
-      *vt_idx = -1;
-    } else {
-      return -1; // Parse error
-    }
-  }
-
-  return 0;
-}
+// Parses filename into the model's geometry, bounds and use_textures
+static int parse_obj_geometry(model_t *model, const char *filename, bool flip_winding) {
+  obj_mesh_t mesh;
+  if (load_obj_mesh(&mesh, filename, flip_winding) != 0) return -1;
 
-int load_obj_model(model_t* model, const char* filename, float3 position, float scale, bool flip_winding) {
-  if (!model || !filename) return -1;
-
-  FILE *file = fopen(filename, "r");
-  if (!file) {
+  // The renderer draws unindexed triangles, expand the shared vertices back out
+  if (alloc_model_geometry(model, mesh.num_triangles * 3, mesh.num_triangles) != 0) {
+    free_obj_mesh(&mesh);
     return -1;
   }
 
-  obj_buffers_t buffers = {0};
-  buffers.pos_capacity = OBJ_INITIAL_CAPACITY;
-  buffers.tex_capacity = OBJ_INITIAL_CAPACITY;
-  buffers.norm_capacity = OBJ_INITIAL_CAPACITY;
-
-  buffers.positions = malloc(buffers.pos_capacity * sizeof(float3));
-  buffers.texcoords = malloc(buffers.tex_capacity * sizeof(float2));
-  buffers.normals = malloc(buffers.norm_capacity * sizeof(float3));
-
-  if (!buffers.positions || !buffers.texcoords || !buffers.normals) {
-    free(buffers.positions);
-    free(buffers.texcoords);
-    free(buffers.normals);
-    fclose(file);
-    return -1;
+  for (usize i = 0; i < mesh.num_triangles * 3; ++i) {
+    u32 index = mesh.indices[i];
+    model->vertex_data[i] = (vertex_data_t){mesh.positions[index], mesh.uvs[index], mesh.normals[index]};
   }
 
-  // Dynamic array for face indices (each face can have 3+ vertices)
-  typedef struct { int v, vt, vn; } face_vertex_t;
-  face_vertex_t *face_vertices = malloc(OBJ_INITIAL_CAPACITY * sizeof(face_vertex_t));
-  usize face_vert_capacity = OBJ_INITIAL_CAPACITY;
-  usize face_vert_count = 0;
-
-  usize num_triangles = 0;
-  char line[512];
-  float3 default_normal = {0.0f, 1.0f, 0.0f};
-  float2 default_uv = {0.0f, 0.0f};
-
-  // First pass: parse all data
-  while (fgets(line, sizeof(line), file)) {
-    // Skip whitespace
-    char *p = line;
-    while (*p == ' ' || *p == '\t') p++;
-
-    if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t')) {
-      // Vertex position
-      float x, y, z;
-      if (sscanf(p + 1, "%f %f %f", &x, &y, &z) == 3) {
-        if (buffers.pos_count >= buffers.pos_capacity) {
-          buffers.pos_capacity *= 2;
-          float3 *temp = realloc(buffers.positions, buffers.pos_capacity * sizeof(float3));
-          if (!temp) goto cleanup_error;
-          buffers.positions = temp;
-        }
-        // Flip Z to convert from OBJ (+Z forward) to render system (-Z forward)
-        // Don't scale here - let transform.scale handle it
-        buffers.positions[buffers.pos_count++] = (float3){x, y, -z};
-      }
-    }
-    else if (p[0] == 'v' && p[1] == 't' && (p[2] == ' ' || p[2] == '\t')) {
-      // Texture coordinate
-      float u, v;
-      if (sscanf(p + 2, "%f %f", &u, &v) >= 1) {
-        if (buffers.tex_count >= buffers.tex_capacity) {
-          buffers.tex_capacity *= 2;
-          float2 *temp = realloc(buffers.texcoords, buffers.tex_capacity * sizeof(float2));
-          if (!temp) goto cleanup_error;
-          buffers.texcoords = temp;
-        }
-        float v_coord = (sscanf(p + 2, "%f %f", &u, &v) == 2) ? v : 0.0f;
-        buffers.texcoords[buffers.tex_count++] = (float2){u, v_coord};
-      }
-    }
-    else if (p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t')) {
-      // Vertex normal
-      float nx, ny, nz;
-      if (sscanf(p + 2, "%f %f %f", &nx, &ny, &nz) == 3) {
-        if (buffers.norm_count >= buffers.norm_capacity) {
-          buffers.norm_capacity *= 2;
-          float3 *temp = realloc(buffers.normals, buffers.norm_capacity * sizeof(float3));
-          if (!temp) goto cleanup_error;
-          buffers.normals = temp;
-        }
-        // Flip all normal components for correct lighting with -Z forward camera
-        buffers.normals[buffers.norm_count++] = (float3){-nx, -ny, -nz};
-      }
-    }
-    else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
-      // Face - can have 3+ vertices (triangulate n-gons)
-      face_vert_count = 0;
-      char *line_ptr = p + 2;  // Skip "f "
-
-      // Skip leading whitespace
-      while (*line_ptr && (*line_ptr == ' ' || *line_ptr == '\t')) line_ptr++;
-
-      // Parse all vertices in this face
-      while (*line_ptr && *line_ptr != '\n' && *line_ptr != '#') {
-        if (face_vert_count >= face_vert_capacity) {
-          face_vert_capacity *= 2;
-          face_vertex_t *temp = realloc(face_vertices, face_vert_capacity * sizeof(face_vertex_t));
-          if (!temp) goto cleanup_error;
-          face_vertices = temp;
-        }
-
-        int v, vt, vn;
-        int bytes_read;
-
-        // Try to parse vertex specification
-        if (sscanf(line_ptr, "%d/%d/%d%n", &v, &vt, &vn, &bytes_read) == 3) {
-          // Full format: v/vt/vn
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d//%d%n", &v, &vn, &bytes_read) == 2) {
-          // Format: v//vn
-          vt = -1;
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d/%d%n", &v, &vt, &bytes_read) == 2) {
-          // Format: v/vt
-          vn = -1;
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d%n", &v, &bytes_read) == 1) {
-          // Format: v
-          vt = -1;
-          vn = -1;
-          line_ptr += bytes_read;
-        } else {
-          // Parse error - skip this character and continue
-          line_ptr++;
-          continue;
-        }
-
-        // Convert to 0-indexed
-        face_vertices[face_vert_count].v = (v > 0) ? v - 1 : -1;
-        face_vertices[face_vert_count].vt = (vt > 0) ? vt - 1 : -1;
-        face_vertices[face_vert_count].vn = (vn > 0) ? vn - 1 : -1;
-        face_vert_count++;
-
-        // Skip whitespace to next vertex
-        while (*line_ptr && (*line_ptr == ' ' || *line_ptr == '\t')) line_ptr++;
-      }
-
-      // Triangulate n-gon using fan triangulation
-      if (face_vert_count >= 3) {
-        for (usize tri = 1; tri < face_vert_count - 1; tri++) {
-          num_triangles++;
-        }
-      }
-    }
-  }
+  for (usize face = 0; face < mesh.num_triangles; ++face) {
+    float3 v0 = model->vertex_data[face * 3].position;
+    float3 v1 = model->vertex_data[face * 3 + 1].position;
+    float3 v2 = model->vertex_data[face * 3 + 2].position;
 
-  fprintf(stderr, "[OBJ] First pass: counted %zu triangles\n", num_triangles);
-  fflush(stderr);
+    // Cross product: e1 × e2 (order matters for normal direction)
+    // Since we may have flipped winding and Z coordinates, this gives us the correct outward normal
+    float3 normal = float3_cross(float3_sub(v1, v0), float3_sub(v2, v0));
 
-  // Calculate model centroid to center it at origin
-  float3 min_bound = {FLT_MAX, FLT_MAX, FLT_MAX};
-  float3 max_bound = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    float len = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+    if (len > 0.0001f) {
+      normal = (float3){normal.x / len, normal.y / len, normal.z / len};
+    } else {
+      // Degenerate triangle, use default
+      normal = (float3){0.0f, 1.0f, 0.0f};
+    }
 
-  for (usize i = 0; i < buffers.pos_count; i++) {
-    if (buffers.positions[i].x < min_bound.x) min_bound.x = buffers.positions[i].x;
-    if (buffers.positions[i].y < min_bound.y) min_bound.y = buffers.positions[i].y;
-    if (buffers.positions[i].z < min_bound.z) min_bound.z = buffers.positions[i].z;
-    if (buffers.positions[i].x > max_bound.x) max_bound.x = buffers.positions[i].x;
-    if (buffers.positions[i].y > max_bound.y) max_bound.y = buffers.positions[i].y;
-    if (buffers.positions[i].z > max_bound.z) max_bound.z = buffers.positions[i].z;
+    model->face_normals[face] = normal;
   }
 
-  float3 centroid = {
-    (min_bound.x + max_bound.x) * 0.5f,
-    (min_bound.y + max_bound.y) * 0.5f,
-    (min_bound.z + max_bound.z) * 0.5f
-  };
-
-  // Center all vertices
-  for (usize i = 0; i < buffers.pos_count; i++) {
-    buffers.positions[i].x -= centroid.x;
-    buffers.positions[i].y -= centroid.y;
-    buffers.positions[i].z -= centroid.z;
-  }
+  model->num_vertices = mesh.num_triangles * 3;
+  model->num_faces = mesh.num_triangles;
+  model->use_textures = mesh.has_texcoords;
+  compute_model_bounds(model);
 
-  // Allocate vertex and face data
-  usize total_vertices = num_triangles * 3;
-  model->vertex_data = malloc(total_vertices * sizeof(vertex_data_t));
-  model->face_normals = malloc(num_triangles * sizeof(float3));
+  free_obj_mesh(&mesh);
+  return 0;
+}
 
-  if (!model->vertex_data || !model->face_normals) {
-    goto cleanup_error;
+int load_obj_model(model_t* model, const char* filename, float3 position, float scale, bool flip_winding) {
+  if (!model || !filename) return -1;
+
+  // A cache is only good for the OBJ as it was and the winding it was built with
+  // Each winding gets its own file so loading both doesn't keep rewriting one, scale isn't baked and needs no key
+  u64 stamp = file_stamp(filename);
+  if (stamp && flip_winding) stamp = ~stamp;
+
+  const char *extension = flip_winding ? MESH_CACHE_FLIPPED_EXTENSION : MESH_CACHE_EXTENSION;
+  char *cache_path = NULL;
+  if (stamp && !model->arena) {
+    usize length = strlen(filename), extension_size = strlen(extension) + 1;
+    cache_path = sw_alloc(length + extension_size, SW_MEMORY_SCRATCH);
+    if (cache_path) {
+      memcpy(cache_path, filename, length);
+      memcpy(cache_path + length, extension, extension_size);
+    }
   }
 
-  // Second pass: reconstruct vertex data with proper indexing
-  rewind(file);
-  usize vert_idx = 0;
-  usize face_idx = 0;
-
-  while (fgets(line, sizeof(line), file)) {
-    char *p = line;
-    while (*p == ' ' || *p == '\t') p++;
-
-    if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')) {
-      face_vert_count = 0;
-      char *line_ptr = p + 2;  // Skip "f "
-
-      // Skip leading whitespace
-      while (*line_ptr && (*line_ptr == ' ' || *line_ptr == '\t')) line_ptr++;
-
-      // Parse all vertices in this face
-      while (*line_ptr && *line_ptr != '\n' && *line_ptr != '#') {
-        if (face_vert_count >= face_vert_capacity) break;
-
-        int v, vt, vn;
-        int bytes_read;
-
-        // Try to parse vertex specification
-        if (sscanf(line_ptr, "%d/%d/%d%n", &v, &vt, &vn, &bytes_read) == 3) {
-          // Full format: v/vt/vn
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d//%d%n", &v, &vn, &bytes_read) == 2) {
-          // Format: v//vn
-          vt = -1;
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d/%d%n", &v, &vt, &bytes_read) == 2) {
-          // Format: v/vt
-          vn = -1;
-          line_ptr += bytes_read;
-        } else if (sscanf(line_ptr, "%d%n", &v, &bytes_read) == 1) {
-          // Format: v
-          vt = -1;
-          vn = -1;
-          line_ptr += bytes_read;
-        } else {
-          // Parse error - skip this character and continue
-          line_ptr++;
-          continue;
-        }
-
-        // Convert to 0-indexed
-        face_vertices[face_vert_count].v = (v > 0) ? v - 1 : -1;
-        face_vertices[face_vert_count].vt = (vt > 0) ? vt - 1 : -1;
-        face_vertices[face_vert_count].vn = (vn > 0) ? vn - 1 : -1;
-        face_vert_count++;
-
-        // Skip whitespace to next vertex
-        while (*line_ptr && (*line_ptr == ' ' || *line_ptr == '\t')) line_ptr++;
-      }
-
-      // Triangulate and generate vertex data
-      for (usize tri = 1; tri < face_vert_count - 1; tri++) {
-        // Fan triangulation: vertex 0, tri, tri+1
-        usize tri_indices[3];
-        if (flip_winding) {
-          tri_indices[0] = 0;
-          tri_indices[1] = tri + 1;
-          tri_indices[2] = tri;
-        } else {
-          tri_indices[0] = 0;
-          tri_indices[1] = tri;
-          tri_indices[2] = tri + 1;
-        }
-
-        // Process three vertices of the triangle
-        for (int i = 0; i < 3; i++) {
-          usize face_vert_idx = tri_indices[i];
-          if (face_vert_idx >= face_vert_count) continue;
-
-          int v_idx = face_vertices[face_vert_idx].v;
-          int vt_idx = face_vertices[face_vert_idx].vt;
-          int vn_idx = face_vertices[face_vert_idx].vn;
-
-          if (v_idx < 0 || (usize)v_idx >= buffers.pos_count) {
-            goto cleanup_error;
-          }
-
-          // Don't bake position offset into vertices - store it in transform instead
-          float3 pos = buffers.positions[v_idx];
-
-          float2 uv = (vt_idx >= 0 && (usize)vt_idx < buffers.tex_count)
-                      ? buffers.texcoords[vt_idx]
-                      : default_uv;
-
-          float3 norm = (vn_idx >= 0 && (usize)vn_idx < buffers.norm_count)
-                        ? buffers.normals[vn_idx]
-                        : default_normal;
-
-          if (vert_idx < total_vertices) {
-            model->vertex_data[vert_idx] = (vertex_data_t){pos, uv, norm};
-            vert_idx++;
-          }
-        }
-
-        // Compute and store face normal (for back-face culling)
-        if (face_idx < num_triangles && vert_idx >= 3) {
-          float3 v0 = model->vertex_data[vert_idx - 3].position;
-          float3 v1 = model->vertex_data[vert_idx - 2].position;
-          float3 v2 = model->vertex_data[vert_idx - 1].position;
-
-          float3 e1 = {v1.x - v0.x, v1.y - v0.y, v1.z - v0.z};
-          float3 e2 = {v2.x - v0.x, v2.y - v0.y, v2.z - v0.z};
-
-          // Cross product: e1 × e2 (order matters for normal direction)
-          // Since we may have flipped winding and Z coordinates, this gives us the correct outward normal
-          float3 normal = {
-            e1.y * e2.z - e1.z * e2.y,
-            e1.z * e2.x - e1.x * e2.z,
-            e1.x * e2.y - e1.y * e2.x
-          };
-
-          // Normalize
-          float len = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
-          if (len > 0.0001f) {
-            normal.x /= len;
-            normal.y /= len;
-            normal.z /= len;
-          } else {
-            // Degenerate triangle, use default
-            normal = (float3){0.0f, 1.0f, 0.0f};
-          }
-
-          model->face_normals[face_idx] = normal;
-          face_idx++;
-        }
-      }
+  if (!cache_path || load_mesh_cache(model, cache_path, stamp) != 0) {
+    if (parse_obj_geometry(model, filename, flip_winding) != 0) {
+      sw_free(cache_path);
+      return -1;
     }
+
+    // Best effort, the directory may well be read only
+    if (cache_path) write_mesh_cache(cache_path, model, stamp);
   }
+  sw_free(cache_path);
 
-  model->num_vertices = vert_idx;
-  model->num_faces = face_idx;
   model->scale = (float3){scale, scale, scale};
   model->transform.position = position;
   model->transform.yaw = 0.0f;
   model->transform.pitch = 0.0f;
   model->transform.roll = 0.0f;
-  model->use_textures = (buffers.tex_count > 0);
   model->disable_behind_camera_culling = false;
   model->vertex_shader = NULL;
   model->frag_shader = NULL;
 
-  // Cleanup
-  free(buffers.positions);
-  free(buffers.texcoords);
-  free(buffers.normals);
-  free(face_vertices);
-  fclose(file);
-
   return 0;
-
-cleanup_error:
-  free(buffers.positions);
-  free(buffers.texcoords);
-  free(buffers.normals);
-  free(face_vertices);
-  fclose(file);
-  return -1;
 }
@@ -11,44 +11,17 @@
 #include <time.h>
 
 #include <shader-works/maths.h>
+#include <shader-works/shadow_map.h>
+#include <shader-works/lod.h>
 
-#define MAGENTA 0xF81F
-
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include "parallel.h"
 
-#ifdef SHADER_WORKS_USE_PTHREADS
-#include <pthread.h>
-#include <unistd.h> // For sysconf
+#define MAGENTA 0xF81F
+#define NEAR_PLANE 0.01f            // view space distance triangles and wireframe edges are clipped against
+#define WIREFRAME_DEPTH_BIAS 0.01f  // relative depth slack letting edges win against their own filled faces
 
 bool render_triangle(triangle_context_t *ctx);
 
-typedef struct {
-  triangle_context_t base_ctx;
-  int total_triangles;
-  int* next_triangle;
-  usize* triangles_rendered;
-} worker_thread_data_t;
-
-static void* worker_thread(void* arg) {
-  worker_thread_data_t* data = (worker_thread_data_t*)arg;
-  usize local_count = 0;
-  int tri;
-
-  // Atomically grab triangles one at a time
-  while ((tri = __sync_fetch_and_add(data->next_triangle, 1)) < data->total_triangles) {
-    data->base_ctx.tri = tri;
-    if (render_triangle(&data->base_ctx)) {
-      local_count++;
-    }
-  }
-
-  *data->triangles_rendered = local_count;
-  return NULL;
-}
-#endif
-
 // Calculates the signed area of a triangle defined by three points.
 static inline f32 signed_triangle_area(const float2 a, const float2 b, const float2 c) {
   return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
@@ -122,7 +95,7 @@ static inline float3 transform_vector(float3 ihat, float3 jhat, float3 khat, flo
 }
 
 // Extracts the basis vectors (right, up, forward) from a transform's yaw, pitch, and roll
-void transform_get_basis_vectors(transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat) {
+void transform_get_basis_vectors(const transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat) {
   assert(t != NULL);
   assert(ihat != NULL);
   assert(jhat != NULL);
@@ -143,7 +116,7 @@ void transform_get_basis_vectors(transform_t *restrict t, float3 *restrict ihat,
 }
 
 // Extracts the inverse basis vectors (right, up, forward) from a transform's yaw, pitch, and roll
-void transform_get_inverse_basis_vectors(transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat) {
+void transform_get_inverse_basis_vectors(const transform_t *restrict t, float3 *restrict ihat, float3 *restrict jhat, float3 *restrict khat) {
   assert(t != NULL);
   assert(ihat != NULL);
   assert(jhat != NULL);
@@ -163,18 +136,6 @@ void transform_get_inverse_basis_vectors(transform_t *restrict t, float3 *restri
   *khat = make_float3(-cr * sy - sr * cy * sp, -sr * sy + cr * cy * sp, cy * cp);
 }
 
-// Transform a point from local space to world space using the transform's basis vectors and position
-static float3 transform_to_world(transform_t *restrict t, float3 p) {
-  assert(t != NULL);
-
-  float3 ihat, jhat, khat;
-  transform_get_basis_vectors(t, &ihat, &jhat, &khat);
-
-  // Transform the point and then translate by position
-  float3 rotated = transform_vector(ihat, jhat, khat, p);
-  return float3_add(rotated, t->position);
-}
-
 // Transform a point from world space to local space using the inverse of the transform's basis vectors and position
 static float3 transform_to_local_point(transform_t *restrict t, float3 p) {
   assert(t != NULL);
@@ -223,12 +184,8 @@ static void apply_vertex_shader(model_t *restrict model, vertex_shader_t *restri
 static bool frustum_cull_triangle(float3 a, float3 b, float3 c, f32 frustum_bound, f32 max_depth, bool disable_behind_camera_culling) {
  // Basic frustum culling: skip triangle if all vertices are behind camera (z > 0 in view space)
   if (!disable_behind_camera_culling && a.z > 0 && b.z > 0 && c.z > 0) return true;
-  // Cull triangles where the closest vertex is still too far away
-  float closest_distance = -fmax(a.z, fmax(b.z, c.z));
-  if (closest_distance < -EPSILON) {
-    // Uncomment for debugging: printf("Culling triangle at distance %.2f (max: %.2f)\n", closest_distance, max_depth);
-    return true;
-  }
+  // Nothing is left after clipping to the near plane
+  if (a.z > -NEAR_PLANE && b.z > -NEAR_PLANE && c.z > -NEAR_PLANE) return true;
 
   // Additional frustum culling - check if triangle is completely outside view frustum
   bool outside_left   = (a.x < a.z * frustum_bound && b.x < b.z * frustum_bound && c.x < c.z * frustum_bound);
@@ -239,10 +196,191 @@ static bool frustum_cull_triangle(float3 a, float3 b, float3 c, f32 frustum_boun
   return outside_left || outside_right || outside_top || outside_bottom;
 }
 
+// Whole-model frustum culling: returns true if the placement's bounding sphere lies completely outside the
+// region frustum_cull_triangle keeps, so none of its triangles could be drawn
+static bool frustum_cull_bounds(const triangle_context_t *restrict ctx) {
+  const model_t *model = ctx->model;
+  float3 scale = model->scale;
+  f32 max_scale = fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+  f32 radius = model->bounds_radius * max_scale;
+
+  float3 center = make_float3(model->bounds_center.x * scale.x, model->bounds_center.y * scale.y, model->bounds_center.z * scale.z);
+  center = float3_add(transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, center), ctx->transform->position);
+  float3 view = transform_to_local_point(ctx->cam, center);
+
+  if (!model->disable_behind_camera_culling && view.z > radius) return true; // entirely behind the camera
+
+  // Side planes |x| <= -z * frustum_bound, tested by signed distance against the radius
+  f32 fb = ctx->frustum_bound;
+  f32 plane_radius = radius * sqrtf(1.0f + fb * fb);
+  if (view.x - view.z * fb < -plane_radius) return true;  // left
+  if (-view.x - view.z * fb < -plane_radius) return true; // right
+  if (view.y - view.z * fb < -plane_radius) return true;  // bottom
+  if (-view.y - view.z * fb < -plane_radius) return true; // top
+
+  return false;
+}
+
+// Radius in pixels of the placement's bounding sphere, unbounded when the camera is inside it or the bounds are unknown
+static f32 get_screen_radius(const triangle_context_t *restrict ctx) {
+  const model_t *model = ctx->model;
+  if (model->bounds_radius <= 0.0f) return FLT_MAX;
+
+  float3 scale = model->scale;
+  f32 radius = model->bounds_radius * fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+
+  float3 center = make_float3(model->bounds_center.x * scale.x, model->bounds_center.y * scale.y, model->bounds_center.z * scale.z);
+  center = float3_add(transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, center), ctx->transform->position);
+
+  f32 distance = float3_magnitude(float3_sub(center, ctx->cam->position));
+  if (distance <= radius) return FLT_MAX;
+
+  return radius * ctx->state->projection_scale / distance;
+}
+
+// Projects a view space point to screen space, keeping its view z
+static inline float3 project_to_screen(const renderer_t *restrict state, float3 view) {
+  float pixels_per_world_unit = state->projection_scale / view.z;
+  return make_float3(state->screen_dim.x * 0.5f + view.x * pixels_per_world_unit,
+                     state->screen_dim.y * 0.5f + view.y * pixels_per_world_unit,
+                     view.z);
+}
+
+// Fills a screen space triangle into a depth buffer without shading
+// a, b, c: screen positions in x/y with the value to interpolate linearly across the screen in z
+// perspective: if true, z holds 1/view_z and the stored depth is -1/z, otherwise z is stored as is
+static void fill_triangle_depth(f32 *restrict depthbuffer, int width, int height, float3 a, float3 b, float3 c, bool perspective) {
+  float2 a2 = make_float2(a.x, a.y), b2 = make_float2(b.x, b.y), c2 = make_float2(c.x, c.y);
+  f32 area = signed_triangle_area(a2, b2, c2);
+  if (fabsf(area) < EPSILON) return; // Degenerate or edge-on
+
+  int min_x = (int)fmaxf(0.0f, floorf(fminf(a.x, fminf(b.x, c.x))));
+  int max_x = (int)fminf((f32)width - 1, ceilf(fmaxf(a.x, fmaxf(b.x, c.x))));
+  int min_y = (int)fmaxf(0.0f, floorf(fminf(a.y, fminf(b.y, c.y))));
+  int max_y = (int)fminf((f32)height - 1, ceilf(fmaxf(a.y, fmaxf(b.y, c.y))));
+  if (min_x > max_x || min_y > max_y) return;
+
+  // Barycentric weights are linear in screen space, so step them instead of recomputing per pixel
+  f32 inv_area = 1.0f / area;
+  float3 dx = make_float3((b.y - c.y) * inv_area, (c.y - a.y) * inv_area, (a.y - b.y) * inv_area);
+  float3 dy = make_float3((c.x - b.x) * inv_area, (a.x - c.x) * inv_area, (b.x - a.x) * inv_area);
+
+  float2 start = make_float2(min_x + 0.5f, min_y + 0.5f);
+  float3 row = make_float3(signed_triangle_area(b2, c2, start) * inv_area,
+                           signed_triangle_area(c2, a2, start) * inv_area,
+                           signed_triangle_area(a2, b2, start) * inv_area);
+
+  for (int y = min_y; y <= max_y; ++y) {
+    float3 w = row;
+    f32 *restrict depth_row = depthbuffer + y * width;
+
+    for (int x = min_x; x <= max_x; ++x) {
+      if (w.x >= 0 && w.y >= 0 && w.z >= 0) {
+        f32 z = w.x * a.z + w.y * b.z + w.z * c.z;
+        f32 depth = perspective ? -1.0f / z : z;
+        if (depth < depth_row[x]) depth_row[x] = depth;
+      }
+
+      w.x += dx.x; w.y += dx.y; w.z += dx.z;
+    }
+
+    row.x += dy.x; row.y += dy.y; row.z += dy.z;
+  }
+}
+
+// Draws a depth tested line between two view space points with a DDA, clipped to the near plane and the screen
+// Depth is interpolated perspective correctly (1/z is linear in screen space)
+static void draw_edge(renderer_t *restrict state, float3 p0, float3 p1, u32 color) {
+  // Clip against the near plane in view space so projection stays finite
+  if (p0.z > -NEAR_PLANE && p1.z > -NEAR_PLANE) return;
+  if (p0.z > -NEAR_PLANE || p1.z > -NEAR_PLANE) {
+    f32 t = (-NEAR_PLANE - p0.z) / (p1.z - p0.z);
+    float3 clipped = float3_add(p0, float3_scale(float3_sub(p1, p0), t));
+    if (p0.z > -NEAR_PLANE) p0 = clipped; else p1 = clipped;
+  }
+
+  float3 s0 = project_to_screen(state, p0);
+  float3 s1 = project_to_screen(state, p1);
+  f32 inv_z0 = 1.0f / s0.z, inv_z1 = 1.0f / s1.z;
+
+  // Clip the segment parametrically against the screen rectangle (Liang-Barsky)
+  f32 dx = s1.x - s0.x, dy = s1.y - s0.y;
+  f32 t0 = 0.0f, t1 = 1.0f;
+  f32 p[4] = { -dx, dx, -dy, dy };
+  f32 q[4] = { s0.x, state->screen_dim.x - 0.001f - s0.x, s0.y, state->screen_dim.y - 0.001f - s0.y };
+
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == 0.0f) {
+      if (q[i] < 0.0f) return; // Parallel to and outside this edge
+      continue;
+    }
+
+    f32 r = q[i] / p[i];
+    if (p[i] < 0.0f) { if (r > t1) return; if (r > t0) t0 = r; }
+    else             { if (r < t0) return; if (r < t1) t1 = r; }
+  }
+
+  f32 x = s0.x + dx * t0, y = s0.y + dy * t0;
+  f32 inv_z = inv_z0 + (inv_z1 - inv_z0) * t0;
+  f32 span = fmaxf(fabsf(dx), fabsf(dy)) * (t1 - t0);
+  int steps = (int)ceilf(span);
+  f32 step = steps > 0 ? (t1 - t0) / (f32)steps : 0.0f;
+
+  f32 step_x = dx * step, step_y = dy * step, step_inv_z = (inv_z1 - inv_z0) * step;
+  int width = (int)state->screen_dim.x, height = (int)state->screen_dim.y;
+
+  for (int i = 0; i <= steps; ++i, x += step_x, y += step_y, inv_z += step_inv_z) {
+    int px = (int)x, py = (int)y;
+    if (px < 0 || px >= width || py < 0 || py >= height) continue; // Accumulated rounding at the clip boundary
+    int pixel_idx = py * width + px;
+    f32 depth = -1.0f / inv_z;
+    if (depth * (1.0f - WIREFRAME_DEPTH_BIAS) < state->depthbuffer[pixel_idx]) {
+      state->framebuffer[pixel_idx] = color;
+      if (depth < state->depthbuffer[pixel_idx]) state->depthbuffer[pixel_idx] = depth;
+    }
+  }
+}
+
+// Fetches the nearest baked texel to a normalized UV, UVs outside [0, 1] are clamped to the edge
+static inline u32 sample_shading_cache(const shading_cache_t *restrict cache, float u, float v) {
+  int x = (int)(u * (f32)cache->width);
+  int y = (int)(v * (f32)cache->height);
+
+  x = (x < 0) ? 0 : ((x > (int)cache->width - 1) ? (int)cache->width - 1 : x);
+  y = (y < 0) ? 0 : ((y > (int)cache->height - 1) ? (int)cache->height - 1 : y);
+
+  return cache->texels[y * cache->width + x];
+}
+
+// Returns true if the renderer has a texture atlas to sample from in its current format
+static inline bool has_texture_atlas(const renderer_t *restrict state) {
+  if (state->texture_format == TEXTURE_FORMAT_DIRECT) return state->texture_atlas != NULL;
+  return state->texture_indices != NULL && state->texture_palette != NULL;
+}
+
+// Fetches a texel from the texture atlas, resolving palette indices for indexed formats
+// tex_x, tex_y: texel coordinates, already clamped to the atlas dimensions
+static inline u32 sample_texture_atlas(const renderer_t *restrict state, int tex_x, int tex_y) {
+  int atlas_width = (int)state->atlas_dim.x;
+
+  switch (state->texture_format) {
+    case TEXTURE_FORMAT_INDEXED8:
+      return state->texture_palette[state->texture_indices[tex_y * atlas_width + tex_x]];
+    case TEXTURE_FORMAT_INDEXED4: {
+      // Rows are padded to a whole byte, low nibble holds the even texel
+      u8 packed = state->texture_indices[tex_y * ((atlas_width + 1) >> 1) + (tex_x >> 1)];
+      return state->texture_palette[(tex_x & 1) ? (packed >> 4) : (packed & 0x0F)];
+    }
+    default:
+      return state->texture_atlas[tex_y * atlas_width + tex_x];
+  }
+}
+
 u32 apply_fog_to_pixel(renderer_t *restrict state, u32 input, int screen_x, int screen_y, f32 depth, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b) {
+  if (depth <= fog_start) return input;
+
   u32 fog_color = rgb_to_u32(fog_r, fog_g, fog_b);
   if (depth >= fog_end) return fog_color;
-  if (depth <= fog_start) return input;
 
   int i = (int)(screen_y * state->screen_dim.x + screen_x);
   if (i < 0 || i >= (int)(state->screen_dim.x * state->screen_dim.y)) return fog_color; // Out of bounds check
@@ -266,31 +404,73 @@ u32 apply_fog_to_pixel(renderer_t *restrict state, u32 input, int screen_x, int
   return rgb_to_u32(r, g, b);
 }
 
-void apply_fog_to_screen(renderer_t *restrict state, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b) {
-  int total_pixels = (int)(state->screen_dim.x * state->screen_dim.y);
-  f32 inv_range = 1.0f / (fog_end - fog_start);
+void init_fog_lut(fog_lut_t *lut, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b) {
+  assert(lut != NULL);
+  assert(fog_end > fog_start);
+
+  lut->start = fog_start;
+  lut->end = fog_end;
+  lut->scale = (f32)FOG_LUT_SIZE / (fog_end - fog_start);
+  lut->r = fog_r; lut->g = fog_g; lut->b = fog_b;
+  lut->color = rgb_to_u32(fog_r, fog_g, fog_b);
 
-  for (int i = 0; i < total_pixels; ++i) {
-    f32 d = state->depthbuffer[i];
-    if (d >= FLT_MAX - 1.0f) continue;
+  // Sample the linear ramp at the centre of each depth step
+  for (int i = 0; i < FOG_LUT_SIZE; ++i) {
+    lut->weight[i] = (u8)(((i + 0.5f) / FOG_LUT_SIZE) * 255.0f + 0.5f);
+  }
+}
 
-    f32 fog_factor = (d - fog_start) * inv_range;
-    if (fog_factor <= 0.0f) continue;
-    if (fog_factor > 1.0f) fog_factor = 1.0f;
+void set_fog_lut(renderer_t *state, f32 fog_start, f32 fog_end, u8 fog_r, u8 fog_g, u8 fog_b) {
+  assert(state != NULL);
+  init_fog_lut(&state->fog_lut, fog_start, fog_end, fog_r, fog_g, fog_b);
+}
 
-    // Access the pixel as 4 separate bytes to avoid shift confusion
-    f32 inv_fog = 1.0f - fog_factor;
+u32 apply_fog_lut(const renderer_t *restrict state, u32 color, f32 depth) {
+  const fog_lut_t *lut = &state->fog_lut;
+  if (depth <= lut->start) return color;
+  if (depth >= lut->end) return lut->color;
 
-    u8 r, g, b;
-    u32_to_rgb(state->framebuffer[i], &r, &g, &b);
-    r = (u8)(r * inv_fog + fog_r * fog_factor);
-    g = (u8)(g * inv_fog + fog_g * fog_factor);
-    b = (u8)(b * inv_fog + fog_b * fog_factor);
+  int step = (int)((depth - lut->start) * lut->scale);
+  int w = lut->weight[step < FOG_LUT_SIZE ? step : FOG_LUT_SIZE - 1];
 
-    state->framebuffer[i] = rgb_to_u32(r, g, b);
+  u8 r, g, b;
+  u32_to_rgb(color, &r, &g, &b);
+  r = (u8)((r * (255 - w) + lut->r * w + 127) / 255);
+  g = (u8)((g * (255 - w) + lut->g * w + 127) / 255);
+  b = (u8)((b * (255 - w) + lut->b * w + 127) / 255);
+
+  return rgb_to_u32(r, g, b);
+}
+
+void set_dither_lut(renderer_t *state, f32 steps) {
+  assert(state != NULL);
+  assert(steps > 0.0f);
+
+  dither_lut_t *lut = &state->dither_lut;
+  lut->steps = steps;
+
+  // Same offset, quantization and clamp as apply_dither_u32, evaluated once per input value
+  f32 steps_inv = 1.0f / steps;
+  for (int parity = 0; parity < 2; ++parity) {
+    f32 dither = parity ? 0.05f : -0.05f;
+
+    for (int v = 0; v < 256; ++v) {
+      f32 q = floorf((v / 255.0f + dither) * steps) * steps_inv;
+      lut->table[parity][v] = (u8)(fmaxf(0.0f, fminf(1.0f, q)) * 255.0f);
+    }
   }
 }
 
+u32 apply_dither_lut(const renderer_t *restrict state, u32 color, int screen_x, int screen_y) {
+  if (color == 0x00000000) return 0x00000000;
+
+  const u8 *restrict table = state->dither_lut.table[(screen_x ^ screen_y) & 1];
+
+  u8 r, g, b;
+  u32_to_rgb(color, &r, &g, &b);
+  return rgb_to_u32(table[r], table[g], table[b]);
+}
+
 // Initialize renderer state
 void init_renderer(renderer_t *state, u32 width, u32 height, u32 atlas_width, u32 atlas_height, u32 *framebuffer, f32 *depthbuffer, u32 *skybox_buffer, f32 max_depth) {
   assert(state != NULL);
@@ -311,87 +491,118 @@ void init_renderer(renderer_t *state, u32 width, u32 height, u32 atlas_width, u3
   struct timespec ts;
   clock_gettime(CLOCK_MONOTONIC, &ts);
   state->start_time = ts.tv_sec * 1000 + ts.tv_nsec / 1000000; // milliseconds
-  state->wireframe_mode = false;
+  state->wireframe_mode = WIREFRAME_OFF;
+  state->wireframe_color = 0;
   state->texture_atlas = NULL;
+  state->texture_indices = NULL;
+  state->texture_palette = NULL;
+  state->texture_format = TEXTURE_FORMAT_DIRECT;
 
   state->cam_right = make_float3(0, 0, 0);
   state->cam_up = make_float3(0, 0, 0);
   state->cam_forward = make_float3(0, 0, 0);
+
+  state->shadow_map = NULL;
+  state->frame_arena = (arena_t){0};
+
+  // Without a usable depth range the fog table stays zeroed until the client sets one
+  state->fog_lut = (fog_lut_t){0};
+  if (max_depth > 0.0f) set_fog_lut(state, max_depth * 0.5f, max_depth, 0, 0, 0);
+  set_dither_lut(state, 8.0f);
 }
 
-// Update camera basis vectors and recalculate projection/culling math
-void update_camera(renderer_t *restrict state, transform_t *restrict cam) {
+void set_frame_arena(renderer_t *state, void *memory, usize size) {
   assert(state != NULL);
-  assert(cam != NULL);
 
-  transform_get_basis_vectors(cam, &state->cam_right, &state->cam_up, &state->cam_forward);
-  state->projection_scale = (float)state->screen_dim.y / state->screen_height_world;
-  state->frustum_bound = state->screen_height_world * 2.0f;
+  if (memory) init_arena_from(&state->frame_arena, memory, size);
+  else state->frame_arena = (arena_t){0};
 }
 
-bool render_triangle(triangle_context_t *restrict ctx) {
-  // Call vertex shader to get transformed vertices
-  float3 transformed_a, transformed_b, transformed_c;
-  apply_vertex_shader(ctx->model, ctx->vertex_shader, &ctx->vertex_ctx, ctx->tri, &transformed_a, &transformed_b, &transformed_c);
-
-  // Apply model scale (element-wise multiplication)
-  transformed_a.x *= ctx->model->scale.x;
-  transformed_a.y *= ctx->model->scale.y;
-  transformed_a.z *= ctx->model->scale.z;
-  transformed_b.x *= ctx->model->scale.x;
-  transformed_b.y *= ctx->model->scale.y;
-  transformed_b.z *= ctx->model->scale.z;
-  transformed_c.x *= ctx->model->scale.x;
-  transformed_c.y *= ctx->model->scale.y;
-  transformed_c.z *= ctx->model->scale.z;
+void begin_frame(renderer_t *state) {
+  assert(state != NULL);
+  arena_reset(&state->frame_arena);
+}
 
-  // Transform vertices from model space to world space, then to view space
-  float3 world_a = transform_to_world(&ctx->model->transform, transformed_a);
-  float3 world_b = transform_to_world(&ctx->model->transform, transformed_b);
-  float3 world_c = transform_to_world(&ctx->model->transform, transformed_c);
+void *frame_alloc(renderer_t *state, usize size) {
+  assert(state != NULL);
+  return arena_alloc(&state->frame_arena, size);
+}
 
-  float3 view_a = transform_to_local_point(ctx->cam, world_a);
-  float3 view_b = transform_to_local_point(ctx->cam, world_b);
-  float3 view_c = transform_to_local_point(ctx->cam, world_c);
+// Switch the renderer to a palettized texture atlas
+void set_texture_atlas_indexed(renderer_t *state, const u8 *indices, const u32 *palette, texture_format_t format) {
+  assert(state != NULL);
+  assert(format == TEXTURE_FORMAT_DIRECT || (indices != NULL && palette != NULL));
 
-  if (frustum_cull_triangle(view_a, view_b, view_c, ctx->frustum_bound, ctx->max_depth, ctx->model->disable_behind_camera_culling))
-    return false; // Triangle is outside the view frustum
+  state->texture_indices = indices;
+  state->texture_palette = palette;
+  state->texture_format = (u32)format;
+}
 
-  // Use pre-computed face normal for back-face culling
-  float3 model_normal = ctx->model->face_normals[ctx->tri];
+// Update camera basis vectors and recalculate projection/culling math
+void update_camera(renderer_t *restrict state, transform_t *restrict cam) {
+  assert(state != NULL);
+  assert(cam != NULL);
 
-  // Transform face normal from model space to world space (rotation only)
-  float3 ihat, jhat, khat;
-  transform_get_basis_vectors(&ctx->model->transform, &ihat, &jhat, &khat);
-  float3 triangle_normal = transform_vector(ihat, jhat, khat, model_normal);
+  transform_get_basis_vectors(cam, &state->cam_right, &state->cam_up, &state->cam_forward);
+  state->projection_scale = (float)state->screen_dim.y / state->screen_height_world;
+  state->frustum_bound = state->screen_height_world * 2.0f;
+}
 
-  // Vector from camera to triangle center
-  float3 triangle_center = float3_scale(float3_add(float3_add(world_a, world_b), world_c), 1.0f/3.0f);
-  float3 view_direction = float3_normalize(float3_sub(triangle_center, ctx->cam->position));  // Point from camera to triangle
+// A triangle corner in view and world space with its UV, carried through near plane clipping
+typedef struct {
+  float3 view, world;
+  float2 uv;
+} raster_vertex_t;
 
-  // Check if triangle is facing toward camera (skip back-face culling for particles)
-  if (!ctx->model->disable_behind_camera_culling) {
-    float dot_product = float3_dot(triangle_normal, view_direction);
-    if (dot_product < EPSILON) return false; // Triangle is facing away from camera
+// Atlas tile a triangle's UVs repeat inside, in texels, see model_t.atlas_tile_dim
+typedef struct {
+  bool enabled;
+  int x, y, w, h;
+} tile_wrap_t;
+
+// Clips a view space triangle to the near plane, interpolating world positions and UVs along cut edges
+// Returns the number of polygon corners written to out: 0 if nothing is left, 3, or 4 when one corner was cut off
+static int clip_triangle_near(const raster_vertex_t in[3], raster_vertex_t out[4]) {
+  int count = 0;
+  for (int i = 0; i < 3; ++i) {
+    const raster_vertex_t *cur = &in[i], *next = &in[(i + 1) % 3];
+    bool cur_inside = cur->view.z <= -NEAR_PLANE;
+    bool next_inside = next->view.z <= -NEAR_PLANE;
+
+    if (cur_inside) out[count++] = *cur;
+    if (cur_inside != next_inside) {
+      f32 t = (-NEAR_PLANE - cur->view.z) / (next->view.z - cur->view.z);
+      out[count].view = float3_lerp(cur->view, next->view, t);
+      out[count].view.z = -NEAR_PLANE;
+      out[count].world = float3_lerp(cur->world, next->world, t);
+      out[count].uv = make_float2(lerp(cur->uv.x, next->uv.x, t), lerp(cur->uv.y, next->uv.y, t));
+      ++count;
+    }
   }
 
+  return count;
+}
+
+// Shades one view space triangle into the frame, called once per triangle left after near plane clipping
+static void rasterize_triangle(triangle_context_t *restrict ctx, const raster_vertex_t *va, const raster_vertex_t *vb, const raster_vertex_t *vc,
+                               float3 triangle_normal, const tile_wrap_t *tile) {
   // Use pre-computed projection constants
-  float pixels_per_world_unit_a = ctx->state->projection_scale / view_a.z;
-  float pixels_per_world_unit_b = ctx->state->projection_scale / view_b.z;
-  float pixels_per_world_unit_c = ctx->state->projection_scale / view_c.z;
+  float pixels_per_world_unit_a = ctx->state->projection_scale / va->view.z;
+  float pixels_per_world_unit_b = ctx->state->projection_scale / vb->view.z;
+  float pixels_per_world_unit_c = ctx->state->projection_scale / vc->view.z;
 
-  float2 pixel_offset_a = float2_scale(make_float2(view_a.x, view_a.y), pixels_per_world_unit_a);
-  float2 pixel_offset_b = float2_scale(make_float2(view_b.x, view_b.y), pixels_per_world_unit_b);
-  float2 pixel_offset_c = float2_scale(make_float2(view_c.x, view_c.y), pixels_per_world_unit_c);
+  float2 pixel_offset_a = float2_scale(make_float2(va->view.x, va->view.y), pixels_per_world_unit_a);
+  float2 pixel_offset_b = float2_scale(make_float2(vb->view.x, vb->view.y), pixels_per_world_unit_b);
+  float2 pixel_offset_c = float2_scale(make_float2(vc->view.x, vc->view.y), pixels_per_world_unit_c);
 
   float2 screen_a = float2_add(float2_scale(ctx->state->screen_dim, 0.5f), pixel_offset_a);
   float2 screen_b = float2_add(float2_scale(ctx->state->screen_dim, 0.5f), pixel_offset_b);
   float2 screen_c = float2_add(float2_scale(ctx->state->screen_dim, 0.5f), pixel_offset_c);
 
   // triangle points in screen space, with their associated depth
-  float3 a = make_float3(screen_a.x, screen_a.y, view_a.z);
-  float3 b = make_float3(screen_b.x, screen_b.y, view_b.z);
-  float3 c = make_float3(screen_c.x, screen_c.y, view_c.z);
+  float3 a = make_float3(screen_a.x, screen_a.y, va->view.z);
+  float3 b = make_float3(screen_b.x, screen_b.y, vb->view.z);
+  float3 c = make_float3(screen_c.x, screen_c.y, vc->view.z);
 
   // Compute triangle bounding box (clamped to screen boundaries)
   float min_x = fmaxf(0.0f, floorf(fminf(a.x, fminf(b.x, c.x))));
@@ -399,22 +610,21 @@ bool render_triangle(triangle_context_t *restrict ctx) {
   float min_y = fmaxf(0.0f, floorf(fminf(a.y, fminf(b.y, c.y))));
   float max_y = fminf(ctx->state->screen_dim.y - 1, ceilf(fmaxf(a.y, fmaxf(b.y, c.y))));
 
-  // Get the UV coordinates for the current triangle's vertices (cache-friendly access)
-  float2 uv_a = ctx->model->vertex_data[ctx->tri * 3 + 0].uv;
-  float2 uv_b = ctx->model->vertex_data[ctx->tri * 3 + 1].uv;
-  float2 uv_c = ctx->model->vertex_data[ctx->tri * 3 + 2].uv;
-
   // Perspective-correct UVs: Pre-divide UVs by their respective 1/w (with epsilon to prevent divide by zero)
   float safe_a_z = (fabsf(a.z) < EPSILON) ? (a.z < 0 ? -EPSILON : EPSILON) : a.z;
   float safe_b_z = (fabsf(b.z) < EPSILON) ? (b.z < 0 ? -EPSILON : EPSILON) : b.z;
   float safe_c_z = (fabsf(c.z) < EPSILON) ? (c.z < 0 ? -EPSILON : EPSILON) : c.z;
 
-  float2 uv_a_prime = float2_divide(uv_a, safe_a_z);
-  float2 uv_b_prime = float2_divide(uv_b, safe_b_z);
-  float2 uv_c_prime = float2_divide(uv_c, safe_c_z);
+  float2 uv_a_prime = float2_divide(va->uv, safe_a_z);
+  float2 uv_b_prime = float2_divide(vb->uv, safe_b_z);
+  float2 uv_c_prime = float2_divide(vc->uv, safe_c_z);
 
   ctx->frag_ctx.normal = triangle_normal;
 
+  // Baked colors take the place of the atlas, see bake_shading_cache
+  const shading_cache_t *cache = ctx->model->shading_cache.texels ? &ctx->model->shading_cache : NULL;
+  bool use_atlas = !cache && ctx->model->use_textures && has_texture_atlas(ctx->state);
+
   // Rasterize only within the computed bounding box
   for (int y = (int)min_y; y <= (int)max_y; ++y) {
     int pixel_base = y * (int)ctx->state->screen_dim.x; // Precompute row offset
@@ -431,20 +641,7 @@ bool render_triangle(triangle_context_t *restrict ctx) {
         if (new_depth < ctx->state->depthbuffer[pixel_idx]) {
           uint32_t output_color;
 
-          if (ctx->state->wireframe_mode) {
-            // Always update depth buffer for entire triangle to block back faces
-            ctx->state->depthbuffer[pixel_idx] = new_depth;
-
-            // Only draw visible pixels at triangle edges
-            if (weights.x < 0.02f || weights.y < 0.02f || weights.z < 0.02f) {
-              output_color = 0x0000; // Black for wireframe edges
-              ctx->state->framebuffer[pixel_idx] = output_color; // Draw the edge pixel
-            }
-            continue;
-          }
-
-          // Normal shaded rendering path
-          if (ctx->model->use_textures && ctx->state->texture_atlas != NULL) {
+          if (cache || use_atlas) {
             // Interpolate perspective-corrected UVs using floating point (simpler and faster)
             float interpolated_u_prime = weights.x * uv_a_prime.x + weights.y * uv_b_prime.x + weights.z * uv_c_prime.x;
             float interpolated_v_prime = weights.x * uv_a_prime.y + weights.y * uv_b_prime.y + weights.z * uv_c_prime.y;
@@ -453,36 +650,47 @@ bool render_triangle(triangle_context_t *restrict ctx) {
             float final_u = interpolated_u_prime * -new_depth;
             float final_v = interpolated_v_prime * -new_depth;
 
-            // Map normalized UVs [0.0, 1.0] to texture pixel coordinates (optimized)
-            int tex_x = (int)(final_u * (f32)ctx->state->atlas_dim.x);
-            int tex_y = (int)(final_v * (f32)ctx->state->atlas_dim.y);
-
-            // Fast clamp using bit operations and conditionals
-            tex_x = (tex_x < 0) ? 0 : ((tex_x > ctx->state->atlas_dim.x - 1) ? ctx->state->atlas_dim.x - 1 : tex_x);
-            tex_y = (tex_y < 0) ? 0 : ((tex_y > ctx->state->atlas_dim.y - 1) ? ctx->state->atlas_dim.y - 1 : tex_y);
-
-            output_color = ctx->state->texture_atlas[tex_y * (int)ctx->state->atlas_dim.x + tex_x];
+            if (cache) {
+              output_color = sample_shading_cache(cache, final_u, final_v);
+            } else {
+              // Map normalized UVs [0.0, 1.0] to texture pixel coordinates (optimized)
+              int tex_x = (int)(final_u * (f32)ctx->state->atlas_dim.x);
+              int tex_y = (int)(final_v * (f32)ctx->state->atlas_dim.y);
+
+              if (tile->enabled) {
+                tex_x = (int)floorf(final_u * (f32)ctx->state->atlas_dim.x) - tile->x;
+                tex_y = (int)floorf(final_v * (f32)ctx->state->atlas_dim.y) - tile->y;
+                tex_x = tile->x + ((tex_x % tile->w) + tile->w) % tile->w;
+                tex_y = tile->y + ((tex_y % tile->h) + tile->h) % tile->h;
+              }
+
+              // Fast clamp using bit operations and conditionals
+              tex_x = (tex_x < 0) ? 0 : ((tex_x > ctx->state->atlas_dim.x - 1) ? ctx->state->atlas_dim.x - 1 : tex_x);
+              tex_y = (tex_y < 0) ? 0 : ((tex_y > ctx->state->atlas_dim.y - 1) ? ctx->state->atlas_dim.y - 1 : tex_y);
+
+              output_color = sample_texture_atlas(ctx->state, tex_x, tex_y);
+            }
           } else {
-            output_color = ctx->model->flat_color; // Use flat color if no texture
+            output_color = ctx->instance ? ctx->instance->color : ctx->model->flat_color; // Use flat color if no texture
           }
 
           // Interpolate world position using barycentric coordinates
           ctx->frag_ctx.world_pos = float3_add(
             float3_add(
-              float3_scale(world_a, weights.x),
-              float3_scale(world_b, weights.y)
+              float3_scale(va->world, weights.x),
+              float3_scale(vb->world, weights.y)
             ),
-            float3_scale(world_c, weights.z)
+            float3_scale(vc->world, weights.z)
           );
 
           // Screen position
           ctx->frag_ctx.screen_pos = make_float2(x + 0.5f, y + 0.5f);
 
           // UV coordinates (interpolated if available) - reuse already fetched UVs
-          if (ctx->model->use_textures && ctx->model->vertex_data != NULL) {
+          if ((ctx->model->use_textures || cache) && ctx->model->vertex_data != NULL) {
             ctx->frag_ctx.uv = make_float2(
-              weights.x * uv_a.x + weights.y * uv_b.x + weights.z * uv_c.x,
-              weights.x * uv_a.y + weights.y * uv_b.y + weights.z * uv_c.y
+              weights.x * va->uv.x + weights.y * vb->uv.x + weights.z * vc->uv.x,
+              weights.x * va->uv.y + weights.y * vb->uv.y + weights.z * vc->uv.y
             );
           } else {
             ctx->frag_ctx.uv = make_float2(0.0f, 0.0f);
@@ -499,10 +707,107 @@ bool render_triangle(triangle_context_t *restrict ctx) {
           ctx->state->framebuffer[pixel_idx] = output_color; // Draw the pixel
           ctx->state->depthbuffer[pixel_idx] = new_depth; // Update depth buffer
         }
+      }
+    }
+  }
+}
+
+bool render_triangle(triangle_context_t *restrict ctx) {
+  // Call vertex shader to get transformed vertices
+  float3 transformed_a, transformed_b, transformed_c;
+  apply_vertex_shader(ctx->model, ctx->vertex_shader, &ctx->vertex_ctx, ctx->tri, &transformed_a, &transformed_b, &transformed_c);
+
+  // Apply model scale (element-wise multiplication)
+  transformed_a.x *= ctx->model->scale.x;
+  transformed_a.y *= ctx->model->scale.y;
+  transformed_a.z *= ctx->model->scale.z;
+  transformed_b.x *= ctx->model->scale.x;
+  transformed_b.y *= ctx->model->scale.y;
+  transformed_b.z *= ctx->model->scale.z;
+  transformed_c.x *= ctx->model->scale.x;
+  transformed_c.y *= ctx->model->scale.y;
+  transformed_c.z *= ctx->model->scale.z;
 
+  // Transform vertices from model space to world space with the placement's cached basis, then to view space
+  float3 world_a = float3_add(transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, transformed_a), ctx->transform->position);
+  float3 world_b = float3_add(transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, transformed_b), ctx->transform->position);
+  float3 world_c = float3_add(transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, transformed_c), ctx->transform->position);
+
+  float3 view_a = transform_to_local_point(ctx->cam, world_a);
+  float3 view_b = transform_to_local_point(ctx->cam, world_b);
+  float3 view_c = transform_to_local_point(ctx->cam, world_c);
+
+  if (frustum_cull_triangle(view_a, view_b, view_c, ctx->frustum_bound, ctx->max_depth, ctx->model->disable_behind_camera_culling))
+    return false; // Triangle is outside the view frustum
+
+  // Use pre-computed face normal for back-face culling
+  float3 model_normal = ctx->model->face_normals[ctx->tri];
+
+  // Transform face normal from model space to world space (rotation only)
+  float3 triangle_normal = transform_vector(ctx->model_ihat, ctx->model_jhat, ctx->model_khat, model_normal);
+
+  // Vector from camera to triangle center
+  float3 triangle_center = float3_scale(float3_add(float3_add(world_a, world_b), world_c), 1.0f/3.0f);
+  float3 view_direction = float3_normalize(float3_sub(triangle_center, ctx->cam->position));  // Point from camera to triangle
+
+  // Check if triangle is facing toward camera (skip back-face culling for particles)
+  if (!ctx->model->disable_behind_camera_culling) {
+    float dot_product = float3_dot(triangle_normal, view_direction);
+    if (dot_product < EPSILON) return false; // Triangle is facing away from camera
+  }
+
+  // Get the UV coordinates for the current triangle's vertices (cache-friendly access)
+  float2 uv_a = ctx->model->vertex_data[ctx->tri * 3 + 0].uv;
+  float2 uv_b = ctx->model->vertex_data[ctx->tri * 3 + 1].uv;
+  float2 uv_c = ctx->model->vertex_data[ctx->tri * 3 + 2].uv;
+
+  // Instances shift the shared UVs, e.g. onto their own atlas tile
+  if (ctx->instance) {
+    uv_a = float2_add(uv_a, ctx->instance->uv_offset);
+    uv_b = float2_add(uv_b, ctx->instance->uv_offset);
+    uv_c = float2_add(uv_c, ctx->instance->uv_offset);
+  }
+
+  // Tiled UVs repeat one atlas tile, found from the whole triangle's smallest UV before clipping, in whole texels
+  tile_wrap_t tile = { ctx->model->atlas_tile_dim.x > 0.0f && ctx->model->atlas_tile_dim.y > 0.0f, 0, 0, 1, 1 };
+  if (tile.enabled) {
+    float2 tile_dim = ctx->model->atlas_tile_dim;
+    tile.w = (int)fmaxf(1.0f, roundf(tile_dim.x * ctx->state->atlas_dim.x));
+    tile.h = (int)fmaxf(1.0f, roundf(tile_dim.y * ctx->state->atlas_dim.y));
+    tile.x = (int)floorf(fminf(uv_a.x, fminf(uv_b.x, uv_c.x)) / tile_dim.x + 1e-3f) * tile.w;
+    tile.y = (int)floorf(fminf(uv_a.y, fminf(uv_b.y, uv_c.y)) / tile_dim.y + 1e-3f) * tile.h;
+  }
+
+  // Triangles reaching behind the camera are clipped rather than dropped, large faces close to the camera stay whole
+  raster_vertex_t corners[3] = { { view_a, world_a, uv_a }, { view_b, world_b, uv_b }, { view_c, world_c, uv_c } };
+  raster_vertex_t poly[4];
+  int poly_count = clip_triangle_near(corners, poly);
+  if (poly_count < 3) return false;
+
+  if (ctx->state->wireframe_mode != WIREFRAME_OFF) {
+    if (ctx->depth_only) {
+      for (int i = 1; i + 1 < poly_count; ++i) {
+        float3 sa = project_to_screen(ctx->state, poly[0].view);
+        float3 sb = project_to_screen(ctx->state, poly[i].view);
+        float3 sc = project_to_screen(ctx->state, poly[i + 1].view);
+        sa.z = 1.0f / sa.z; sb.z = 1.0f / sb.z; sc.z = 1.0f / sc.z;
+
+        fill_triangle_depth(ctx->state->depthbuffer, (int)ctx->state->screen_dim.x, (int)ctx->state->screen_dim.y, sa, sb, sc, true);
       }
+      return true;
     }
+
+    u32 color = ctx->state->wireframe_color;
+    draw_edge(ctx->state, view_a, view_b, color);
+    draw_edge(ctx->state, view_b, view_c, color);
+    draw_edge(ctx->state, view_c, view_a, color);
+    return true;
   }
+
+  for (int i = 1; i + 1 < poly_count; ++i)
+    rasterize_triangle(ctx, &poly[0], &poly[i], &poly[i + 1], triangle_normal, &tile);
+
+  return true;
 }
 
 // Renders a single point in 3D space, applying transformations, projection, frustum culling, and depth testing.
@@ -540,12 +845,38 @@ bool render_point(renderer_t *restrict state, transform_t *restrict cam, float3
   return false; // Point was occluded by something closer
 }
 
-/**
-* Renders a 3D model onto a 2D buffer using a basic rasterization pipeline.
-* Applies transformations, projects vertices to screen space, performs simple frustum culling,
-* back-face culling, and rasterizes triangles with depth testing.
-*/
-usize render_model(renderer_t *restrict state, transform_t *restrict cam, model_t *restrict model, light_t *restrict lights, usize light_count) {
+// parallel_for callback, renders triangles [begin, end) with a private copy of the shared context
+static usize render_triangle_range(void *arg, int begin, int end) {
+  triangle_context_t ctx = *(triangle_context_t *)arg;
+  usize tris_rendered = 0;
+
+  for (int tri = begin; tri < end; ++tri) {
+    ctx.tri = tri;
+    if (render_triangle(&ctx)) {
+      tris_rendered++;
+    }
+  }
+
+  return tris_rendered;
+}
+
+// Renders triangles [0, total_triangles) of base_ctx's model, spread across worker threads when enabled
+// Returns the number of triangles rendered
+static usize dispatch_triangles(triangle_context_t *restrict base_ctx, int total_triangles) {
+  return parallel_for(total_triangles, 1, render_triangle_range, base_ctx);
+}
+
+// Points a triangle context at a model placement, caching the placement's basis vectors
+static void bind_placement(triangle_context_t *restrict ctx, const transform_t *transform, const instance_data_t *instance) {
+  ctx->transform = transform;
+  ctx->instance = instance;
+  ctx->vertex_ctx.instance = instance;
+  ctx->frag_ctx.instance = instance;
+  transform_get_basis_vectors(transform, &ctx->model_ihat, &ctx->model_jhat, &ctx->model_khat);
+}
+
+// Validates a model and builds the context its triangles are rendered with, shared by render_model and render_model_instanced
+static triangle_context_t make_triangle_context(renderer_t *restrict state, transform_t *restrict cam, model_t *restrict model, light_t *restrict lights, usize light_count) {
   assert(cam != NULL);
   assert(model != NULL);
   assert(model->vertex_data != NULL);
@@ -558,11 +889,10 @@ usize render_model(renderer_t *restrict state, transform_t *restrict cam, model_
   assert(vertex_shader->func != NULL);
 
   if (model->use_textures) {
-    assert(state->texture_atlas != NULL);
+    assert(has_texture_atlas(state));
     assert(model->vertex_data != NULL); // Ensure we have vertex data with UVs
   }
 
-  usize tris_rendered = 0;
   struct timespec ts;
   clock_gettime(CLOCK_MONOTONIC, &ts);
   u64 current_time = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
@@ -584,33 +914,9 @@ usize render_model(renderer_t *restrict state, transform_t *restrict cam, model_
   frag_ctx.time = state->time;
   frag_ctx.light = lights;
   frag_ctx.light_count = light_count;
+  frag_ctx.shadow_map = state->shadow_map;
 
-  int total_triangles = model->num_vertices / 3;
-
-#ifdef SHADER_WORKS_USE_PTHREADS
-  // Get number of CPU cores (cross-platform)
-  int num_threads = 4; // Default fallback
-
-#ifdef _WIN32
-  SYSTEM_INFO sysinfo;
-  GetSystemInfo(&sysinfo);
-  num_threads = (int)sysinfo.dwNumberOfProcessors;
-#elif defined(_SC_NPROCESSORS_ONLN)
-  // POSIX systems (Linux, macOS)
-  num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
-#endif
-
-  if (num_threads <= 0) num_threads = 4; // Safety fallback
-
-  pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
-  worker_thread_data_t* thread_data = malloc(num_threads * sizeof(worker_thread_data_t));
-  usize* thread_counts = malloc(num_threads * sizeof(usize));
-
-  // Shared atomic counter for work distribution
-  int next_triangle = 0;
-
-  // Create base thread context
-  triangle_context_t base_ctx = {
+  triangle_context_t ctx = {
     .state = state,
     .model = model,
     .cam = cam,
@@ -624,48 +930,252 @@ usize render_model(renderer_t *restrict state, transform_t *restrict cam, model_
     .max_depth = state->max_depth
   };
 
-  // Launch worker threads
-  for (int t = 0; t < num_threads; t++) {
-    thread_data[t].base_ctx = base_ctx;
-    thread_data[t].total_triangles = total_triangles;
-    thread_data[t].next_triangle = &next_triangle;
-    thread_data[t].triangles_rendered = &thread_counts[t];
-    thread_counts[t] = 0;
+  // Custom vertex shaders may move vertices anywhere, so only models drawn with the default one trust their bounds
+  ctx.cull_bounds = model->bounds_radius > 0.0f && vertex_shader->func == default_vertex_shader.func;
+
+  bind_placement(&ctx, &model->transform, NULL);
+  return ctx;
+}
 
-    pthread_create(&threads[t], NULL, worker_thread, &thread_data[t]);
+/**
+* Renders a 3D model onto a 2D buffer using a basic rasterization pipeline.
+* Applies transformations, projects vertices to screen space, performs simple frustum culling,
+* back-face culling, and rasterizes triangles with depth testing.
+*/
+usize render_model(renderer_t *restrict state, transform_t *restrict cam, model_t *restrict model, light_t *restrict lights, usize light_count) {
+  triangle_context_t base_ctx = make_triangle_context(state, cam, model, lights, light_count);
+  int total_triangles = model->num_vertices / 3;
+
+  if (base_ctx.cull_bounds && frustum_cull_bounds(&base_ctx)) return 0; // Whole model is off screen
+
+  // Models with simplified levels draw the one matching their size on screen, see generate_model_lods
+  model_t lod_model;
+  if (model->num_lods > 0) {
+    select_model_lod(model, get_screen_radius(&base_ctx), &lod_model);
+    base_ctx.model = &lod_model;
+    total_triangles = lod_model.num_vertices / 3;
   }
 
-  // Wait for all threads to complete
-  for (int t = 0; t < num_threads; t++) {
-    pthread_join(threads[t], NULL);
-    tris_rendered += thread_counts[t];
+  // Hidden-line wireframe: lay down the model's depth first so the edge pass can be depth tested against it
+  if (state->wireframe_mode == WIREFRAME_HIDDEN_LINE) {
+    base_ctx.depth_only = true;
+    dispatch_triangles(&base_ctx, total_triangles);
+    base_ctx.depth_only = false;
   }
 
-  free(threads);
-  free(thread_data);
-  free(thread_counts);
-
-#else
-  // Single-threaded fallback
-  for (int tri = 0; tri < total_triangles; ++tri) {
-    if (render_triangle(&(triangle_context_t){
-      .state = state,
-      .model = model,
-      .cam = cam,
-      .lights = lights,
-      .light_count = light_count,
-      .tri = tri,
-      .vertex_shader = vertex_shader,
-      .frag_shader = frag_shader,
-      .vertex_ctx = vertex_ctx,
-      .frag_ctx = frag_ctx,
-      .frustum_bound = state->frustum_bound,
-      .max_depth = state->max_depth
-    })) {
-      tris_rendered++;
+  return dispatch_triangles(&base_ctx, total_triangles);
+}
+
+// Instances claimed per batch, enough to amortize the claim when each one is only a handful of triangles
+#define INSTANCE_BATCH_SIZE 16
+
+typedef struct {
+  triangle_context_t base;
+  const model_instance_t *instances;
+  int triangles_per_instance;
+} instanced_context_t;
+
+// parallel_for callback, renders every triangle of instances [begin, end) with a private copy of the shared context
+static usize render_instance_range(void *arg, int begin, int end) {
+  const instanced_context_t *batch = (const instanced_context_t *)arg;
+  triangle_context_t ctx = batch->base;
+  usize tris_rendered = 0;
+
+  for (int i = begin; i < end; ++i) {
+    bind_placement(&ctx, &batch->instances[i].transform, &batch->instances[i].data);
+    if (ctx.cull_bounds && frustum_cull_bounds(&ctx)) continue; // Whole instance is off screen
+
+    for (int tri = 0; tri < batch->triangles_per_instance; ++tri) {
+      ctx.tri = tri;
+      if (render_triangle(&ctx)) {
+        tris_rendered++;
+      }
     }
   }
-#endif
 
   return tris_rendered;
 }
+
+// Renders every instance of a shared model in one submission, threads split the instance list rather than each tiny model
+usize render_model_instanced(renderer_t *restrict state, transform_t *restrict cam, model_t *restrict model, const model_instance_t *restrict instances, usize instance_count, light_t *restrict lights, usize light_count) {
+  assert(instances != NULL || instance_count == 0);
+
+  instanced_context_t batch = {
+    .base = make_triangle_context(state, cam, model, lights, light_count),
+    .instances = instances,
+    .triangles_per_instance = model->num_vertices / 3,
+  };
+
+  // Hidden-line wireframe: every instance's depth goes down first so edges are hidden by neighbouring instances too
+  if (state->wireframe_mode == WIREFRAME_HIDDEN_LINE) {
+    batch.base.depth_only = true;
+    parallel_for((int)instance_count, INSTANCE_BATCH_SIZE, render_instance_range, &batch);
+    batch.base.depth_only = false;
+  }
+
+  return parallel_for((int)instance_count, INSTANCE_BATCH_SIZE, render_instance_range, &batch);
+}
+
+typedef struct {
+  shadow_map_t *map;
+  model_t *model;
+  vertex_shader_t *vertex_shader;
+  vertex_context_t vertex_ctx;
+  float3 model_ihat, model_jhat, model_khat;
+} shadow_context_t;
+
+// Orthographic projection into the shadow map, depth is the distance along the light from the map's centre
+static inline float3 project_to_shadow_map(const shadow_map_t *restrict map, float3 world) {
+  float3 rel = float3_sub(world, map->center);
+  f32 half = (f32)map->size * 0.5f;
+  return make_float3(half + float3_dot(rel, map->right) * map->texels_per_unit,
+                     half - float3_dot(rel, map->up) * map->texels_per_unit,
+                     float3_dot(rel, map->forward));
+}
+
+// parallel_for callback, rasterizes the depth of triangles [begin, end) with a private copy of the shared context
+static usize render_shadow_range(void *arg, int begin, int end) {
+  shadow_context_t ctx = *(shadow_context_t *)arg;
+  const model_t *model = ctx.model;
+  usize tris_rendered = 0;
+
+  for (int tri = begin; tri < end; ++tri) {
+    float3 p[3];
+    apply_vertex_shader(ctx.model, ctx.vertex_shader, &ctx.vertex_ctx, tri, &p[0], &p[1], &p[2]);
+
+    for (int i = 0; i < 3; ++i) {
+      p[i] = make_float3(p[i].x * model->scale.x, p[i].y * model->scale.y, p[i].z * model->scale.z);
+      p[i] = float3_add(transform_vector(ctx.model_ihat, ctx.model_jhat, ctx.model_khat, p[i]), model->transform.position);
+      p[i] = project_to_shadow_map(ctx.map, p[i]);
+    }
+
+    // Same fill as the hidden-line pre-pass, with depth interpolated linearly since the projection is orthographic
+    fill_triangle_depth(ctx.map->depth, (int)ctx.map->size, (int)ctx.map->size, p[0], p[1], p[2], false);
+    tris_rendered++;
+  }
+
+  return tris_rendered;
+}
+
+usize render_model_shadow(renderer_t *restrict state, shadow_map_t *restrict map, model_t *restrict model) {
+  assert(state != NULL);
+  assert(map != NULL && map->depth != NULL);
+  assert(model != NULL && model->vertex_data != NULL);
+  assert(model->num_vertices % 3 == 0);
+
+  vertex_shader_t *vertex_shader = model->vertex_shader && model->vertex_shader->valid ? model->vertex_shader : &default_vertex_shader;
+
+  shadow_context_t ctx = {
+    .map = map,
+    .model = model,
+    .vertex_shader = vertex_shader,
+    .vertex_ctx = {
+      .cam_position = map->center,
+      .cam_forward = map->forward,
+      .cam_right = map->right,
+      .cam_up = map->up,
+      .screen_dim = make_float2((f32)map->size, (f32)map->size),
+      .time = state->time,
+    },
+  };
+  transform_get_basis_vectors(&model->transform, &ctx.model_ihat, &ctx.model_jhat, &ctx.model_khat);
+
+  // Skip models whose bounding sphere misses the map's square, only trusted with the default vertex shader
+  if (model->bounds_radius > 0.0f && vertex_shader->func == default_vertex_shader.func) {
+    float3 scale = model->scale;
+    f32 radius = model->bounds_radius * fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+    float3 center = make_float3(model->bounds_center.x * scale.x, model->bounds_center.y * scale.y, model->bounds_center.z * scale.z);
+    center = float3_add(transform_vector(ctx.model_ihat, ctx.model_jhat, ctx.model_khat, center), model->transform.position);
+
+    float3 rel = float3_sub(center, map->center);
+    if (fabsf(float3_dot(rel, map->right)) > map->extent + radius || fabsf(float3_dot(rel, map->up)) > map->extent + radius) return 0;
+  }
+
+  return parallel_for((int)(model->num_vertices / 3), 1, render_shadow_range, &ctx);
+}
+
+// Polynomial atan2, max error around 1e-5 radians, well below a texel of any practical panorama
+static inline f32 fast_atan2f(f32 y, f32 x) {
+  f32 ax = fabsf(x), ay = fabsf(y);
+  f32 a = fminf(ax, ay) / (fmaxf(ax, ay) + 1e-20f);
+  f32 s = a * a;
+  f32 r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+
+  if (ay > ax) r = 1.57079637f - r;
+  if (x < 0) r = PI - r;
+  if (y < 0) r = -r;
+  return r;
+}
+
+typedef struct {
+  renderer_t *state;
+  const skybox_shader_args_t *sky;
+  f32 sky_depth;
+  float3 row_start; // view ray through the center of pixel (0, 0)
+  float3 step_x;    // change in view ray per pixel to the right
+  float3 step_y;    // change in view ray per pixel down
+} skybox_pass_t;
+
+// parallel_for callback, fills the clear pixels of rows [begin, end) with the panorama
+static usize render_skybox_rows(void *arg, int begin, int end) {
+  const skybox_pass_t *pass = (const skybox_pass_t *)arg;
+  renderer_t *state = pass->state;
+  const skybox_shader_args_t *sky = pass->sky;
+  int width = state->screen_dim.x;
+  f32 max_depth = state->max_depth;
+  f32 u_scale = (sky->width - 1) / (2.0f * PI);
+  f32 v_scale = (sky->height - 1) / PI;
+  usize filled = 0;
+
+  for (int y = begin; y < end; ++y) {
+    u32 *restrict color_row = state->framebuffer + y * width;
+    f32 *restrict depth_row = state->depthbuffer + y * width;
+    float3 dir = float3_add(pass->row_start, float3_scale(pass->step_y, (f32)y));
+
+    for (int x = 0; x < width; ++x, dir.x += pass->step_x.x, dir.y += pass->step_x.y, dir.z += pass->step_x.z) {
+      if (depth_row[x] < max_depth) continue; // covered by geometry
+
+      // Equirectangular lookup: u follows the heading around +Y, v runs from straight up (0) to straight down (1)
+      f32 heading = fast_atan2f(dir.z, dir.x);
+      f32 elevation = fast_atan2f(sqrtf(dir.x * dir.x + dir.z * dir.z), dir.y);
+
+      int tex_x = (int)((heading + PI) * u_scale);
+      int tex_y = (int)(elevation * v_scale);
+      if (tex_x < 0) tex_x = 0;
+      if (tex_x >= (int)sky->width) tex_x = sky->width - 1;
+      if (tex_y < 0) tex_y = 0;
+      if (tex_y >= (int)sky->height) tex_y = sky->height - 1;
+
+      color_row[x] = sky->skybox_buffer[tex_y * sky->width + tex_x];
+      depth_row[x] = pass->sky_depth;
+      filled++;
+    }
+  }
+
+  return filled;
+}
+
+// Fills every pixel still at clear depth with the panorama seen along its view ray, rather than rasterizing a sky sphere
+usize render_skybox(renderer_t *restrict state, const skybox_shader_args_t *restrict sky, f32 sky_depth) {
+  assert(state != NULL);
+  assert(sky != NULL);
+  assert(sky->skybox_buffer != NULL);
+  assert(sky->width > 0 && sky->height > 0);
+
+  // Inverse of project_to_screen on the view plane z = -1, mapped to world space through the camera basis
+  f32 inv_scale = 1.0f / state->projection_scale;
+  f32 half_w = state->screen_dim.x / 2.0f;
+  f32 half_h = state->screen_dim.y / 2.0f;
+
+  skybox_pass_t pass = {
+    .state = state,
+    .sky = sky,
+    .sky_depth = sky_depth,
+    .step_x = float3_scale(state->cam_right, -inv_scale),
+    .step_y = float3_scale(state->cam_up, -inv_scale),
+  };
+  pass.row_start = float3_add(float3_add(float3_scale(pass.step_x, 0.5f - half_w), float3_scale(pass.step_y, 0.5f - half_h)),
+                              float3_scale(state->cam_forward, -1.0f));
+
+  return parallel_for(state->screen_dim.y, 8, render_skybox_rows, &pass);
+}
@@ -0,0 +1,128 @@
+#include <shader-works/shading_cache.h>
+#include <shader-works/renderer.h>
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Shade every texel whose center lies inside one triangle of UV space
+static void bake_triangle(shading_cache_t *restrict cache, u8 *restrict covered, const fragment_shader_t *restrict shader,
+                          u32 input, const float2 uv[3], const float3 world[3], float3 normal) {
+  float w = (float)cache->width, h = (float)cache->height;
+  float2 a = make_float2(uv[0].x * w, uv[0].y * h);
+  float2 b = make_float2(uv[1].x * w, uv[1].y * h);
+  float2 c = make_float2(uv[2].x * w, uv[2].y * h);
+
+  float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+  if (fabsf(area) < EPSILON) return; // degenerate in UV space, nothing maps onto it
+  float inv_area = 1.0f / area;
+
+  int min_x = (int)fmaxf(0.0f, floorf(fminf(a.x, fminf(b.x, c.x))));
+  int max_x = (int)fminf(w - 1.0f, ceilf(fmaxf(a.x, fmaxf(b.x, c.x))));
+  int min_y = (int)fmaxf(0.0f, floorf(fminf(a.y, fminf(b.y, c.y))));
+  int max_y = (int)fminf(h - 1.0f, ceilf(fmaxf(a.y, fmaxf(b.y, c.y))));
+
+  fragment_context_t frag_ctx = { .normal = normal };
+
+  for (int y = min_y; y <= max_y; ++y) {
+    for (int x = min_x; x <= max_x; ++x) {
+      float px = x + 0.5f, py = y + 0.5f;
+
+      // Barycentric weights, a small tolerance keeps texels on shared edges from falling between triangles
+      float wa = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inv_area;
+      float wb = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inv_area;
+      float wc = 1.0f - wa - wb;
+      if (wa < -1e-5f || wb < -1e-5f || wc < -1e-5f) continue;
+
+      frag_ctx.world_pos = float3_add(float3_add(float3_scale(world[0], wa), float3_scale(world[1], wb)), float3_scale(world[2], wc));
+      frag_ctx.uv = make_float2(px / w, py / h);
+      frag_ctx.screen_pos = make_float2(px, py);
+
+      usize i = (usize)y * cache->width + (usize)x;
+      cache->texels[i] = shader->func(input, &frag_ctx, shader->argv, shader->argc);
+      covered[i] = 1;
+    }
+  }
+}
+
+int bake_shading_cache(model_t *model, const fragment_shader_t *shader, u32 width, u32 height) {
+  assert(model != NULL);
+  assert(model->vertex_data != NULL);
+  assert(shader != NULL && shader->func != NULL);
+  assert(width > 0 && height > 0);
+
+  free_shading_cache(model);
+
+  // Texels from the model's arena when it has room, the coverage mask is a temporary released right after
+  usize count = (usize)width * height;
+  usize start = arena_mark(model->arena);
+  shading_cache_t cache = { .texels = arena_alloc(model->arena, count * sizeof(u32)), .width = width, .height = height };
+  if (!cache.texels) cache.texels = sw_alloc(count * sizeof(u32), SW_MEMORY_TEXTURES);
+
+  usize mark = arena_mark(model->arena);
+  u8 *covered = arena_alloc(model->arena, count);
+  if (covered) memset(covered, 0, count);
+  else covered = sw_calloc(count, 1, SW_MEMORY_SCRATCH);
+
+  if (!cache.texels || !covered) {
+    if (!arena_contains(model->arena, cache.texels)) sw_free(cache.texels);
+    if (!arena_contains(model->arena, covered)) sw_free(covered);
+    arena_release(model->arena, start);
+    return -1;
+  }
+
+  for (usize i = 0; i < count; ++i) cache.texels[i] = model->flat_color;
+
+  // Same model to world placement as render_model, without the vertex shader
+  float3 ihat, jhat, khat;
+  transform_get_basis_vectors(&model->transform, &ihat, &jhat, &khat);
+
+  for (usize tri = 0; tri < model->num_faces; ++tri) {
+    float2 uv[3];
+    float3 world[3];
+
+    for (int v = 0; v < 3; ++v) {
+      const vertex_data_t *vertex = &model->vertex_data[tri * 3 + v];
+      float3 p = make_float3(vertex->position.x * model->scale.x, vertex->position.y * model->scale.y, vertex->position.z * model->scale.z);
+
+      uv[v] = vertex->uv;
+      world[v] = float3_add(float3_add(float3_add(float3_scale(ihat, p.x), float3_scale(jhat, p.y)), float3_scale(khat, p.z)), model->transform.position);
+    }
+
+    float3 n = model->face_normals[tri];
+    float3 normal = float3_add(float3_add(float3_scale(ihat, n.x), float3_scale(jhat, n.y)), float3_scale(khat, n.z));
+
+    bake_triangle(&cache, covered, shader, model->flat_color, uv, world, normal);
+  }
+
+  // Grow the baked area by a texel so nearest sampling along UV seams never lands on an unshaded texel
+  for (u32 y = 0; y < height; ++y) {
+    for (u32 x = 0; x < width; ++x) {
+      usize i = (usize)y * width + x;
+      if (covered[i]) continue;
+
+      if (x > 0 && covered[i - 1] == 1)               cache.texels[i] = cache.texels[i - 1];
+      else if (x + 1 < width && covered[i + 1] == 1)  cache.texels[i] = cache.texels[i + 1];
+      else if (y > 0 && covered[i - width] == 1)      cache.texels[i] = cache.texels[i - width];
+      else if (y + 1 < height && covered[i + width] == 1) cache.texels[i] = cache.texels[i + width];
+      else continue;
+
+      covered[i] = 2; // filled by this pass, not a source for its neighbours
+    }
+  }
+
+  if (arena_contains(model->arena, covered)) arena_release(model->arena, mark);
+  else sw_free(covered);
+
+  model->shading_cache = cache;
+  return 0;
+}
+
+void free_shading_cache(model_t *model) {
+  assert(model != NULL);
+
+  if (!arena_contains(model->arena, model->shading_cache.texels)) sw_free(model->shading_cache.texels);
+  model->shading_cache = (shading_cache_t){0};
+}
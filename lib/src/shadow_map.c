@@ -0,0 +1,71 @@
+#include <shader-works/shadow_map.h>
+#include <shader-works/renderer.h>
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+int init_shadow_map(shadow_map_t *map, u32 size, f32 bias) {
+  assert(map != NULL);
+  assert(size > 0);
+
+  *map = (shadow_map_t){ .size = size, .bias = bias };
+  map->depth = sw_alloc((usize)size * size * sizeof(f32), SW_MEMORY_TEXTURES);
+  if (!map->depth) return -1;
+
+  for (usize i = 0; i < (usize)size * size; ++i) map->depth[i] = FLT_MAX;
+  return 0;
+}
+
+void free_shadow_map(shadow_map_t *map) {
+  if (!map) return;
+
+  sw_free(map->depth);
+  map->depth = NULL;
+  map->size = 0;
+}
+
+void begin_shadow_map(shadow_map_t *map, const light_t *light, float3 center, f32 extent) {
+  assert(map != NULL && map->depth != NULL);
+  assert(light != NULL);
+  assert(extent > 0.0f);
+
+  map->forward = float3_normalize(light->direction);
+
+  // Any basis around forward works, world up unless the light points almost straight along it
+  float3 reference = fabsf(map->forward.y) > 0.99f ? make_float3(0, 0, 1) : make_float3(0, 1, 0);
+  map->right = float3_normalize(float3_cross(map->forward, reference));
+  map->up = float3_cross(map->right, map->forward);
+
+  map->extent = extent;
+  map->texels_per_unit = (f32)map->size / (2.0f * extent);
+
+  // Snap the centre to whole texels across the light, so shadow edges stay put while the centre follows the camera
+  f32 texel = 1.0f / map->texels_per_unit;
+  f32 along_right = floorf(float3_dot(center, map->right) / texel) * texel;
+  f32 along_up = floorf(float3_dot(center, map->up) / texel) * texel;
+  f32 along_forward = float3_dot(center, map->forward);
+  map->center = float3_add(float3_add(float3_scale(map->right, along_right), float3_scale(map->up, along_up)),
+                           float3_scale(map->forward, along_forward));
+
+  for (usize i = 0; i < (usize)map->size * map->size; ++i) map->depth[i] = FLT_MAX;
+}
+
+void set_shadow_map(renderer_t *state, const shadow_map_t *map) {
+  assert(state != NULL);
+  state->shadow_map = map;
+}
+
+bool shadow_map_occluded(const shadow_map_t *map, float3 world_pos) {
+  if (!map) return false;
+
+  float3 rel = float3_sub(world_pos, map->center);
+  f32 half = (f32)map->size * 0.5f;
+  int x = (int)floorf(half + float3_dot(rel, map->right) * map->texels_per_unit);
+  int y = (int)floorf(half - float3_dot(rel, map->up) * map->texels_per_unit);
+  if (x < 0 || y < 0 || x >= (int)map->size || y >= (int)map->size) return false;
+
+  return float3_dot(rel, map->forward) - map->bias > map->depth[y * map->size + x];
+}
@@ -0,0 +1,102 @@
+#include <shader-works/shared_mesh.h>
+#include <shader-works/memory.h>
+
+#include <assert.h>
+#include <string.h>
+
+// Models on worker threads may take and drop references
+#ifdef SHADER_WORKS_USE_PTHREADS
+#define REF_INCREMENT(count) __sync_add_and_fetch(&(count), 1)
+#define REF_DECREMENT(count) __sync_sub_and_fetch(&(count), 1)
+#else
+#define REF_INCREMENT(count) (++(count))
+#define REF_DECREMENT(count) (--(count))
+#endif
+
+// Meshes from load_shared_mesh that still have references
+static shared_mesh_t *loaded_meshes;
+
+shared_mesh_t *create_shared_mesh(model_t *model) {
+  assert(model != NULL);
+  assert(model->shared_mesh == NULL);
+
+  shared_mesh_t *mesh = sw_calloc(1, sizeof(shared_mesh_t), SW_MEMORY_OTHER);
+  if (!mesh) return NULL;
+
+  mesh->model = *model;
+  mesh->ref_count = 1;
+  *model = (model_t){0};
+  return mesh;
+}
+
+shared_mesh_t *load_shared_mesh(const char *filename, bool flip_winding) {
+  assert(filename != NULL);
+
+  for (shared_mesh_t *mesh = loaded_meshes; mesh; mesh = mesh->next) {
+    if (mesh->flip_winding == flip_winding && strcmp(mesh->path, filename) == 0) {
+      retain_shared_mesh(mesh);
+      return mesh;
+    }
+  }
+
+  usize length = strlen(filename);
+  shared_mesh_t *mesh = sw_calloc(1, sizeof(shared_mesh_t), SW_MEMORY_OTHER);
+  char *path = sw_alloc(length + 1, SW_MEMORY_OTHER);
+
+  if (!mesh || !path || load_obj_model(&mesh->model, filename, make_float3(0, 0, 0), 1.0f, flip_winding) != 0) {
+    sw_free(mesh);
+    sw_free(path);
+    return NULL;
+  }
+
+  memcpy(path, filename, length + 1);
+  mesh->path = path;
+  mesh->flip_winding = flip_winding;
+  mesh->ref_count = 1;
+  mesh->next = loaded_meshes;
+  loaded_meshes = mesh;
+  return mesh;
+}
+
+void retain_shared_mesh(shared_mesh_t *mesh) {
+  assert(mesh != NULL && mesh->ref_count > 0);
+  REF_INCREMENT(mesh->ref_count);
+}
+
+void release_shared_mesh(shared_mesh_t *mesh) {
+  if (!mesh) return;
+
+  assert(mesh->ref_count > 0);
+  if (REF_DECREMENT(mesh->ref_count) > 0) return;
+
+  if (mesh->path) {
+    shared_mesh_t **link = &loaded_meshes;
+    while (*link != mesh) link = &(*link)->next;
+    *link = mesh->next;
+  }
+
+  delete_model(&mesh->model);
+  sw_free(mesh->path);
+  sw_free(mesh);
+}
+
+void init_model_from_shared_mesh(model_t *model, shared_mesh_t *mesh) {
+  assert(model != NULL && mesh != NULL);
+  assert(model->shared_mesh == NULL && model->vertex_data == NULL);
+
+  const model_t *source = &mesh->model;
+  model->vertex_data = source->vertex_data;
+  model->face_normals = source->face_normals;
+  model->num_vertices = source->num_vertices;
+  model->num_faces = source->num_faces;
+  model->bounds_min = source->bounds_min;
+  model->bounds_max = source->bounds_max;
+  model->bounds_center = source->bounds_center;
+  model->bounds_radius = source->bounds_radius;
+  model->lods = source->lods;
+  model->num_lods = source->num_lods;
+  model->use_textures = source->use_textures;
+
+  retain_shared_mesh(mesh);
+  model->shared_mesh = mesh;
+}